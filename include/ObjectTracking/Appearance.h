@@ -0,0 +1,161 @@
+/**
+ * @desc:   appearance features for DeepSORT-style association.
+ *          every track keeps a fixed-capacity ring buffer (FeatureGallery) of its latest L2-normalized embeddings,
+ *          either as float or quantized to int8, so the memory per track is bounded by capacity x dim.
+ *          AppearanceMatcher computes the cosine distance between all detections and all track galleries in one
+ *          batch: a single GEMM over the stacked float galleries, or int8 dot products with int32 accumulation.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <ObjectTracking/BlobIO.h>
+
+namespace ObjectTracking {
+    /**
+     * @brief appearance association parameters
+     */
+    struct AppearanceParams {
+        int galleryCapacity = 16;       // embeddings kept per track
+        float iouWeight = 0.5f;         // cost = iouWeight * (1 - IoU) + (1 - iouWeight) * cosine distance
+        float maxCosineDistance = 0.3f; // assigned pairs with a larger cosine distance are rejected
+        bool quantized = false;         // keep the galleries as int8 instead of float
+    };
+
+    class FeatureGallery {
+        // variables
+    private:
+        int cap = 0, dimension = 0;
+        int count = 0, head = 0;        // stored features, next slot to write
+        bool quantized = false;
+        std::vector<float> features;                // cap x dim, used when not quantized
+        std::vector<int8_t> quantizedFeatures;      // cap x dim, used when quantized
+
+        // methods
+    public:
+        FeatureGallery();
+
+        virtual ~FeatureGallery();
+
+        /**
+         * @brief clear the gallery and (re)allocate it
+         * @param capacity  number of features kept, the oldest one is overwritten when full
+         * @param dim       feature dimension
+         * @param isQuantized store int8 features
+         */
+        void reset(int capacity, int dim, bool isQuantized);
+
+        /**
+         * @brief drop the stored features, the storage is kept
+         */
+        void clear();
+
+        /**
+         * @brief add a feature, it is L2-normalized before being stored
+         * @param feature dim values
+         */
+        void push(float const *feature);
+
+        [[nodiscard]] int size() const;
+
+        [[nodiscard]] int getCapacity() const;
+
+        [[nodiscard]] int getDim() const;
+
+        /**
+         * @return bytes of the feature storage
+         */
+        [[nodiscard]] size_t getMemoryBytes() const;
+
+        [[nodiscard]] bool isQuantized() const;
+
+        /**
+         * @brief stored float features, size() x dim rows in no particular order
+         */
+        [[nodiscard]] float const *getFeatures() const;
+
+        /**
+         * @brief stored int8 features, size() x dim rows in no particular order
+         */
+        [[nodiscard]] int8_t const *getQuantizedFeatures() const;
+
+        /**
+         * @brief serialize the gallery (configuration and stored features)
+         */
+        void save(blob::Writer &writer) const;
+
+        /**
+         * @brief restore a gallery written by save
+         * @return false on a truncated or invalid blob, the gallery is then unchanged
+         */
+        bool load(blob::Reader &reader);
+
+        /**
+         * @brief L2-normalize a vector
+         */
+        static void normalize(float const *in, float *out, int dim);
+
+        /**
+         * @brief quantize a normalized vector to int8, value = round(127 * x)
+         */
+        static void quantize(float const *in, int8_t *out, int dim);
+
+    private:
+        /**
+         * @return 1 / L2 norm of the vector, 0 for a zero vector
+         */
+        static float getNormScale(float const *in, int dim);
+    };
+
+    class AppearanceMatcher {
+        // variables
+    public:
+        using Ptr = std::shared_ptr<AppearanceMatcher>;
+    private:
+        // scratch
+        cv::Mat normalized;             // M x dim normalized detections
+        cv::Mat stacked;                // sum(gallery sizes) x dim float features
+        cv::Mat similarities;           // M x sum(gallery sizes)
+        std::vector<int8_t> quantizedDet;
+        std::vector<int> offsets;
+
+        // methods
+    public:
+        AppearanceMatcher();
+
+        virtual ~AppearanceMatcher();
+
+        /**
+         * @brief smallest cosine distance between every detection and every gallery
+         * @param embeddings detection embeddings, Mat(M, dim) CV_32F, not necessarily normalized
+         * @param galleries N track galleries, float and quantized ones may be mixed, the non-empty ones of dim
+         * @param distances output, Mat(M, N) CV_32F, 1 - max cosine similarity, 1 for empty galleries
+         * @throws std::runtime_error if a non-empty gallery has another dim than the embeddings
+         */
+        void computeDistances(cv::Mat const &embeddings, std::vector<FeatureGallery const *> const &galleries,
+                              cv::Mat &distances);
+
+        /**
+         * @return bytes of the scratch buffers
+         */
+        [[nodiscard]] size_t getMemoryBytes() const;
+
+        /**
+         * @brief free the scratch buffers, the next computation allocates what it needs
+         */
+        void shrink();
+
+    private:
+        void computeFloatDistances(std::vector<FeatureGallery const *> const &galleries, cv::Mat &distances);
+
+        void computeQuantizedDistances(std::vector<FeatureGallery const *> const &galleries, cv::Mat &distances);
+
+        /**
+         * @brief int8 dot product with int32 accumulation
+         */
+        static int32_t dot(int8_t const *a, int8_t const *b, int dim);
+    };
+}
@@ -0,0 +1,205 @@
+/**
+ * @desc:   association solver with an online cost model choosing the cheapest strategy for every cost matrix.
+ *          the strategies:
+ *              Dense       Kuhn Munkres on the whole matrix
+ *              Components  the pairs cheaper than the background cost (an IoU > 0 without appearance) split the matrix
+ *                          into independent blocks, each solved on its own (Kuhn Munkres, or a minimum for a single
+ *                          row / column); same total cost as Dense
+ *              Greedy      the pairs cheaper than the background in increasing cost order, not always optimal
+ *          the remaining rows and columns are then paired in increasing order, at the background cost, so every
+ *          strategy returns min(rows, cols) pairs as Kuhn Munkres does; which of them are paired differs between the
+ *          strategies, callers needing the same result whatever the strategy drop the pairs at the background cost.
+ *          the model keeps, per strategy and per matrix size bucket (log2 of the larger side), a running average of
+ *          the time per unit of predicted work (n^3 for a Kuhn Munkres block of side n, the matrix scan and the pair
+ *          sort). it is seeded with defaults or a calibration file written by assignmentBench --calibrate, updated
+ *          with every timed solve, and the strategies not chosen are timed again every exploreInterval solves of a
+ *          bucket so that their estimates follow the machine.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <ObjectTracking/KuhnMunkres.h>
+
+namespace ObjectTracking {
+    enum class AssignmentStrategy : int {
+        Dense = 0,
+        Components = 1,
+        Greedy = 2,
+    };
+
+    /**
+     * @brief strategies the planner may choose from
+     */
+    enum class AssignmentPolicy : int {
+        Dense = 0,          // always Kuhn Munkres on the whole matrix, no cost model
+        Exact = 1,          // Dense or Components, optimal total cost
+        Approximate = 2,    // Dense, Components or Greedy
+    };
+
+    /**
+     * @brief assignment planner parameters, see ObjectTrackerBase::setAssignmentParams
+     */
+    struct AssignmentParams {
+        AssignmentPolicy policy = AssignmentPolicy::Dense;
+        int exploreInterval = 64;   // solves of a size bucket between timings of the strategies not chosen, 0 never
+    };
+
+    class AssignmentPlanner {
+        // variables
+    public:
+        using Ptr = std::shared_ptr<AssignmentPlanner>;
+        static constexpr int numStrategies = 3;
+        static constexpr int numBuckets = 12;   // matrix sizes 1, 2-3, 4-7, ..., 2048+
+    private:
+        AssignmentParams params;
+        kuhn_munkres::KuhnMunkres km;
+        double nsPerWork[numStrategies][numBuckets];    // running estimates of the cost model
+        int numTimed[numStrategies][numBuckets];        // timings in the estimate, a plain mean over the first ones
+        int sinceTimed[numStrategies][numBuckets];      // solves of the bucket since the strategy was last timed
+        long decisions[numStrategies] = {};
+        AssignmentStrategy lastStrategy = AssignmentStrategy::Dense;
+        int lastComponents = 0;
+        // scratch of the matrix analysis and of the decomposed strategies
+        std::vector<int> parent;                // union-find over the rows, then the columns
+        std::vector<int> componentOf;           // per node, the root of its block
+        std::vector<int> componentStart;        // the block of root r at [componentStart[r], componentStart[r + 1])
+        std::vector<int> componentNodes;
+        std::vector<int> blockRows, blockCols;
+        std::vector<float> blockCost;
+        std::vector<std::pair<int, int>> blockResult;
+        std::vector<std::pair<float, int>> candidates;  // greedy: cost, row * cols + col
+        std::vector<unsigned char> rowUsed, colUsed;
+        int numNonBackground = 0;
+        double componentWork = 0;
+
+        // methods
+    public:
+        AssignmentPlanner();
+
+        virtual ~AssignmentPlanner();
+
+        AssignmentPlanner(AssignmentPlanner const &) = delete;
+
+        AssignmentPlanner &operator=(AssignmentPlanner const &) = delete;
+
+        void setParams(AssignmentParams const &assignmentParams);
+
+        [[nodiscard]] AssignmentParams const &getParams() const;
+
+        /**
+         * @brief allocate the workspace for matrices up to maxRows x maxCols, compute then never allocates
+         */
+        void reserve(int maxRows, int maxCols);
+
+        /**
+         * @return bytes of the workspace, the Kuhn Munkres one included
+         */
+        [[nodiscard]] size_t getMemoryBytes() const;
+
+        /**
+         * @brief free the workspace, the next computations allocate what they need; the cost model is kept
+         */
+        void shrink();
+
+        /**
+         * @brief minimal cost assignment with the strategy predicted cheapest among the ones of the policy
+         * @param costMatrix rows x cols costs, row-major
+         * @param background cost of the pairs that do not interact, no cost may exceed it (1 for 1 - IoU costs); a
+         *                   negative value disables the decomposed strategies, the matrix is then solved by Dense
+         * @param result output, cleared then filled with min(rows, cols) `(row, column)` pairs in increasing row order
+         * @throws kuhn_munkres::NonFiniteCostException if a cost is NaN or infinite
+         */
+        void compute(float const *costMatrix, int rows, int cols, float background,
+                     std::vector<std::pair<int, int>> &result);
+
+        /**
+         * @brief same as compute with a given strategy, timed into the cost model, e.g. for the calibration
+         */
+        void computeWith(AssignmentStrategy strategy, float const *costMatrix, int rows, int cols, float background,
+                         std::vector<std::pair<int, int>> &result);
+
+        /**
+         * @brief predicted time of a strategy for the last analyzed matrix, in nanoseconds
+         */
+        [[nodiscard]] double predictNs(AssignmentStrategy strategy, int rows, int cols) const;
+
+        /**
+         * @brief strategy of the last compute call
+         */
+        [[nodiscard]] AssignmentStrategy getLastStrategy() const;
+
+        /**
+         * @return independent blocks found in the last analyzed matrix, 0 if the last compute did not analyze it
+         */
+        [[nodiscard]] int getLastComponents() const;
+
+        /**
+         * @return number of compute calls so far that used the strategy, explorations included
+         */
+        [[nodiscard]] long getDecisionCount(AssignmentStrategy strategy) const;
+
+        /**
+         * @brief write the cost model estimates as text, to seed other planners with loadCalibration
+         * @throws std::runtime_error if the file can not be written
+         */
+        void saveCalibration(std::string const &path) const;
+
+        /**
+         * @brief replace the cost model estimates by the ones of a calibration file, the later timings update them
+         * @throws std::runtime_error if the file can not be read or is not a calibration file; the model is then
+         *         unchanged
+         */
+        void loadCalibration(std::string const &path);
+
+        /**
+         * @brief current cost model estimates, numStrategies x numBuckets values, e.g. to record them
+         */
+        void getCalibration(std::vector<double> &estimates) const;
+
+        /**
+         * @brief replace the cost model estimates, as loadCalibration does
+         * @param estimates numStrategies x numBuckets positive values, see getCalibration
+         * @throws std::runtime_error if the estimates are invalid; the model is then unchanged
+         */
+        void setCalibration(std::vector<double> const &estimates);
+
+        static char const *getStrategyName(AssignmentStrategy strategy);
+
+    private:
+        /**
+         * @brief size bucket of a matrix, log2 of its larger side
+         */
+        static int getBucket(int rows, int cols);
+
+        /**
+         * @brief predicted work of a strategy, from the sizes and the last analysis
+         */
+        [[nodiscard]] double getWork(AssignmentStrategy strategy, int rows, int cols) const;
+
+        /**
+         * @brief find the independent blocks of a matrix, also counts the pairs cheaper than the background
+         * @throws kuhn_munkres::NonFiniteCostException on a NaN or infinite cost
+         */
+        void analyze(float const *costMatrix, int rows, int cols, float background);
+
+        int findRoot(int node);
+
+        void solveDense(float const *costMatrix, int rows, int cols, std::vector<std::pair<int, int>> &result);
+
+        void solveComponents(float const *costMatrix, int rows, int cols, std::vector<std::pair<int, int>> &result);
+
+        void solveGreedy(float const *costMatrix, int rows, int cols, float background,
+                         std::vector<std::pair<int, int>> &result);
+
+        /**
+         * @brief pair the rows and columns left in increasing order up to min(rows, cols) pairs, then sort by row
+         */
+        void completeAssignment(int rows, int cols, std::vector<std::pair<int, int>> &result);
+
+        void solve(AssignmentStrategy strategy, float const *costMatrix, int rows, int cols, float background,
+                   std::vector<std::pair<int, int>> &result);
+    };
+}
@@ -0,0 +1,97 @@
+/**
+ * @desc:   asynchronous front end of ObjectTrackerT: the updates run on a dedicated tracking thread, so the caller can
+ *          already detect the next frame while the current one is tracked. frames are tracked strictly in submission
+ *          order (one worker, FIFO); the number of frames in flight is bounded, submit blocks while it is reached,
+ *          which throttles a producer faster than the tracker instead of queueing without limit.
+ *          one AsyncObjectTrackerT serves one stream, run one per stream for several streams.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <opencv2/core.hpp>
+#include <ObjectTracking/MotionModels.h>
+#include <ObjectTracking/ObjectTracker.h>
+
+namespace ObjectTracking {
+    template<class MotionModel>
+    class AsyncObjectTrackerT {
+        // variables
+    public:
+        using Ptr = std::shared_ptr<AsyncObjectTrackerT>;
+        using Tracker = ObjectTrackerT<MotionModel>;
+    private:
+        struct Job {
+            cv::Mat bboxesDet;      // own copies, the caller may reuse its buffers right after submit
+            cv::Mat embeddings;
+            std::promise<cv::Mat> result;
+        };
+
+        typename Tracker::Ptr tracker;
+        int maxInFlight;            // submitted frames not tracked yet, including the running one
+        int inFlight = 0;
+        std::deque<Job> queue;
+        std::mutex mutex;
+        std::condition_variable jobAvailable, slotFree;
+        bool stopping = false;
+        std::thread worker;
+
+        // methods
+    public:
+        /**
+         * @param tracker tracker run by the worker, configured by the caller (pre-filter, appearance, capacity, ...);
+         *                it must not be used directly while frames are in flight, except for the thread-safe
+         *                getSnapshot
+         * @param maxInFlight maximal number of submitted frames not tracked yet, >= 1; 2 overlaps the tracking of
+         *                    frame t with the detection of frame t + 1
+         */
+        explicit AsyncObjectTrackerT(typename Tracker::Ptr tracker, int maxInFlight = 2);
+
+        /**
+         * @brief tracks the frames still in flight, then stops the worker
+         */
+        virtual ~AsyncObjectTrackerT();
+
+        AsyncObjectTrackerT(AsyncObjectTrackerT const &) = delete;
+
+        AsyncObjectTrackerT &operator=(AsyncObjectTrackerT const &) = delete;
+
+        /**
+         * @brief queue a frame for tracking, blocks while maxInFlight frames are in flight
+         * @param bboxesDet detections, Mat(M, 6) [[xc,yc,w,h,score,class_id];[...];...], copied
+         * @param embeddings optional detection embeddings, see ObjectTrackerT::update(bboxesDet, embeddings), copied
+         * @return future of the update output, Mat(N, 9) [[xc,yc,w,h,score,class_id,dx,dy,tracker_id];[...];...],
+         *         always an own matrix (also in the fixed-capacity mode); it holds the exception if update throws
+         */
+        std::future<cv::Mat> submit(cv::Mat const &bboxesDet, cv::Mat const &embeddings = cv::Mat());
+
+        /**
+         * @brief block until all the submitted frames are tracked; the tracker may then be used directly until the
+         *        next submit
+         */
+        void flush();
+
+        /**
+         * @return number of submitted frames not tracked yet
+         */
+        [[nodiscard]] int getInFlight();
+
+        [[nodiscard]] typename Tracker::Ptr const &getTracker() const;
+
+    private:
+        void run();
+    };
+
+    using AsyncObjectTracker = AsyncObjectTrackerT<ConstantVelocityModel>;
+
+    extern template class AsyncObjectTrackerT<ConstantVelocityModel>;
+
+    extern template class AsyncObjectTrackerT<ConstantAccelerationModel>;
+
+    extern template class AsyncObjectTrackerT<XywhVelocityModel>;
+}
@@ -0,0 +1,70 @@
+/**
+ * @desc:   minimal binary blob writer / reader for the tracker state serialization.
+ *          values are trivially copyable types stored as raw bytes in native endianness.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace ObjectTracking::blob {
+    class Writer {
+        // variables
+    private:
+        std::vector<uint8_t> &out;
+
+        // methods
+    public:
+        /**
+         * @param out output blob, appended to
+         */
+        explicit Writer(std::vector<uint8_t> &out) : out(out) {}
+
+        template<typename T>
+        void put(T const &value) {
+            static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable values can be written");
+            putBytes(&value, sizeof(T));
+        }
+
+        void putBytes(void const *data, size_t bytes) {
+            auto const *begin = static_cast<uint8_t const *>(data);
+            out.insert(out.end(), begin, begin + bytes);
+        }
+    };
+
+    class Reader {
+        // variables
+    private:
+        uint8_t const *current;
+        uint8_t const *end;
+
+        // methods
+    public:
+        Reader(uint8_t const *data, size_t bytes) : current(data), end(data + bytes) {}
+
+        /**
+         * @return false if the blob is too short, value is then unchanged
+         */
+        template<typename T>
+        bool get(T &value) {
+            static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable values can be read");
+            return getBytes(&value, sizeof(T));
+        }
+
+        bool getBytes(void *data, size_t bytes) {
+            if ((size_t) (end - current) < bytes) {
+                return false;
+            }
+            std::memcpy(data, current, bytes);
+            current += bytes;
+            return true;
+        }
+
+        [[nodiscard]] bool atEnd() const {
+            return current == end;
+        }
+    };
+}
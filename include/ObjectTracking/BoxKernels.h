@@ -0,0 +1,99 @@
+/**
+ * @desc:   box overlap kernels shared by the association and the detection pre-filter.
+ *          boxes are converted once to integer corners (same truncation as cv::Rect(int(xc - w/2), int(yc - h/2),
+ *          int(w), int(h))) and stored column-wise, so the one-to-many IoU is a branch-free loop over contiguous
+ *          arrays that the compiler vectorizes.
+ *          the IoU is the one SORT uses in this repo: intersection area over the area of the enclosing box
+ *          (cv::Rect operator&, operator|).
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <vector>
+#include <opencv2/core.hpp>
+
+namespace ObjectTracking::box_kernels {
+    /**
+     * @brief boxes as integer corners, structure of arrays
+     */
+    struct BoxSet {
+        std::vector<float> x1, y1, x2, y2;
+
+        void clear() {
+            x1.clear();
+            y1.clear();
+            x2.clear();
+            y2.clear();
+        }
+
+        void reserve(size_t n) {
+            x1.reserve(n);
+            y1.reserve(n);
+            x2.reserve(n);
+            y2.reserve(n);
+        }
+
+        [[nodiscard]] int size() const {
+            return (int) x1.size();
+        }
+
+        /**
+         * @param bbox [xc, yc, w, h, ...]
+         */
+        void push_back(float const *bbox) {
+            auto left = float(int(bbox[0] - bbox[2] / 2.0)), top = float(int(bbox[1] - bbox[3] / 2.0));
+            x1.push_back(left);
+            y1.push_back(top);
+            x2.push_back(left + float(int(bbox[2])));
+            y2.push_back(top + float(int(bbox[3])));
+        }
+
+        /**
+         * @param bboxes Mat(N, 4+) [[xc, yc, w, h, ...];[...];...]
+         */
+        void assign(cv::Mat const &bboxes) {
+            assert(bboxes.rows == 0 || (bboxes.cols >= 4 && bboxes.type() == CV_32F));
+            clear();
+            reserve(bboxes.rows);
+            for (int i = 0; i < bboxes.rows; ++i) {
+                push_back(bboxes.ptr<float>(i));
+            }
+        }
+    };
+
+    /**
+     * @brief IoU of two boxes given by their integer corners
+     */
+    inline float iou(float ax1, float ay1, float ax2, float ay2, float bx1, float by1, float bx2, float by2) {
+        float iw = std::max(std::min(ax2, bx2) - std::max(ax1, bx1), 0.0f);
+        float ih = std::max(std::min(ay2, by2) - std::max(ay1, by1), 0.0f);
+        float inter = iw * ih;
+        // enclosing box, an empty box does not contribute to it
+        bool aEmpty = ax2 <= ax1 || ay2 <= ay1, bEmpty = bx2 <= bx1 || by2 <= by1;
+        float enclosing = (std::max(ax2, bx2) - std::min(ax1, bx1)) * (std::max(ay2, by2) - std::min(ay1, by1));
+        float uni = aEmpty ? (bx2 - bx1) * (by2 - by1) : (bEmpty ? (ax2 - ax1) * (ay2 - ay1) : enclosing);
+        return inter / (uni + FLT_EPSILON);
+    }
+
+    /**
+     * @brief IoU of box i of a with box j of b
+     */
+    inline float iou(BoxSet const &a, int i, BoxSet const &b, int j) {
+        return iou(a.x1[i], a.y1[i], a.x2[i], a.y2[i], b.x1[j], b.y1[j], b.x2[j], b.y2[j]);
+    }
+
+    /**
+     * @brief IoU of box i of a with the boxes [begin, end) of b
+     * @param out output, out[j - begin] = IoU(a(i), b(j))
+     */
+    inline void iouOneToMany(BoxSet const &a, int i, BoxSet const &b, int begin, int end, float *out) {
+        float ax1 = a.x1[i], ay1 = a.y1[i], ax2 = a.x2[i], ay2 = a.y2[i];
+        float const *bx1 = b.x1.data(), *by1 = b.y1.data(), *bx2 = b.x2.data(), *by2 = b.y2.data();
+        for (int j = begin; j < end; ++j) {
+            out[j - begin] = iou(ax1, ay1, ax2, ay2, bx1[j], by1[j], bx2[j], by2[j]);
+        }
+    }
+}
@@ -0,0 +1,114 @@
+/**
+ * @desc:   detection pre-processing run before the association: score threshold, static ROI / exclusion masks
+ *          and (class-aware) non-maximum suppression.
+ *          all the stages work column-wise on the detections and the NMS uses the same box kernel as the
+ *          association IoU (BoxKernels.h), so duplicates are removed with the metric the tracker would match them with.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <ObjectTracking/BoxKernels.h>
+
+namespace ObjectTracking {
+    class DetectionPreFilter {
+        // variables
+    public:
+        using Ptr = std::shared_ptr<DetectionPreFilter>;
+    private:
+        float scoreThresh;      // detections with a lower score are dropped
+        float nmsIouThresh;     // a detection overlapping a higher scored one by more than this is dropped
+        bool classAware;        // only detections of the same class suppress each other
+        std::vector<cv::Rect2f> rois;           // if any, detection centers must lie in one of them
+        std::vector<cv::Rect2f> exclusions;     // detection centers must not lie in any of them
+        cv::Mat roiMask;        // if not empty, CV_8U, detection centers must lie on a non-zero pixel
+
+        // scratch
+        std::vector<float> xc, yc, score, classId;
+        std::vector<unsigned char> keep, inRoi, alive;
+        std::vector<int> order;
+        std::vector<float> sortedClassId, ious;
+        box_kernels::BoxSet boxes;
+
+        // methods
+    public:
+        /**
+         * @brief detection pre-filter, every stage is disabled by default
+         * @param scoreThresh   minimal detection score
+         * @param nmsIouThresh  NMS IoU threshold, >= 1 disables the NMS
+         * @param classAware    NMS only between detections of the same class
+         */
+        explicit DetectionPreFilter(float scoreThresh = -FLT_MAX, float nmsIouThresh = 1.0f, bool classAware = true);
+
+        virtual ~DetectionPreFilter();
+
+        DetectionPreFilter(DetectionPreFilter const &) = delete;
+
+        DetectionPreFilter &operator=(DetectionPreFilter const &) = delete;
+
+        /**
+         * @brief filter the detections
+         * @param bboxesDet detections, Mat(M, 6) with the format [[xc,yc,w,h,score,class_id];[...];...]
+         * @param bboxesOut output, kept detections in their original order, Mat(K, 6), must not share data with
+         *                  bboxesDet
+         * @param keptIndices optional output, row index in bboxesDet of every kept detection
+         */
+        void apply(cv::Mat const &bboxesDet, cv::Mat &bboxesOut, std::vector<int> *keptIndices = nullptr);
+
+        /**
+         * @brief filter the detections without copying them
+         * @param bboxesDet detections, Mat(M, 6) with the format [[xc,yc,w,h,score,class_id];[...];...]
+         * @param keptIndices output, row index in bboxesDet of every kept detection, in increasing order
+         */
+        void select(cv::Mat const &bboxesDet, std::vector<int> &keptIndices);
+
+        /**
+         * @brief allocate the scratch for up to maxDetections detections, filtering them then never allocates
+         */
+        void reserve(int maxDetections);
+
+        void setScoreThresh(float thresh);
+
+        void setNmsIouThresh(float thresh, bool isClassAware = true);
+
+        [[nodiscard]] float getScoreThresh() const;
+
+        [[nodiscard]] float getNmsIouThresh() const;
+
+        [[nodiscard]] bool isClassAware() const;
+
+        /**
+         * @brief add a region of interest, once any is set detections with their center outside all of them are dropped
+         */
+        void addRoi(cv::Rect2f const &roi);
+
+        /**
+         * @brief add an exclusion zone, detections with their center inside it are dropped
+         */
+        void addExclusion(cv::Rect2f const &zone);
+
+        /**
+         * @brief set a static ROI mask in image coordinates
+         * @param mask CV_8U image, detections whose center lies outside it or on a zero pixel are dropped;
+         *             an empty Mat removes the mask
+         */
+        void setRoiMask(cv::Mat const &mask);
+
+        void clearMasks();
+
+    private:
+        /**
+         * @brief run all the stages, the result is in keep
+         * @param bboxesDet detections, Mat(M, 6)
+         */
+        void filter(cv::Mat const &bboxesDet);
+
+        /**
+         * @brief greedy NMS over the kept detections, in decreasing score order
+         * @param bboxesDet detections, Mat(M, 6)
+         */
+        void suppress(cv::Mat const &bboxesDet);
+    };
+}
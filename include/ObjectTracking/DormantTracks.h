@@ -0,0 +1,134 @@
+/**
+ * @desc:   dormant tier for long-term re-association. a confirmed track removed by the tracker (maxAge exceeded) is
+ *          kept here for a while as a compact quantized record (last corrected box, center velocity, class, frame)
+ *          instead of a full Kalman tracker, so it takes no part in the main assignment. after the assignment the
+ *          unmatched detections are checked against the dormant tracks, each extrapolated at constant velocity to
+ *          the current frame, through a spatial lookup; a revived track gets its original id back.
+ *          records are indexed in a SpatialGrid by the region swept during their dormancy, or scanned linearly when
+ *          the store is not indexed (fixed-capacity trackers).
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <ObjectTracking/FlatIdMap.h>
+#include <ObjectTracking/SpatialGrid.h>
+
+namespace ObjectTracking {
+    /**
+     * @brief dormant tier parameters, see ObjectTrackerBase::setDormantParams
+     */
+    struct DormantParams {
+        int maxDormantAge = 0;      // frames a removed track can be revived after its last match, 0 disables the tier
+        float iouThresh = 0.3f;     // minimal IoU between a detection and the extrapolated dormant box
+        bool classAware = true;     // only revive with a detection of the same class
+    };
+
+    /**
+     * @brief quantized dormant record, 24 bytes. positions and sizes in 1/2 pixel, velocities in 1/64 pixel per frame
+     */
+    struct DormantTrack {
+        int32_t trackerId;
+        int32_t lastFrame;          // frame of the last match
+        int16_t xc, yc;
+        uint16_t w, h;
+        int16_t dx, dy;
+        int16_t classId;
+        int16_t reserved = 0;
+    };
+
+    class DormantTrackStore {
+        // variables
+    private:
+        DormantParams params;
+        size_t capacity = 0;        // maximal number of records, 0 unbounded; the oldest one is evicted when full
+        bool indexed = true;
+        std::vector<DormantTrack> tracks;
+        FlatIdMap<int> indexById;   // tracker id -> index in tracks
+        SpatialGrid sweptIndex;     // tracker id -> region swept by the extrapolated box until expiry
+        std::vector<int> candidateIds;  // scratch
+
+        // methods
+    public:
+        DormantTrackStore();
+
+        virtual ~DormantTrackStore();
+
+        DormantTrackStore(DormantTrackStore const &) = delete;
+
+        DormantTrackStore &operator=(DormantTrackStore const &) = delete;
+
+        /**
+         * @brief set the parameters, the stored records are dropped
+         */
+        void setParams(DormantParams const &dormantParams);
+
+        [[nodiscard]] DormantParams const &getParams() const;
+
+        /**
+         * @brief bound the store and allocate it, without the spatial index; adding and reviving then never allocate
+         * @param maxTracks maximal number of records
+         */
+        void reserveFixed(int maxTracks);
+
+        /**
+         * @brief add the record of a removed track
+         * @param lastFrame frame of its last match
+         * @param bbox last corrected box [xc, yc, w, h]
+         * @param velocity center velocity in pixels per frame
+         */
+        void add(int trackerId, int lastFrame, cv::Vec4f const &bbox, cv::Vec2f const &velocity, float classId);
+
+        /**
+         * @brief drop the records not revivable anymore at a frame
+         */
+        void expire(int frame);
+
+        /**
+         * @brief dormant records that may overlap a detection
+         * @param bbox detection [xc, yc, w, h, ...]
+         * @param indices output, cleared then filled with record indices
+         */
+        void findCandidates(float const *bbox, std::vector<int> &indices);
+
+        /**
+         * @brief IoU of a detection with a record extrapolated to a frame, 0 if their classes differ in the class
+         *        aware mode. same integer box IoU as the association.
+         * @param bbox detection [xc, yc, w, h, score, class_id]
+         */
+        [[nodiscard]] float getIou(int index, float const *bbox, int frame) const;
+
+        [[nodiscard]] DormantTrack const &get(int index) const;
+
+        /**
+         * @brief remove records, e.g. the revived ones; the indices of the other records change
+         * @param trackerIds tracker ids of the records
+         */
+        void remove(std::vector<int> const &trackerIds);
+
+        void clear();
+
+        [[nodiscard]] int size() const;
+
+        /**
+         * @return bytes of the records, their indices and scratch
+         */
+        [[nodiscard]] size_t getMemoryBytes() const;
+
+        /**
+         * @brief dequantized box of a record extrapolated to a frame
+         * @return [xc, yc, w, h]
+         */
+        static cv::Vec4f extrapolate(DormantTrack const &track, int frame);
+
+    private:
+        void removeAt(int index);
+
+        /**
+         * @brief region covered by the extrapolated box from the last match until the record expires
+         */
+        [[nodiscard]] cv::Rect2f getSweptRegion(DormantTrack const &track) const;
+    };
+}
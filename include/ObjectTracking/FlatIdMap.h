@@ -0,0 +1,186 @@
+/**
+ * @desc:   open addressing hash map from non-negative ids (tracker ids) to values, stored in flat arrays.
+ *          linear probing with backward shift deletion, so erasing never leaves tombstones: once reserved for the
+ *          maximal number of ids, inserting, erasing and clearing never touch the heap.
+ */
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ObjectTracking {
+    template<typename T>
+    class FlatIdMap {
+        // variables
+    private:
+        static constexpr int EMPTY = -1;
+
+        std::vector<int> keys;      // EMPTY or id, size is a power of two
+        std::vector<T> values;
+        size_t count = 0;
+
+        // methods
+    public:
+        FlatIdMap() = default;
+
+        /**
+         * @brief make room for n ids without rehashing
+         */
+        void reserve(size_t n) {
+            size_t capacity = 8;
+            while (capacity < 2 * n) {
+                capacity *= 2;
+            }
+            if (capacity > keys.size()) {
+                rehash(capacity);
+            }
+        }
+
+        /**
+         * @brief release the storage beyond what the stored ids need
+         */
+        void shrink() {
+            size_t capacity = 8;
+            while (capacity < 2 * count) {
+                capacity *= 2;
+            }
+            if (capacity < keys.size()) {
+                rehash(capacity);
+            }
+        }
+
+        void clear() {
+            if (count > 0) {
+                std::fill(keys.begin(), keys.end(), EMPTY);
+                count = 0;
+            }
+        }
+
+        [[nodiscard]] size_t size() const {
+            return count;
+        }
+
+        [[nodiscard]] bool empty() const {
+            return count == 0;
+        }
+
+        /**
+         * @return bytes of the key and value arrays, not of the storage owned by the values
+         */
+        [[nodiscard]] size_t getMemoryBytes() const {
+            return keys.capacity() * sizeof(int) + values.capacity() * sizeof(T);
+        }
+
+        /**
+         * @return value of the id, nullptr if absent
+         */
+        T *find(int key) {
+            return const_cast<T *>(static_cast<FlatIdMap const *>(this)->find(key));
+        }
+
+        T const *find(int key) const {
+            if (count == 0) {
+                return nullptr;
+            }
+            for (size_t i = getHome(key);; i = (i + 1) & getMask()) {
+                if (keys[i] == key) {
+                    return &values[i];
+                }
+                if (keys[i] == EMPTY) {
+                    return nullptr;
+                }
+            }
+        }
+
+        T &at(int key) {
+            T *value = find(key);
+            assert(value != nullptr);
+            return *value;
+        }
+
+        T const &at(int key) const {
+            T const *value = find(key);
+            assert(value != nullptr);
+            return *value;
+        }
+
+        /**
+         * @brief value of the id, default-constructed and inserted if absent
+         */
+        T &operator[](int key) {
+            assert(key >= 0);
+            // only an insertion may grow the table, a map holding the reserved number of ids is full
+            T *value = find(key);
+            if (value != nullptr) {
+                return *value;
+            }
+            if (2 * (count + 1) > keys.size()) {
+                rehash(keys.empty() ? 8 : 2 * keys.size());
+            }
+            size_t i = getHome(key);
+            while (keys[i] != EMPTY && keys[i] != key) {
+                i = (i + 1) & getMask();
+            }
+            if (keys[i] == EMPTY) {
+                keys[i] = key;
+                values[i] = T();
+                count++;
+            }
+            return values[i];
+        }
+
+        /**
+         * @return whether the id was present
+         */
+        bool erase(int key) {
+            if (count == 0) {
+                return false;
+            }
+            size_t i = getHome(key);
+            while (keys[i] != key) {
+                if (keys[i] == EMPTY) {
+                    return false;
+                }
+                i = (i + 1) & getMask();
+            }
+            // backward shift: move up the following entries of the probe run that may not stay behind the hole
+            for (size_t j = (i + 1) & getMask(); keys[j] != EMPTY; j = (j + 1) & getMask()) {
+                size_t home = getHome(keys[j]);
+                bool between = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+                if (!between) {
+                    keys[i] = keys[j];
+                    values[i] = std::move(values[j]);
+                    i = j;
+                }
+            }
+            keys[i] = EMPTY;
+            count--;
+            return true;
+        }
+
+    private:
+        [[nodiscard]] size_t getMask() const {
+            return keys.size() - 1;
+        }
+
+        [[nodiscard]] size_t getHome(int key) const {
+            return (size_t) ((uint32_t) key * 2654435769u) & getMask();
+        }
+
+        void rehash(size_t capacity) {
+            std::vector<int> oldKeys(capacity, EMPTY);
+            std::vector<T> oldValues(capacity);
+            oldKeys.swap(keys);
+            oldValues.swap(values);
+            count = 0;
+            for (size_t i = 0; i < oldKeys.size(); ++i) {
+                if (oldKeys[i] != EMPTY) {
+                    (*this)[oldKeys[i]] = std::move(oldValues[i]);
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,72 @@
+/**
+ * @desc:   batched Kalman predict and correct steps over many KalmanBoxTrackerT of one motion model, e.g. the trackers
+ *          of all the streams of a MultiStreamTrackerT. the trackers are processed in blocks of LANES: their states and
+ *          covariances are gathered into structure-of-arrays tiles on the stack, element e of tracker l at [e][l], so
+ *          every step of the filter is a loop over the lanes of a block with a fixed trip count that the compiler
+ *          vectorizes; the zero entries of the constant model matrices F and H are skipped. the results are scattered
+ *          back to the trackers with the same bookkeeping as KalmanBoxTrackerT::predict / update, and match them up to
+ *          float rounding.
+ */
+
+#pragma once
+
+#include <memory>
+#include <ObjectTracking/KalmanBoxTracker.h>
+
+namespace ObjectTracking {
+    template<class MotionModel>
+    class KalmanBatchT {
+        // variables
+    public:
+        using Ptr = std::shared_ptr<KalmanBatchT>;
+        using Tracker = KalmanBoxTrackerT<MotionModel>;
+        static constexpr int dimX = MotionModel::dimX;
+        static constexpr int dimZ = MotionModel::dimZ;
+        static constexpr int LANES = 8;     // trackers per block, a vector register of floats or two
+    private:
+        typename MotionModel::StateMat F;
+        typename MotionModel::MeasMat H;
+
+        // methods
+    public:
+        KalmanBatchT();
+
+        virtual ~KalmanBatchT();
+
+        KalmanBatchT(KalmanBatchT const &) = delete;
+
+        KalmanBatchT &operator=(KalmanBatchT const &) = delete;
+
+        /**
+         * @brief predict step of every tracker, same as calling KalmanBoxTrackerT::predict on each
+         * @param trackers trackers, all distinct
+         * @param count number of trackers
+         */
+        void predict(Tracker *const *trackers, int count);
+
+        /**
+         * @brief correction step of every tracker with its detection, same as calling KalmanBoxTrackerT::update on each
+         * @param trackers trackers, all distinct and predicted
+         * @param bboxes detection of each tracker [xc, yc, w, h, ...]
+         * @param count number of trackers
+         */
+        void update(Tracker *const *trackers, float const *const *bboxes, int count);
+
+    private:
+        /**
+         * @param count trackers in the block, 1 to LANES
+         */
+        void predictBlock(Tracker *const *trackers, int count);
+
+        /**
+         * @param count trackers in the block, 1 to LANES
+         */
+        void updateBlock(Tracker *const *trackers, float const *const *bboxes, int count);
+    };
+
+    extern template class KalmanBatchT<ConstantVelocityModel>;
+
+    extern template class KalmanBatchT<ConstantAccelerationModel>;
+
+    extern template class KalmanBatchT<XywhVelocityModel>;
+}
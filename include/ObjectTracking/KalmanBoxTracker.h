@@ -1,35 +1,110 @@
 /**
  * @desc:   kalmanfilter for boundary box tracking.
- *          opencv kalmanfilter documents:
+ *          the filter is parameterized by a motion model policy (see MotionModels.h), so the state and
+ *          measurement sizes are known at compile time and all the filter math runs on fixed-size cv::Matx.
+ *          reference (same equations as cv::KalmanFilter):
  *              https://docs.opencv.org/4.x/dd/d6a/classcv_1_1KalmanFilter.html
- * 
+ *
  * @author: lst
  * @date:   12/10/2021
  */
 
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <cmath>
 #include <memory>
 #include <opencv2/video/tracking.hpp>
 #include <opencv2/highgui/highgui.hpp>
-
-#define KF_DIM_X 7      // xc, yc, s, r, dxc/dt, dyc/dt, ds/dt
-#define KF_DIM_Z 4      // xc, yc, s, r
+#include <ObjectTracking/Appearance.h>
+#include <ObjectTracking/MotionModels.h>
+#include <ObjectTracking/Trajectory.h>
 
 namespace ObjectTracking {
-    class KalmanBoxTracker {
+    /**
+     * @brief motion model independent part of the box tracker: identity and match bookkeeping.
+     *        the id counter is shared by all motion models and trackers may be created from several threads.
+     */
+    class KalmanBoxTrackerBase {
         // variables
-    public:
-        using Ptr = std::shared_ptr<KalmanBoxTracker>;
-    private:
-        static int count;
+    protected:
+        static std::atomic<int> count;
         int id;
         int timeSinceUpdate = 0;
         int hitStreak = 0;
-        std::shared_ptr<cv::KalmanFilter> kf = nullptr;
-        cv::Mat xPost;
+        FeatureGallery gallery;     // appearance embeddings, empty unless the tracker is fed embeddings
+        TrajectoryBuffer trajectory;    // latest corrected boxes, empty unless the history is enabled
+
+        // methods
+    public:
+        virtual ~KalmanBoxTrackerBase();
+
+        KalmanBoxTrackerBase(KalmanBoxTrackerBase const &) = delete;
+
+        void operator=(KalmanBoxTrackerBase const &) = delete;
+
+        static int getFilterCount();
+
+        /**
+         * @brief set the id of the next created tracker, e.g. to replay a recorded session with the same ids
+         */
+        static void setFilterCount(int value);
+
+        [[nodiscard]] int getFilterId() const;
+
+        [[nodiscard]] int getTimeSinceUpdate() const;
+
+        [[nodiscard]] int getHitStreak() const;
+
+        FeatureGallery &getGallery();
+
+        [[nodiscard]] FeatureGallery const &getGallery() const;
+
+        TrajectoryBuffer &getTrajectory();
+
+        [[nodiscard]] TrajectoryBuffer const &getTrajectory() const;
+
+    protected:
+        KalmanBoxTrackerBase();
+
+        /**
+         * @brief tracker with a given id and match counters, the id counter is not changed
+         */
+        KalmanBoxTrackerBase(int id, int timeSinceUpdate, int hitStreak);
+
+        /**
+         * @brief take the next id and clear the match counters, the gallery and the trajectory, as a new tracker
+         */
+        void resetIdentity();
+
+        /**
+         * @brief take a given id, e.g. of a revived track, and clear the gallery and the trajectory; the id counter
+         *        is not changed
+         */
+        void resetIdentity(int trackerId, int initialHitStreak);
+    };
+
+    template<class MotionModel>
+    class KalmanBoxTrackerT : public KalmanBoxTrackerBase {
+        // variables
+    public:
+        using Ptr = std::shared_ptr<KalmanBoxTrackerT>;
+        using Model = MotionModel;
+        using StateVec = typename MotionModel::StateVec;
+        using StateMat = typename MotionModel::StateMat;
+        using MeasVec = typename MotionModel::MeasVec;
+        using MeasMat = typename MotionModel::MeasMat;
+        using MeasCovMat = typename MotionModel::MeasCovMat;
+        using GainMat = cv::Matx<float, MotionModel::dimX, MotionModel::dimZ>;
+    private:
+        // state transition matrix (F) and measurement matrix (H) are constant for a model
+        static inline StateMat const F = MotionModel::transitionMatrix();
+        static inline MeasMat const H = MotionModel::measurementMatrix();
+
+        StateVec x;         // current state, x'(k) after predict, x(k) after update
+        StateMat P;         // current error covariance, P'(k) after predict, P(k) after update
+        StateVec xPost;     // last corrected state
 
         // methods
     public:
@@ -37,51 +112,113 @@ namespace ObjectTracking {
          * @brief Kalman filter for bbox tracking
          * @param bbox bounding box, Mat(1, 4+) [xc, yc, w, h, ...]
          */
-        explicit KalmanBoxTracker(cv::Mat const &bbox);
+        explicit KalmanBoxTrackerT(cv::Mat const &bbox);
 
-        virtual ~KalmanBoxTracker();
+        /**
+         * @brief tracker restored from a saved state, it keeps its id
+         * @param x current state, @param P current error covariance, @param xPost last corrected state
+         */
+        KalmanBoxTrackerT(int id, StateVec const &x, StateMat const &P, StateVec const &xPost, int timeSinceUpdate,
+                          int hitStreak);
+
+        ~KalmanBoxTrackerT() override;
 
-        KalmanBoxTracker(KalmanBoxTracker const &) = delete;
+        /**
+         * @brief reinitialize a pooled tracker in place, same as constructing KalmanBoxTrackerT(bbox) (new id)
+         * @param bbox bounding box, Mat(1, 4+) [xc, yc, w, h, ...]
+         */
+        void reset(cv::Mat const &bbox);
 
-        void operator=(KalmanBoxTracker const &) = delete;
+        /**
+         * @brief reinitialize the tracker in place on a detection with a given id, e.g. a revived dormant track
+         * @param bbox bounding box, Mat(1, 4+) [xc, yc, w, h, ...]
+         * @param initialHitStreak hit streak before the first update
+         */
+        void reset(cv::Mat const &bbox, int trackerId, int initialHitStreak);
 
         /**
-         * @brief updates the state vector with observed bbox. 
+         * @brief updates the state vector with observed bbox.
          * @param bbox  boundary box, Mat(1, 4+) [xc, yc, w, h, ...]
-         * @return corrected bounding box estimate, Mat(1, 4)
+         * @return corrected bounding box estimate [xc, yc, w, h]
          */
-        cv::Mat update(cv::Mat const &bbox);
+        cv::Vec4f update(cv::Mat const &bbox);
 
         /**
-         * @brief advances the state vector and returns the predicted bounding box estimate. 
-         * @return predicted bounding box, Mat(1, 4)
+         * @brief advances the state vector and returns the predicted bounding box estimate.
+         * @return predicted bounding box [xc, yc, w, h]
          */
-        cv::Mat predict();
+        cv::Vec4f predict();
 
-        static int getFilterCount();
+        /**
+         * @brief take the result of a predict step computed outside of the tracker, e.g. by KalmanBatchT, with the
+         *        same match counter bookkeeping as predict
+         * @param xPred x'(k) = F*x(k-1) of the constrained state, @param PPred P'(k) = F*P(k-1)*Ft + Q
+         */
+        void setPredicted(StateVec const &xPred, StateMat const &PPred);
 
-        [[nodiscard]] int getFilterId() const;
+        /**
+         * @brief take the result of an update step computed outside of the tracker, e.g. by KalmanBatchT, with the
+         *        same match counter bookkeeping as update
+         * @param xCorr corrected state x(k), @param PCorr corrected error covariance P(k)
+         */
+        void setCorrected(StateVec const &xCorr, StateMat const &PCorr);
 
-        [[nodiscard]] int getTimeSinceUpdate() const;
+        /**
+         * @brief velocity of the box center in the last corrected state
+         * @return [dxc/dt, dyc/dt]
+         */
+        [[nodiscard]] cv::Vec2f getVelocity() const;
 
-        [[nodiscard]] int getHitStreak() const;
+        /**
+         * @brief bounding box of the current state, the prediction after predict, the correction after update
+         * @return [xc, yc, w, h]
+         */
+        [[nodiscard]] cv::Vec4f getBBox() const;
 
-        cv::Mat getState();
+        /**
+         * @brief last corrected state vector
+         */
+        [[nodiscard]] StateVec const &getState() const;
 
-    private:
         /**
-         * @brief convert boundary box to measurement.
-         * @param bbox boundary box (1, 4+) [x center, y center, width, height, ...]
-         * @return measurement vector (4, 1) [x center; y center; scale/area; aspect ratio]
+         * @return bytes of the tracker: the object and the storage of its gallery and trajectory
+         */
+        [[nodiscard]] size_t getMemoryBytes() const;
+
+        /**
+         * @brief current state vector, x'(k) after predict, x(k) after update
+         */
+        [[nodiscard]] StateVec const &getCurrentState() const;
+
+        /**
+         * @brief current error covariance, P'(k) after predict, P(k) after update
          */
-        static cv::Mat convertBBoxToZ(cv::Mat const &bbox);
+        [[nodiscard]] StateMat const &getErrorCov() const;
 
         /**
-         * @brief convert state vector to boundary box.
-         * @param state state vector (7, 1) (x center; y center; scale/area; aspect ratio; ...)
-         * @return boundary box (1, 4) [x center, y center, width, height]
+         * @brief Rauch-Tung-Striebel backward pass with the model of this filter over one track, offline
+         * @param x filtered states of consecutive frames (the state after each tracker update, corrected or only
+         *          predicted), replaced by the smoothed states
+         * @param P filtered error covariances of the same frames
+         * @param count number of frames
          */
-        static cv::Mat convertXToBBox(cv::Mat const &state);
+        static void smooth(StateVec *x, StateMat const *P, int count);
+
+    private:
+        /**
+         * @brief read a boundary box row.
+         * @param bbox boundary box (1, 4+) [x center, y center, width, height, ...]
+         * @return [x center, y center, width, height]
+         */
+        static cv::Vec4f readBBox(cv::Mat const &bbox);
     };
+
+    using KalmanBoxTracker = KalmanBoxTrackerT<ConstantVelocityModel>;
+
+    extern template class KalmanBoxTrackerT<ConstantVelocityModel>;
+
+    extern template class KalmanBoxTrackerT<ConstantAccelerationModel>;
+
+    extern template class KalmanBoxTrackerT<XywhVelocityModel>;
 }
 
@@ -0,0 +1,65 @@
+/**
+ * @desc:   tracker input from pose estimation: the bounding box of the detected joints of every person.
+ *          all the persons of a frame come in one flat keypoint buffer (the OpenPose layout, person x joint x
+ *          [x, y, confidence]); the joint extents are branch-free min / max reductions over each person, with the
+ *          missing joints masked out, and the boxes are written straight into a detection buffer that is only grown,
+ *          so the converter does not allocate once it has seen its largest frame.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <opencv2/core.hpp>
+
+namespace ObjectTracking {
+    class KeypointBoxConverter {
+        // variables
+    public:
+        using Ptr = std::shared_ptr<KeypointBoxConverter>;
+    private:
+        float minConfidence;    // joints with a lower confidence, or at (0, 0), are missing
+        int minKeypoints;       // persons with fewer detected joints give no box
+        float padding;          // box margin on every side, relative to the joint extent
+        cv::Mat bboxesBuffer;   // detection rows [xc, yc, w, h, score, class_id], only grown
+        std::vector<int> personIndices;     // person of every output row
+
+        // methods
+    public:
+        /**
+         * @param minConfidence minimal joint confidence
+         * @param minKeypoints  minimal number of detected joints of a person, at least 1
+         * @param padding       margin added on every side of the joint extent, relative to its width / height
+         */
+        explicit KeypointBoxConverter(float minConfidence = 0.05f, int minKeypoints = 2, float padding = 0.0f);
+
+        virtual ~KeypointBoxConverter();
+
+        KeypointBoxConverter(KeypointBoxConverter const &) = delete;
+
+        KeypointBoxConverter &operator=(KeypointBoxConverter const &) = delete;
+
+        /**
+         * @brief bounding boxes of all the persons of a frame
+         * @param keypoints numPersons x numJoints x [x, y, confidence], row-major; missing joints have a confidence
+         *                  below minConfidence or lie at (0, 0)
+         * @param scores    optional score of every person, nullptr uses the mean confidence of its detected joints
+         * @param classId   class_id of the boxes
+         * @return detections for ObjectTrackerT::update, Mat(K, 6) [[xc,yc,w,h,score,class_id];[...];...], one row per
+         *         person with enough detected joints, in person order. it is a view of an internal buffer,
+         *         overwritten by the next convert.
+         */
+        cv::Mat convert(float const *keypoints, int numPersons, int numJoints, float const *scores = nullptr,
+                        float classId = 0);
+
+        /**
+         * @brief person index of every row of the last convert output
+         */
+        [[nodiscard]] std::vector<int> const &getPersonIndices() const;
+
+        /**
+         * @brief allocate the buffers for up to maxPersons persons per frame
+         */
+        void reserve(int maxPersons);
+    };
+}
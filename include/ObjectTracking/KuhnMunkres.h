@@ -29,6 +29,12 @@ namespace ObjectTracking::kuhn_munkres {
         }
     };
 
+    class NonFiniteCostException : public std::exception {
+        [[nodiscard]] const char *what() const _GLIBCXX_TXN_SAFE_DYN _GLIBCXX_NOTHROW override {
+            return "Cost matrix contains NaN or infinite values!";
+        }
+    };
+
     class KuhnMunkres {
     public:
         using Ptr = std::shared_ptr<KuhnMunkres>;
@@ -59,6 +65,33 @@ namespace ObjectTracking::kuhn_munkres {
          */
         vector<pair<int, int> > compute(Vec2f const &costMatrix);
 
+        /**
+         * @brief same as compute(costMatrix) on a row-major cost buffer, without allocation once the workspace is
+         *        large enough (see reserve)
+         * @param costMatrix    rows x cols costs, row-major
+         * @param rows          number of rows
+         * @param cols          number of columns
+         * @param result        output, cleared then filled with the `(row, column)` pairs
+         * @throws NonFiniteCostException if a cost is NaN or infinite (the steps would never terminate), also thrown
+         *         by compute(costMatrix)
+         */
+        void compute(float const *costMatrix, int rows, int cols, vector<pair<int, int> > &result);
+
+        /**
+         * @brief allocate the workspace for matrices up to maxRows x maxCols
+         */
+        void reserve(int maxRows, int maxCols);
+
+        /**
+         * @return bytes of the workspace
+         */
+        [[nodiscard]] size_t getMemoryBytes() const;
+
+        /**
+         * @brief free the workspace, the next computation allocates what it needs
+         */
+        void shrink();
+
         /**
          * @brief Create a cost matrix from a profit matrix by calling `inversion_function()`
          *        to invert each value. The inversion function must take one numeric argument
@@ -81,29 +114,26 @@ namespace ObjectTracking::kuhn_munkres {
     private:
         using StepFunc = int (KuhnMunkres::*)();
 
-        // variables
-        Vec2f C;    // cost matrix
+        // variables, the n x n matrices are stored row-major in buffers reused between computations
+        Vec1f C;    // cost matrix
         Vec1b rowCovered, colCovered;
         int n = 0, originalLength = 0, originalWidth = 0;
         int Z0_r = 0, Z0_c = 0;
-        Vec2i marked, path;
+        Vec1i marked, path;     // path: (row, column) pairs
 
         // methods
         /**
-         * @brief Pad a possibly non-square matrix to make it square.
-         * @param matrix    matrix to pad
-         * @param padValue  value to use to pad the matrix
-         * @return a new, possibly padded, matrix
+         * @brief Copy the cost matrix in the square workspace, padded with zeros, and reset the markings.
+         * @param costMatrix    rows x cols costs, row-major
+         * @throws NonFiniteCostException on a NaN or infinite cost
          */
-        static Vec2f padMatrix(Vec2f const &matrix, float padValue = 0.0);
+        void initialize(float const *costMatrix, int rows, int cols);
 
         /**
-         * @brief Create an *n*x*n* matrix, populating it with the specific value.
-         * @param n     rows and columns
-         * @param val   value
-         * @return created matrix
+         * @brief Run the steps on the initialized workspace and collect the starred zeros.
+         * @param result output pairs
          */
-        static Vec2i makeMatrix(int const &n, int const &val);
+        void solve(vector<pair<int, int> > &result);
 
         /**
          * @brief For each row of the matrix, find the smallest element and
@@ -198,7 +228,7 @@ namespace ObjectTracking::kuhn_munkres {
          */
         [[nodiscard]] int findPrimeInRow(int row) const;
 
-        void convertPath(Vec2i const &_path, int count);
+        void convertPath(Vec1i const &_path, int count);
 
         /**
          * @brief Clear all covered matrix cells
@@ -0,0 +1,64 @@
+/**
+ * @desc:   memory accounting of a tracker: bytes held by its tracks, association workspace and output buffers, and
+ *          the high-water policy releasing association workspaces grown by crowd spikes.
+ *          the bytes are the capacities of the containers (what is allocated, not what is used); the allocator
+ *          overhead per block is not included.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <opencv2/core.hpp>
+
+namespace ObjectTracking {
+    /**
+     * @brief bytes held by a tracker, see ObjectTrackerT::getMemoryUsage
+     */
+    struct MemoryUsage {
+        size_t tracks = 0;          // live trackers (filter state, appearance gallery, trajectory), their bookkeeping
+        size_t pooledTracks = 0;    // fixed-capacity mode: free trackers of the pool
+        size_t solver = 0;          // association workspace: IoU / cost matrices, assignment solver, appearance scratch
+        size_t outputs = 0;         // prediction and output rows, pre-filter output, track snapshots
+        size_t dormant = 0;         // dormant track records and their scratch
+        size_t total = 0;           // sum of the above
+        int numTracks = 0;          // live trackers
+        size_t bytesPerTrack = 0;   // average bytes of a live tracker, without the id tables sized by the largest
+                                    // track count seen (see shrinkToFit); 0 without tracks
+    };
+
+    /**
+     * @brief high-water policy of the association workspace, see ObjectTrackerBase::setMemoryParams
+     */
+    struct MemoryParams {
+        size_t maxSolverBytes = 0;  // association workspace size above which it may be released, 0 never
+        int window = 100;           // updates over which the largest association problem is compared to the largest
+                                    // one since the last release
+    };
+
+    namespace memory_usage {
+        template<typename T>
+        size_t capacityBytes(std::vector<T> const &values) {
+            return values.capacity() * sizeof(T);
+        }
+
+        inline size_t capacityBytes(std::vector<bool> const &values) {
+            return (values.capacity() + 7) / 8;
+        }
+
+        /**
+         * @brief bytes of the data of a matrix owning it, 0 for an empty one
+         */
+        inline size_t matBytes(cv::Mat const &mat) {
+            return mat.empty() ? 0 : mat.total() * mat.elemSize();
+        }
+
+        /**
+         * @brief free the storage of a vector, clear keeps it
+         */
+        template<typename T>
+        void release(std::vector<T> &values) {
+            std::vector<T>().swap(values);
+        }
+    }
+}
@@ -0,0 +1,265 @@
+/**
+ * @desc:   motion model policies for KalmanBoxTrackerT / ObjectTrackerT.
+ *          Every policy fixes the state and measurement dimensions at compile time and provides the Kalman model
+ *          matrices together with the conversions between bounding boxes, measurements and states, so the filter
+ *          math is generated for the exact model size.
+ *
+ *          A policy has to provide:
+ *              name                                    model name, stored in recorded sessions
+ *              dimX, dimZ                              state / measurement dimensions
+ *              transitionMatrix()                      F, x(k) = F*x(k-1) + w(k)
+ *              measurementMatrix()                     H, z(k) = H*x(k) + v(k)
+ *              processNoiseCov(x)                      Q, may depend on the current state
+ *              measurementNoiseCov(x)                  R, may depend on the current state
+ *              initialState(z), initialErrorCov(z)     x(0), P(0) from the first measurement
+ *              bboxToZ(bbox), xToBBox(x)               [xc, yc, w, h] <-> z / x conversions
+ *              velocity(x)                             [dxc/dt, dyc/dt] of the box center
+ *              areaRatio                               z is [xc, yc, area, aspect ratio] rather than [xc, yc, w, h]
+ *              motion(x, dz, ddz)                      velocity and acceleration of z per frame, so that z after k
+ *                                                      frames is z + dz*k + ddz*k^2/2 (the prediction without noise)
+ *              constrain(x)                            state fix-up before each predict step
+ */
+
+#pragma once
+
+#include <cmath>
+#include <opencv2/core.hpp>
+
+namespace ObjectTracking {
+    /**
+     * @brief SORT model, constant velocity in center and area, constant aspect ratio.
+     *        state [xc, yc, s, r, dxc/dt, dyc/dt, ds/dt], measurement [xc, yc, s, r]
+     */
+    struct ConstantVelocityModel {
+        static constexpr char const *name = "ConstantVelocity";
+        static constexpr int dimX = 7;
+        static constexpr int dimZ = 4;
+        using StateVec = cv::Vec<float, dimX>;
+        using StateMat = cv::Matx<float, dimX, dimX>;
+        using MeasVec = cv::Vec<float, dimZ>;
+        using MeasMat = cv::Matx<float, dimZ, dimX>;
+        using MeasCovMat = cv::Matx<float, dimZ, dimZ>;
+
+        static StateMat transitionMatrix() {
+            StateMat F = StateMat::eye();
+            F(0, 4) = F(1, 5) = F(2, 6) = 1;
+            return F;
+        }
+
+        static MeasMat measurementMatrix() {
+            return MeasMat::eye();
+        }
+
+        static StateMat processNoiseCov(StateVec const &) {
+            return StateMat::diag(StateVec(1, 1, 1, 1, 1e-2f, 1e-2f, 1e-4f));
+        }
+
+        static MeasCovMat measurementNoiseCov(StateVec const &) {
+            return MeasCovMat::diag(MeasVec(1, 1, 10, 10));
+        }
+
+        static StateVec initialState(MeasVec const &z) {
+            return StateVec(z[0], z[1], z[2], z[3], 0, 0, 0);
+        }
+
+        static StateMat initialErrorCov(MeasVec const &) {
+            return StateMat::diag(StateVec(10, 10, 10, 10, 1e4f, 1e4f, 1e4f));
+        }
+
+        static MeasVec bboxToZ(cv::Vec4f const &bbox) {
+            return {bbox[0], bbox[1], bbox[2] * bbox[3], bbox[2] / bbox[3]};
+        }
+
+        static cv::Vec4f xToBBox(StateVec const &x) {
+            auto w = float(std::sqrt(double(x[2] * x[3])));
+            return {x[0], x[1], w, x[2] / w};
+        }
+
+        static cv::Vec2f velocity(StateVec const &x) {
+            return {x[4], x[5]};
+        }
+
+        static constexpr bool areaRatio = true;
+
+        static void motion(StateVec const &x, cv::Vec4f &dz, cv::Vec4f &ddz) {
+            dz = {x[4], x[5], x[6], 0};
+            ddz = {0, 0, 0, 0};
+        }
+
+        static void constrain(StateVec &x) {
+            // bbox area (ds/dt + s) shouldn't be negative
+            if (x[6] + x[2] <= 0) {
+                x[6] = 0;
+            }
+        }
+    };
+
+    /**
+     * @brief constant acceleration in center and area, constant aspect ratio.
+     *        state [xc, yc, s, r, dxc/dt, dyc/dt, ds/dt, d2xc/dt2, d2yc/dt2, d2s/dt2], measurement [xc, yc, s, r]
+     */
+    struct ConstantAccelerationModel {
+        static constexpr char const *name = "ConstantAcceleration";
+        static constexpr int dimX = 10;
+        static constexpr int dimZ = 4;
+        using StateVec = cv::Vec<float, dimX>;
+        using StateMat = cv::Matx<float, dimX, dimX>;
+        using MeasVec = cv::Vec<float, dimZ>;
+        using MeasMat = cv::Matx<float, dimZ, dimX>;
+        using MeasCovMat = cv::Matx<float, dimZ, dimZ>;
+
+        static StateMat transitionMatrix() {
+            StateMat F = StateMat::eye();
+            for (int i = 0; i < 3; ++i) {
+                F(i, i + 4) = 1;
+                F(i, i + 7) = 0.5f;
+                F(i + 4, i + 7) = 1;
+            }
+            return F;
+        }
+
+        static MeasMat measurementMatrix() {
+            return MeasMat::eye();
+        }
+
+        static StateMat processNoiseCov(StateVec const &) {
+            StateVec q;
+            q[0] = q[1] = q[2] = q[3] = 1;
+            q[4] = q[5] = 1e-2f;
+            q[6] = 1e-4f;
+            q[7] = q[8] = 1e-3f;
+            q[9] = 1e-5f;
+            return StateMat::diag(q);
+        }
+
+        static MeasCovMat measurementNoiseCov(StateVec const &) {
+            return MeasCovMat::diag(MeasVec(1, 1, 10, 10));
+        }
+
+        static StateVec initialState(MeasVec const &z) {
+            StateVec x;
+            for (int i = 0; i < dimZ; ++i) {
+                x[i] = z[i];
+            }
+            return x;
+        }
+
+        static StateMat initialErrorCov(MeasVec const &) {
+            StateVec p = StateVec::all(1e4f);
+            p[0] = p[1] = p[2] = p[3] = 10;
+            return StateMat::diag(p);
+        }
+
+        static MeasVec bboxToZ(cv::Vec4f const &bbox) {
+            return ConstantVelocityModel::bboxToZ(bbox);
+        }
+
+        static cv::Vec4f xToBBox(StateVec const &x) {
+            auto w = float(std::sqrt(double(x[2] * x[3])));
+            return {x[0], x[1], w, x[2] / w};
+        }
+
+        static cv::Vec2f velocity(StateVec const &x) {
+            return {x[4], x[5]};
+        }
+
+        static constexpr bool areaRatio = true;
+
+        static void motion(StateVec const &x, cv::Vec4f &dz, cv::Vec4f &ddz) {
+            dz = {x[4], x[5], x[6], 0};
+            ddz = {x[7], x[8], x[9], 0};
+        }
+
+        static void constrain(StateVec &x) {
+            // bbox area after the next step shouldn't be negative
+            if (x[2] + x[6] + 0.5f * x[9] <= 0) {
+                x[6] = 0;
+                x[9] = 0;
+            }
+        }
+    };
+
+    /**
+     * @brief DeepSORT / ByteTrack model, constant velocity in center, width and height with noise scaled by the
+     *        box size.
+     *        state [xc, yc, w, h, dxc/dt, dyc/dt, dw/dt, dh/dt], measurement [xc, yc, w, h]
+     */
+    struct XywhVelocityModel {
+        static constexpr char const *name = "XywhVelocity";
+        static constexpr int dimX = 8;
+        static constexpr int dimZ = 4;
+        using StateVec = cv::Vec<float, dimX>;
+        using StateMat = cv::Matx<float, dimX, dimX>;
+        using MeasVec = cv::Vec<float, dimZ>;
+        using MeasMat = cv::Matx<float, dimZ, dimX>;
+        using MeasCovMat = cv::Matx<float, dimZ, dimZ>;
+
+        static constexpr float stdWeightPosition = 1.0f / 20;
+        static constexpr float stdWeightVelocity = 1.0f / 160;
+
+        static StateMat transitionMatrix() {
+            StateMat F = StateMat::eye();
+            F(0, 4) = F(1, 5) = F(2, 6) = F(3, 7) = 1;
+            return F;
+        }
+
+        static MeasMat measurementMatrix() {
+            return MeasMat::eye();
+        }
+
+        static StateMat processNoiseCov(StateVec const &x) {
+            float pw = sq(stdWeightPosition * x[2]), ph = sq(stdWeightPosition * x[3]);
+            float vw = sq(stdWeightVelocity * x[2]), vh = sq(stdWeightVelocity * x[3]);
+            return StateMat::diag(StateVec(pw, ph, pw, ph, vw, vh, vw, vh));
+        }
+
+        static MeasCovMat measurementNoiseCov(StateVec const &x) {
+            float pw = sq(stdWeightPosition * x[2]), ph = sq(stdWeightPosition * x[3]);
+            return MeasCovMat::diag(MeasVec(pw, ph, pw, ph));
+        }
+
+        static StateVec initialState(MeasVec const &z) {
+            return StateVec(z[0], z[1], z[2], z[3], 0, 0, 0, 0);
+        }
+
+        static StateMat initialErrorCov(MeasVec const &z) {
+            float pw = sq(2 * stdWeightPosition * z[2]), ph = sq(2 * stdWeightPosition * z[3]);
+            float vw = sq(10 * stdWeightVelocity * z[2]), vh = sq(10 * stdWeightVelocity * z[3]);
+            return StateMat::diag(StateVec(pw, ph, pw, ph, vw, vh, vw, vh));
+        }
+
+        static MeasVec bboxToZ(cv::Vec4f const &bbox) {
+            return {bbox[0], bbox[1], bbox[2], bbox[3]};
+        }
+
+        static cv::Vec4f xToBBox(StateVec const &x) {
+            return {x[0], x[1], x[2], x[3]};
+        }
+
+        static cv::Vec2f velocity(StateVec const &x) {
+            return {x[4], x[5]};
+        }
+
+        static constexpr bool areaRatio = false;
+
+        static void motion(StateVec const &x, cv::Vec4f &dz, cv::Vec4f &ddz) {
+            dz = {x[4], x[5], x[6], x[7]};
+            ddz = {0, 0, 0, 0};
+        }
+
+        static void constrain(StateVec &x) {
+            // bbox width and height shouldn't become negative
+            if (x[2] + x[6] <= 0) {
+                x[6] = 0;
+            }
+            if (x[3] + x[7] <= 0) {
+                x[7] = 0;
+            }
+        }
+
+    private:
+        static float sq(float v) {
+            return v * v;
+        }
+    };
+}
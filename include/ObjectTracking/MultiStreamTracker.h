@@ -0,0 +1,101 @@
+/**
+ * @desc:   host of many independent SORT streams, e.g. one per camera, updated together once per tick.
+ *          every stream is a full ObjectTrackerT (own detections, association, track ids, configuration), but the
+ *          Kalman predict and correct steps of all the streams' trackers run as one batched pass (KalmanBatchT)
+ *          per tick instead of one small call per tracker, so hundreds of streams of a few tracks each cost about
+ *          as much as one stream with all their tracks.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <ObjectTracking/KalmanBatch.h>
+#include <ObjectTracking/ObjectTracker.h>
+
+namespace ObjectTracking {
+    /**
+     * @brief statistics of the last MultiStreamTrackerT::update call, times in milliseconds
+     */
+    struct MultiStreamStats {
+        int numTracks = 0;          // trackers predicted in the batched pass
+        int numCorrected = 0;       // trackers corrected in the batched pass
+        double predictTime = 0;     // batched predict, gather and scatter included
+        double correctTime = 0;     // batched correction, gather and scatter included
+        double totalTime = 0;       // whole update call
+    };
+
+    template<class MotionModel>
+    class MultiStreamTrackerT {
+        // variables
+    public:
+        using Ptr = std::shared_ptr<MultiStreamTrackerT>;
+        using Stream = ObjectTrackerT<MotionModel>;
+        using Tracker = typename Stream::Tracker;
+    private:
+        vector<typename Stream::Ptr> streams;
+        KalmanBatchT<MotionModel> kalman;
+        vector<Tracker *> batchTrackers;        // scratch, trackers of the batched pass
+        vector<float const *> batchBBoxes;      // scratch, detections of the corrected trackers
+        MultiStreamStats stats;
+
+        // methods
+    public:
+        /**
+         * @param numStreams number of streams, > 0
+         * @param maxAge, minHits, iouThresh configuration of every stream, see ObjectTrackerT
+         */
+        explicit MultiStreamTrackerT(int numStreams, int maxAge = 1, int minHits = 3, float iouThresh = 0.3);
+
+        /**
+         * @brief host of fixed-capacity streams (see ObjectTrackerT(TrackerCapacity const &, ...)), the batch
+         *        workspace is allocated here for all of them so update does not allocate either
+         */
+        MultiStreamTrackerT(int numStreams, TrackerCapacity const &capacity, int maxAge = 1, int minHits = 3,
+                            float iouThresh = 0.3);
+
+        virtual ~MultiStreamTrackerT();
+
+        MultiStreamTrackerT(MultiStreamTrackerT const &) = delete;
+
+        MultiStreamTrackerT &operator=(MultiStreamTrackerT const &) = delete;
+
+        /**
+         * @brief one tick of every stream, each stream behaves as with its own ObjectTrackerT::update.
+         *        the streams must only be updated through the host.
+         * @param bboxesDet detections of each stream, Mat(M, 6) [[xc,yc,w,h,score,class_id];[...];...], possibly empty
+         * @param bboxesPost output, resized to the number of streams, the tracks of each stream as returned by
+         *                   ObjectTrackerT::update
+         */
+        void update(vector<cv::Mat> const &bboxesDet, vector<cv::Mat> &bboxesPost);
+
+        /**
+         * @brief same as update(bboxesDet, bboxesPost) with appearance, see ObjectTrackerT::update(bboxesDet,
+         *        embeddings)
+         * @param embeddings detection embeddings of each stream, an empty Mat for the IoU only association
+         */
+        void update(vector<cv::Mat> const &bboxesDet, vector<cv::Mat> const &embeddings, vector<cv::Mat> &bboxesPost);
+
+        [[nodiscard]] int getStreamCount() const;
+
+        /**
+         * @brief stream tracker, for its configuration (pre-filter, appearance, dormant tier, ...) and its results
+         *        (statistics, snapshots, trajectories). its own time statistics include the batched passes and the
+         *        stages of the other streams run in between.
+         */
+        [[nodiscard]] typename Stream::Ptr const &getStream(int index) const;
+
+        /**
+         * @brief statistics of the last update call
+         */
+        [[nodiscard]] MultiStreamStats const &getStats() const;
+    };
+
+    using MultiStreamTracker = MultiStreamTrackerT<ConstantVelocityModel>;
+
+    extern template class MultiStreamTrackerT<ConstantVelocityModel>;
+
+    extern template class MultiStreamTrackerT<ConstantAccelerationModel>;
+
+    extern template class MultiStreamTrackerT<XywhVelocityModel>;
+}
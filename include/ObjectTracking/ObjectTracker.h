@@ -9,9 +9,23 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
+#include <mutex>
+#include <ObjectTracking/Appearance.h>
+#include <ObjectTracking/AssignmentPlanner.h>
+#include <ObjectTracking/BoxKernels.h>
+#include <ObjectTracking/DetectionPreFilter.h>
+#include <ObjectTracking/DormantTracks.h>
+#include <ObjectTracking/FlatIdMap.h>
 #include <ObjectTracking/KuhnMunkres.h>
 #include <ObjectTracking/KalmanBoxTracker.h>
+#include <ObjectTracking/MemoryUsage.h>
+#include <ObjectTracking/MotionModels.h>
+#include <ObjectTracking/SessionLog.h>
+#include <ObjectTracking/SpatialGrid.h>
+#include <ObjectTracking/TrackSnapshot.h>
+#include <ObjectTracking/Trajectory.h>
 
 namespace ObjectTracking {
     using std::shared_ptr;
@@ -29,62 +43,405 @@ namespace ObjectTracking {
     using TypeLostPreds = vector<int>;
     using TypeAssociate = tuple<TypeMatchedPairs, TypeLostDets, TypeLostPreds>;
 
-    class ObjectTracker {
+    /**
+     * @brief per-frame statistics of the last ObjectTracker::update call, times in milliseconds
+     */
+    struct TrackerStats {
+        int frameCount = 0;             // number of update calls so far
+        int numInputDetections = 0;     // detections given to update
+        int numDetections = 0;          // detections left after the pre-filter
+        int numTracks = 0;              // live trackers after update
+        int numOutputTracks = 0;        // rows returned by update
+        double preFilterTime = 0;       // detection pre-filter
+        double predictTime = 0;         // kalman predict of all trackers
+        double associateTime = 0;       // IoU / appearance cost matrix and assignment
+        double correctTime = 0;         // kalman update, tracker creation and removal
+        double totalTime = 0;           // whole update call
+        int skippedSnapshots = 0;       // snapshot publications skipped so far because all slots were pinned
+        int droppedDetections = 0;      // lowest scored detections dropped because of TrackerCapacity::maxDetections
+        int droppedTracks = 0;          // unmatched detections starting no track because of TrackerCapacity::maxTracks
+        int revivedTracks = 0;          // dormant tracks revived by unmatched detections
+        int numDormantTracks = 0;       // dormant tracks after update
+        int numLowScoreDetections = 0;  // detections below CascadeParams::scoreThresh, only matched to leftover tracks
+        AssignmentStrategy assignmentStrategy = AssignmentStrategy::Dense;  // solver of the main association stage
+        int numAssignmentComponents = 0;    // independent blocks of its cost matrix, 0 if it was not analyzed
+        int workspaceReleases = 0;      // association workspaces released so far by the MemoryParams policy
+    };
+
+    /**
+     * @brief capacities of the fixed-capacity mode, see ObjectTrackerT(TrackerCapacity const &, ...)
+     */
+    struct TrackerCapacity {
+        int maxTracks = 0;      // live trackers; beyond it, the highest scored unmatched detections start tracks
+        int maxDetections = 0;  // detections per update; beyond it, the highest scored detections are kept
+    };
+
+    /**
+     * @brief track lifecycle events. with the dormant tier a removed track emits Deleted when it goes dormant, as the
+     *        tracker is removed; if a detection revives it, Revived reuses the id of that Deleted event, and it is
+     *        Confirmed again on its next match. a dormant record that expires emits nothing more.
+     */
+    enum class TrackEventType : int {
+        Created = 0,    // new tentative tracker, box of its first detection
+        Confirmed = 1,  // the track is output for the first time since Created / Revived
+        Updated = 2,    // an output track moved or resized beyond the event thresholds, or output again after coasting
+        Coasting = 3,   // an output track was not matched, box is the prediction
+        Deleted = 4,    // the tracker was removed, box is its last prediction
+        Revived = 5,    // a dormant track was revived with its former id, tentative, box of the reviving detection
+    };
+
+    /**
+     * @brief compact track lifecycle event, see ObjectTrackerT::updateEvents
+     */
+    struct TrackEvent {
+        TrackEventType type;
+        int trackerId;
+        int frame;          // TrackerStats::frameCount of the update emitting the event
+        float xc, yc, w, h;
+        float score;
+        float classId;
+        float dx, dy;       // velocity
+    };
+
+    /**
+     * @brief thresholds of the Updated event, relative to the box of the last Confirmed / Updated event
+     */
+    struct TrackEventParams {
+        float minMove = 2.0f;           // center displacement in pixels
+        float minSizeChange = 0.05f;    // relative width or height change
+    };
+
+    /**
+     * @brief cascaded association by detection score, see ObjectTrackerBase::setCascadeParams
+     */
+    struct CascadeParams {
+        float scoreThresh = 0;      // detections scored below it are low-score ones, 0 disables the cascade
+        float lowIouThresh = 0.5f;  // minimal IoU of a low-score detection with the track it is matched to, > 0
+    };
+
+    /**
+     * @brief motion model independent part of SORT: configuration, data association and drawing.
+     */
+    class ObjectTrackerBase {
         // variables
-    public:
-        using Ptr = std::shared_ptr<ObjectTracker>;
-    private:
+    protected:
         int maxAge;         // tracker's maximal unmatch count
         int minHits;        // tracker's minimal match count
-        float iouThresh;    // IoU threshold
-        vector<KalmanBoxTracker::Ptr> trackers;
-        KuhnMunkres::Ptr km = nullptr;
+        float iouThresh;    // minimal IoU of a match, > 0, as in SORT (the low-score stage has its own)
+        TrackerCapacity capacity;   // all zero unless in the fixed-capacity mode
+        AssignmentPlanner planner;  // assignment solver selection, plain Kuhn Munkres by default
+        vector<AssignmentStrategy> stageStrategies;     // strategy of every solve of the running update, in order
+        vector<AssignmentStrategy> forcedStrategies;    // strategies imposed on the solves of the next update
+        SpatialGrid trackIndex;     // tracker id -> latest box, not maintained in the fixed-capacity mode
+        FlatIdMap<int> trackerIndexById;    // tracker id -> index in trackers / prediction rows
+        vector<int> candidateIds;   // scratch for spatial index queries
+        box_kernels::BoxSet detBoxes, predBoxes;    // scratch for the association IoU
+        DetectionPreFilter::Ptr preFilter = nullptr;
+        cv::Mat bboxesFiltered;     // pre-filter output, in the fixed-capacity mode maxDetections rows
+        cv::Mat bboxesSelected;     // fixed-capacity mode: header of the selected rows of bboxesFiltered
+        vector<int> keptIndices;    // pre-filter kept rows, used to filter the embeddings
+        vector<int> filterIndices;  // fixed-capacity mode: pre-filter kept rows among the selected detections
+        cv::Mat embeddingsFiltered;
+        cv::Mat predBuffer, postBuffer;     // prediction and output rows, only grown in the default mode
+        vector<float> costBuffer;   // scratch, detection x prediction IoU, row-major
+        vector<int> stageDets, stagePreds;  // scratch, detection rows and prediction columns of an association stage
+        vector<float> stageCost;    // scratch, cost matrix of an association stage, row-major
+        vector<pair<int, int>> assignment;  // scratch, assignment solver output
+        vector<unsigned char> detMatched, predMatched;
+        TypeMatchedPairs matchedDetPred;    // dataAssociate output
+        TypeLostDets lostDets;
+        TypeLostPreds lostPreds;
+        AppearanceParams appearanceParams;
+        AppearanceMatcher appearanceMatcher;
+        vector<FeatureGallery const *> galleries;   // scratch, tracker galleries in prediction row order
+        cv::Mat appearanceDist;     // scratch, detection x prediction cosine distances
+        TrackEventParams eventParams;
+        CascadeParams cascadeParams;
+        int historyLength = 0;      // trajectory points kept per track, 0 disables the history
+        MemoryParams memoryParams;
+        int windowUpdates = 0;      // updates in the current window of the memory policy
+        int windowSide = 0;         // largest association side (detections or predictions) of the current window
+        int peakSide = 0;           // largest association side since the last workspace release
+        DormantTrackStore dormant;  // removed confirmed tracks that can still be revived
+        /**
+         * @brief candidate revival of a dormant track by an unmatched detection
+         */
+        struct DormantMatch {
+            float iou;
+            int lostPos;        // position in lostDets
+            int dormantIndex;   // record index in dormant
+        };
+
+        vector<DormantMatch> dormantMatches;    // scratch
+        vector<int> dormantCandidates;          // scratch, record indices
+        vector<unsigned char> dormantUsed;      // scratch, per record
+        vector<int> revivalIds;     // per lostDets entry, tracker id of the revived dormant track or -1
+        vector<int> revivedIds;     // scratch, tracker ids revived in this update
+        vector<TrackEvent> *events = nullptr;   // event output of the running update, nullptr if not requested
+        SnapshotBuffer snapshots;   // track snapshots published at the end of every update
+        int64_t lastTimestamp = 0;  // start of the previous update, steady clock nanoseconds, 0 before the first one
+        double framePeriod = 0;     // smoothed interval between the updates, nanoseconds
+        SessionRecorder::Ptr recorder = nullptr;
+        TrackerStats stats;
+        /**
+         * @brief output state of a track as seen by the event stream
+         */
+        struct TrackReport {
+            bool visible = false;       // in the output of the last frame
+            bool confirmed = false;     // Confirmed event emitted
+            cv::Vec4f box;              // box of the last Confirmed / Updated event
+            float score = 0, classId = 0;
+            cv::Vec4f lastBox;          // current box at the end of the update lastBoxFrame, for the snapshots
+            int lastBoxFrame = -1;
+        };
+
+        FlatIdMap<TrackReport> reports;     // tracker id -> report, maintained in every update mode
         static int const maxColors;
         static vector<cv::Scalar> colors;
-        static bool colorsInitialized;
+        static std::once_flag colorsInitialized;
 
         // methods
     public:
-        explicit ObjectTracker(int maxAge = 1, int minHits = 3, float iouThresh = 0.3);
+        virtual ~ObjectTrackerBase();
 
-        virtual ~ObjectTracker();
+        ObjectTrackerBase(const ObjectTrackerBase &) = delete;
 
-        ObjectTracker(const ObjectTracker &) = delete;
+        ObjectTrackerBase &operator=(const ObjectTrackerBase &) = delete;
 
-        ObjectTracker &operator=(const ObjectTracker &) = delete;
+        /**
+         * @brief draw tracker output boxes on the calling thread, see TrackRenderer to render snapshots off the
+         *        tracking thread
+         * @param bboxes tracker output, Mat(N, 9) [[xc,yc,w,h,score,class_id,dx,dy,tracker_id];[...];...]
+         */
+        static void draw(cv::Mat &img, cv::Mat const &bboxes, bool withScore = false);
 
         /**
-         * @brief bbox tracking in SORT, this method must be called once for each frame even with empty detections, 
-         *        the number of objects retured may differ from the number of detections provided.
-         * @param bboxesDet detections, Mat(M, 6) with the format [[xc,yc,w,h,score,class_id];[...];...]
-         * @return matched bboxes, Mat(N, 9) with the format [[xc,yc,w,h,score,class_id,dx,dy,tracker_id];[...];...].
+         * @return drawing color of a tracker
          */
-        cv::Mat update(cv::Mat const &bboxesDet);
+        static cv::Scalar const &getColor(int trackerId);
 
-        static void draw(cv::Mat &img, cv::Mat const &bboxes, bool withScore = false);
+        /**
+         * @brief set the optional detection pre-filter, run on the detections of every update before association
+         * @param filter pre-filter, nullptr disables it
+         */
+        void setPreFilter(DetectionPreFilter::Ptr filter);
 
-    private:
-        /** 
-         * @brief check if NAN value in Mat
-         * @param mat input Matrix 
+        [[nodiscard]] DetectionPreFilter::Ptr getPreFilter() const;
+
+        /**
+         * @brief set the appearance association parameters, used by the update calls given embeddings.
+         *        gallery changes (capacity, quantization) apply to the new trackers, and to the existing ones at their
+         *        next match, which restarts their gallery.
+         */
+        void setAppearanceParams(AppearanceParams const &params);
+
+        [[nodiscard]] AppearanceParams const &getAppearanceParams() const;
+
+        void setEventParams(TrackEventParams const &params);
+
+        [[nodiscard]] TrackEventParams const &getEventParams() const;
+
+        /**
+         * @brief set the cascaded association (ByteTrack-like): the detections scored at least scoreThresh are
+         *        associated first with all the tracks, then the low-score detections only with the tracks left
+         *        unmatched, by IoU alone and with at least lowIouThresh overlap. the low-score detections left
+         *        unmatched start no tracks and revive no dormant tracks. each stage solves a smaller assignment, and
+         *        low-score false positives no longer create short-lived tracks. with appearance, the low-score
+         *        embeddings are not added to the galleries.
+         */
+        void setCascadeParams(CascadeParams const &params);
+
+        [[nodiscard]] CascadeParams const &getCascadeParams() const;
+
+        /**
+         * @brief set the assignment solver policy (see AssignmentPlanner.h): by default every association is solved
+         *        by Kuhn Munkres on the whole cost matrix; the Exact policy lets a cost model pick, per association,
+         *        the cheaper of that and an exact per-block solve of the independent track groups, and Approximate
+         *        also allows a greedy assignment. the appearance association always uses Kuhn Munkres.
+         *        the choices are reported in TrackerStats.
+         */
+        void setAssignmentParams(AssignmentParams const &params);
+
+        [[nodiscard]] AssignmentParams const &getAssignmentParams() const;
+
+        /**
+         * @brief seed the assignment cost model with a calibration written by assignmentBench --calibrate
+         * @throws std::runtime_error on an unreadable or invalid file, the model is then unchanged
+         */
+        void loadAssignmentCalibration(std::string const &path);
+
+        /**
+         * @brief current assignment cost model estimates, see AssignmentPlanner::getCalibration
+         */
+        void getAssignmentCalibration(std::vector<double> &estimates) const;
+
+        /**
+         * @brief seed the assignment cost model with estimates of getAssignmentCalibration
+         * @throws std::runtime_error on invalid estimates, the model is then unchanged
+         */
+        void setAssignmentCalibration(std::vector<double> const &estimates);
+
+        /**
+         * @return strategies of the assignment solves of the last update, in stage order (the main stage, then the
+         *         low-score stage of the cascade); a stage without detections or predictions solves nothing
+         */
+        [[nodiscard]] std::vector<AssignmentStrategy> const &getLastAssignmentStrategies() const;
+
+        /**
+         * @brief impose the strategies of the assignment solves of the next update instead of the choice of the cost
+         *        model, e.g. to replay a session with its recorded strategies; the solves beyond them, and the ones
+         *        with appearance (always Kuhn Munkres), are left to the cost model
+         */
+        void forceAssignmentStrategies(std::vector<AssignmentStrategy> const &strategies);
+
+        /**
+         * @brief set the dormant tier (see DormantTracks.h): confirmed tracks removed after maxAge frames without a
+         *        match are kept as compact records, outside of the association, for maxDormantAge frames. an
+         *        unmatched detection overlapping the extrapolated box of such a record revives the track with its
+         *        original id instead of starting a new one; it is output again on its next match. the stored records
+         *        are dropped here.
+         */
+        void setDormantParams(DormantParams const &params);
+
+        [[nodiscard]] DormantParams const &getDormantParams() const;
+
+        /**
+         * @brief set the high-water policy of the association workspace, which only grows with the largest cost
+         *        matrix seen: when it holds more than maxSolverBytes and the largest association of the last window
+         *        updates is smaller than the largest one since the last release (a crowd spike is over), it is
+         *        released after the update and the next updates allocate what they need. ignored in the
+         *        fixed-capacity mode, whose buffers never change.
+         */
+        void setMemoryParams(MemoryParams const &params);
+
+        [[nodiscard]] MemoryParams const &getMemoryParams() const;
+
+        /**
+         * @return bytes of the association workspace: IoU / cost matrices, assignment solver, appearance scratch
+         */
+        [[nodiscard]] size_t getSolverMemoryBytes() const;
+
+        /**
+         * @return trajectory points kept per track, 0 if the history is disabled
+         */
+        [[nodiscard]] int getHistoryLength() const;
+
+        /**
+         * @brief statistics of the last update call
+         */
+        [[nodiscard]] TrackerStats const &getStats() const;
+
+        /**
+         * @brief latest published track snapshot. thread-safe, may be called while update runs in another thread,
+         *        which is never blocked. the snapshot is immutable while the handle is held; release it promptly, a
+         *        publication is skipped when all snapshot slots are held.
+         * @return handle to the snapshot, empty before the first update
+         */
+        [[nodiscard]] SnapshotBuffer::Handle getSnapshot() const;
+
+        /**
+         * @brief boxes of the confirmed tracks of the latest snapshot at any time, interpolated between the two last
+         *        updates and extrapolated with the motion model after the last one (see TrackSnapshot::sample), for
+         *        outputs at a higher rate than the updates. thread-safe like getSnapshot, never allocates once samples
+         *        has the capacity of the tracks.
+         * @param time steady clock nanoseconds, e.g. the display time; sampling a little in the past (one update
+         *             interval) interpolates between corrected boxes and avoids the jumps of the corrections
+         * @param samples output, cleared then filled
+         * @param maxExtrapolation extrapolation horizon in frames
+         * @return false before the first update, samples is then empty
+         */
+        bool sampleAt(int64_t time, vector<TrackSample> &samples, float maxExtrapolation = 3) const;
+
+        /**
+         * @return whether the tracker was constructed with a TrackerCapacity
+         */
+        [[nodiscard]] bool isFixedCapacity() const;
+
+        [[nodiscard]] TrackerCapacity const &getCapacity() const;
+
+    protected:
+        ObjectTrackerBase(int maxAge, int minHits, float iouThresh);
+
+        /**
+         * @brief fixed-capacity mode: allocate all the association, output and bookkeeping buffers for capacity
+         */
+        void reserveCapacity();
+
+        /**
+         * @brief add the bytes of the parts independent of the motion model: solver, outputs, dormant tier and the
+         *        per-track bookkeeping (to tracks)
+         */
+        void addBaseMemoryUsage(MemoryUsage &usage) const;
+
+        /**
+         * @brief free the association workspace, the next updates allocate what they need
+         */
+        void releaseSolverMemory();
+
+        /**
+         * @brief memory policy after an update, see setMemoryParams
+         * @param side larger side of the association of the update
+         */
+        void applyMemoryPolicy(int side);
+
+        /**
+         * @brief fixed-capacity mode: keep the highest scored detections within capacity.maxDetections, then run the
+         *        pre-filter on them. fills bboxesSelected and keptIndices (input rows of the selected detections).
+         * @param bboxesInput detections, Mat(M, 6)
+         */
+        void selectDetections(cv::Mat const &bboxesInput);
+
+        /**
+         * @brief index a tracker box for the association candidates and queryRegion, no-op in the fixed-capacity mode
+         * @param bbox [xc, yc, w, h, ...]
+         */
+        void indexTrack(int trackerId, float const *bbox);
+
+        void unindexTrack(int trackerId);
+
+        /**
+         * @brief check if NAN value in a fixed-size matrix
+         * @param mat input Matrix
          * @return any NAN value in Matrix or not.
          */
-        template<typename Tp>
-        static bool isAnyNan(cv::Mat const &mat) {
-            for (auto it = mat.begin<Tp>(); it != mat.end<Tp>(); ++it)
-                if (*it != *it) {
+        template<typename Tp, int m, int n>
+        static bool isAnyNan(cv::Matx<Tp, m, n> const &mat) {
+            for (auto const &v: mat.val)
+                if (v != v) {
                     return true;
                 }
             return false;
         }
 
         /**
-         * @brief data associate in SORT
+         * @brief data associate in SORT, the result is left in matchedDetPred, lostDets and lostPreds. with the
+         *        cascade (cascadeParams) the high-score detections are associated first, then the low-score ones with
+         *        the leftover predictions; lostDets only holds high-score detections.
+         * @param bboxesDet detected bboxes, Mat(M, 4+)
+         * @param bboxesPred predicted bboxes, Mat(N, 4+), row j belongs to the tracker with index j in
+         *                   trackerIndexById and is indexed in trackIndex
+         * @param cosineDist optional appearance distances, Mat(M, N); if given the cost is fused with the IoU cost
+         *                   and matches farther than appearanceParams.maxCosineDistance are rejected
+         *                   (galleries must then hold the tracker galleries in prediction row order)
+         */
+        void dataAssociate(cv::Mat const &bboxesDet, cv::Mat const &bboxesPred, cv::Mat const *cosineDist = nullptr);
+
+        /**
+         * @brief one assignment stage over the detections stageDets and the predictions stagePreds, using the IoU in
+         *        costBuffer; the accepted pairs are added to matchedDetPred, detMatched and predMatched
+         * @param cosineDist optional appearance distances of all the detections and predictions, see dataAssociate
+         * @param minIou minimal IoU of an accepted pair, > 0
+         */
+        void associateStage(cv::Mat const *cosineDist, float minIou);
+
+        /**
+         * @brief IoU of detections and predictions. computed only for the pairs found overlapping in trackIndex (all
+         *        the other pairs have an IoU of 0), or for all the pairs in the fixed-capacity mode.
          * @param bboxesDet detected bboxes, Mat(M, 4+)
-         * @param bboxesPred predicted bboxes, Mat(N, 4+)
-         * @return associate tuple (matched pairs, lost detections, lost predictions)
+         * @param bboxesPred predicted bboxes, Mat(N, 4+), indexed in trackIndex
+         * @param iouMat output, M x N row-major, value(i, j) means IoU of bboxesDet(i) and bboxesPred(j)
          */
-        TypeAssociate dataAssociate(cv::Mat const &bboxesDet, cv::Mat const &bboxesPred);
+        void computeIouMatrix(cv::Mat const &bboxesDet, cv::Mat const &bboxesPred, float *iouMat);
 
         /**
          * @brief IoU of bboxes
@@ -94,7 +451,274 @@ namespace ObjectTracking {
          */
         static cv::Mat getIouMatrix(cv::Mat const &bboxesA, cv::Mat const &bboxesB);
 
+        /**
+         * @brief integer box of a bbox, as used in the association
+         * @param bbox [xc, yc, w, h, ...]
+         */
+        static cv::Rect getBBoxRect(float const *bbox);
+
+        /**
+         * @brief event stream bookkeeping of a new tracker, emits Created, or Revived for a revived dormant track
+         * @param bbox first detection [xc, yc, w, h, score, class_id]
+         */
+        void reportCreated(int trackerId, float const *bbox, bool revived);
+
+        /**
+         * @brief event stream bookkeeping of a matched tracker, emits Confirmed / Updated if the track is output
+         * @param bbox corrected bbox [xc, yc, w, h]
+         * @param isOutput the track is in the output of this frame
+         */
+        void reportMatched(int trackerId, cv::Vec4f const &bbox, float score, float classId,
+                           cv::Vec2f const &velocity, bool isOutput);
+
+        /**
+         * @brief event stream bookkeeping of an unmatched tracker kept alive, emits Coasting if it was output
+         * @param bbox predicted bbox [xc, yc, w, h]
+         */
+        void reportLost(int trackerId, float const *bbox, cv::Vec2f const &velocity);
+
+        /**
+         * @brief event stream bookkeeping of a removed tracker, emits Deleted
+         * @param bbox last predicted bbox [xc, yc, w, h]
+         */
+        void reportDeleted(int trackerId, float const *bbox);
+
+        /**
+         * @brief keep a removed tracker in the dormant tier if the tier is enabled and the track was confirmed,
+         *        to be called before reportDeleted
+         * @param lastFrame frame of its last match
+         * @param bbox last corrected bbox [xc, yc, w, h]
+         */
+        void addDormant(int trackerId, int lastFrame, cv::Vec4f const &bbox, cv::Vec2f const &velocity);
+
+        /**
+         * @brief expire the dormant tracks, then match them to the unmatched detections (lostDets), greedily by
+         *        decreasing IoU. fills revivalIds and removes the revived tracks from the tier.
+         * @param bboxesDet detected bboxes, Mat(M, 6)
+         */
+        void reviveDormant(cv::Mat const &bboxesDet);
+
+        /**
+         * @brief milliseconds elapsed since a time point
+         */
+        static double getElapsedMs(std::chrono::steady_clock::time_point const &start);
+
         static void initializeColors();
     };
-}
 
+    template<class MotionModel>
+    class MultiStreamTrackerT;
+
+    /**
+     * @brief SORT tracker for a given motion model policy (see MotionModels.h).
+     */
+    template<class MotionModel>
+    class ObjectTrackerT : public ObjectTrackerBase {
+        // the multi-stream host runs the update stages itself, with the Kalman steps batched over all its streams
+        friend class MultiStreamTrackerT<MotionModel>;
+
+        // variables
+    public:
+        using Ptr = std::shared_ptr<ObjectTrackerT>;
+        using Tracker = KalmanBoxTrackerT<MotionModel>;
+    private:
+        /**
+         * @brief state of the running update shared by its stages
+         */
+        struct UpdateStage {
+            std::chrono::steady_clock::time_point start, phaseStart;
+            int64_t timestamp = 0;      // start of the update, steady clock nanoseconds
+            bool withAppearance = false;
+            cv::Mat bboxesInput;        // headers of the input, recorded once associated
+            cv::Mat embeddingsInput;
+            cv::Mat bboxesDet;          // header of the detections used by the update, after the pre-filter
+            cv::Mat embeddings;         // header of their embeddings
+            cv::Mat *bboxesPost = nullptr;
+            int numPred = 0;            // prediction rows in predBuffer
+        };
+
+        vector<typename Tracker::Ptr> trackers;
+        vector<typename Tracker::Ptr> pool;     // fixed-capacity mode: free trackers, reused for the new tracks
+        UpdateStage stage;
+
+        // methods
+    public:
+        explicit ObjectTrackerT(int maxAge = 1, int minHits = 3, float iouThresh = 0.3);
+
+        /**
+         * @brief fixed-capacity tracker for hard real-time use: every buffer and the trackers themselves are
+         *        allocated here, then update never allocates on the heap (except with embeddings, a recorder, or an
+         *        event vector without enough capacity). the association computes the IoU of all the pairs
+         *        instead of using the spatial index, which is cheaper for bounded track counts.
+         *        when the capacity is exceeded the tracker degrades gracefully: only the highest scored
+         *        maxDetections detections are used, and only the highest scored unmatched detections start tracks
+         *        while fewer than maxTracks are alive (see TrackerStats::droppedDetections / droppedTracks).
+         * @param capacity maximal number of live tracks and of detections per update, both > 0
+         */
+        explicit ObjectTrackerT(TrackerCapacity const &capacity, int maxAge = 1, int minHits = 3,
+                                float iouThresh = 0.3);
+
+        ~ObjectTrackerT() override;
+
+        /**
+         * @brief bbox tracking in SORT, this method must be called once for each frame even with empty detections, 
+         *        the number of objects retured may differ from the number of detections provided.
+         * @param bboxesDet detections, Mat(M, 6) with the format [[xc,yc,w,h,score,class_id];[...];...]
+         * @return matched bboxes, Mat(N, 9) with the format [[xc,yc,w,h,score,class_id,dx,dy,tracker_id];[...];...].
+         *         in the fixed-capacity mode it is a view of an internal buffer, overwritten by the next update.
+         */
+        cv::Mat update(cv::Mat const &bboxesDet);
+
+        /**
+         * @brief bbox tracking with appearance (DeepSORT-like association), see update(bboxesDet) and
+         *        setAppearanceParams. an empty embeddings Mat falls back to the IoU only association.
+         * @param bboxesDet detections, Mat(M, 6) with the format [[xc,yc,w,h,score,class_id];[...];...]
+         * @param embeddings detection embeddings, Mat(M, dim) CV_32F, row i belongs to detection i
+         * @return matched bboxes, Mat(N, 9) with the format [[xc,yc,w,h,score,class_id,dx,dy,tracker_id];[...];...].
+         */
+        cv::Mat update(cv::Mat const &bboxesDet, cv::Mat const &embeddings);
+
+        /**
+         * @brief delta-output variant of update: same tracking, but instead of the full matrix of output tracks only
+         *        the lifecycle and state-change events of this frame are emitted (see TrackEventType).
+         * @param bboxesDet detections, Mat(M, 6) with the format [[xc,yc,w,h,score,class_id];[...];...]
+         * @param events output, cleared then filled with the events of this frame; reuse it to avoid allocations
+         * @param embeddings optional detection embeddings, see update(bboxesDet, embeddings)
+         */
+        void updateEvents(cv::Mat const &bboxesDet, vector<TrackEvent> &events,
+                          cv::Mat const &embeddings = cv::Mat());
+
+        /**
+         * @brief find the confirmed tracks overlapping a region, without walking all the tracks.
+         *        boxes are the ones of the last update (corrected, or predicted for tracks not matched).
+         *        not thread-safe, the query updates the index: call it from the thread running the updates, or
+         *        lock around both; other threads use getSnapshot.
+         * @param region query region, [x, y, width, height] in image coordinates
+         * @param trackerIds output, tracker ids of the confirmed tracks overlapping the region
+         */
+        void queryRegion(cv::Rect2f const &region, vector<int> &trackerIds);
+
+        /**
+         * @brief live trackers after the last update, in the order of the snapshot tracks
+         */
+        [[nodiscard]] vector<typename Tracker::Ptr> const &getTrackers() const;
+
+        /**
+         * @brief bytes held by the tracker, for sizing deployments by the number of concurrent tracks
+         */
+        [[nodiscard]] MemoryUsage getMemoryUsage() const;
+
+        /**
+         * @brief release the storage grown beyond the current needs: association workspace, prediction and output
+         *        rows, dormant scratch, tracker list and id tables. no-op in the fixed-capacity mode, whose buffers
+         *        are sized by the capacity; the track snapshots are kept since readers may hold them.
+         */
+        void shrinkToFit();
+
+        /**
+         * @brief keep the latest corrected boxes of every track (see Trajectory.h), e.g. for speed estimation or
+         *        line crossing without a per-consumer map keyed on tracker ids. a point is added when the tracker is
+         *        created and whenever it is matched, so coasting frames leave gaps in the frame numbers.
+         *        the live trackers are cleared and resized here (and, in the fixed-capacity mode, the pooled ones, so
+         *        the history keeps update allocation-free).
+         * @param length points kept per track, 0 disables the history and releases its storage
+         */
+        void setHistoryLength(int length);
+
+        /**
+         * @brief trajectory of a live track, read without copying. not thread-safe: call it between updates, on the
+         *        thread running them; the span is invalidated by the next update.
+         * @return the stored points oldest first, empty for an unknown tracker id or a disabled history
+         */
+        [[nodiscard]] TrajectorySpan getTrajectory(int trackerId) const;
+
+        /**
+         * @brief record the input of every following update (detections before the pre-filter, embeddings and the
+         *        update time) with the current configuration, for an offline replay (tool replaySession).
+         *        set it before the first update (and after the configuration) so the replay starts from the same
+         *        state and assigns the same tracker ids.
+         * @param sessionRecorder recorder, its header is written here; nullptr stops recording
+         */
+        void setRecorder(SessionRecorder::Ptr sessionRecorder);
+
+        /**
+         * @brief serialize the complete tracker state into a compact versioned binary blob: configuration, frame
+         *        count, the tracker id counter and every tracker (Kalman state and covariance, match counters, id,
+         *        appearance gallery, event stream state). the pre-filter, the recorder, the trajectory histories
+         *        and the dormant tracks are not part of it.
+         * @param blob output, replaced
+         */
+        void saveState(std::vector<uint8_t> &blob) const;
+
+        /**
+         * @brief restore a state written by saveState, e.g. by a restarted process or a hot standby taking over
+         *        mid-stream. the trackers keep their ids and the id counter is raised to the saved one if lower.
+         *        the dormant tracks are dropped.
+         * @param blob state blob
+         * @throws std::runtime_error on an invalid blob, a blob of another motion model or, in the fixed-capacity
+         *         mode, with more trackers than maxTracks; the tracker is then unchanged
+         */
+        void restoreState(std::vector<uint8_t> const &blob);
+
+    private:
+        /**
+         * @param bboxesPost optional output matrix, nullptr skips building it
+         * @param eventsOut optional event output, nullptr skips the events
+         */
+        void updateImpl(cv::Mat const &bboxesInput, cv::Mat const &embeddingsInput, cv::Mat *bboxesPost,
+                        vector<TrackEvent> *eventsOut);
+
+        /**
+         * @brief first stage of an update: statistics, recording and pre-filter. the trackers are predicted next.
+         * @param bboxesPost optional output matrix, nullptr skips building it
+         * @param eventsOut optional event output, nullptr skips the events
+         */
+        void beginUpdate(cv::Mat const &bboxesInput, cv::Mat const &embeddingsInput, cv::Mat *bboxesPost,
+                         vector<TrackEvent> *eventsOut);
+
+        /**
+         * @brief second stage, once every tracker is predicted: removes the trackers with a NaN prediction, then
+         *        associates. the trackers of matchedDetPred are corrected next with their detection rows of
+         *        stage.bboxesDet.
+         */
+        void associateTracks();
+
+        /**
+         * @brief last stage, once the matched trackers are corrected: track bookkeeping, removal, revival and
+         *        creation, snapshot and output
+         */
+        void endUpdate();
+
+        /**
+         * @brief publish the current tracks in a snapshot, skipped if every snapshot slot is held by readers
+         */
+        void publishSnapshot();
+
+        /**
+         * @brief new tracker for a detection, taken from the pool in the fixed-capacity mode
+         * @param bbox detection, Mat(1, 6)
+         * @param trackerId id of a revived dormant track, -1 takes the next id
+         */
+        typename Tracker::Ptr createTracker(cv::Mat const &bbox, int trackerId = -1);
+
+        /**
+         * @brief add a corrected box to the trajectory of a tracker, its buffer is resized to historyLength if needed
+         * @param bbox [xc, yc, w, h, ...]
+         * @param timestamp start of the update, steady clock nanoseconds
+         */
+        void recordTrajectory(Tracker &tracker, float const *bbox, int64_t timestamp);
+
+        /**
+         * @brief fixed-capacity mode: top up or trim the pool so that pooled and live trackers make maxTracks
+         */
+        void refillPool();
+    };
+
+    using ObjectTracker = ObjectTrackerT<ConstantVelocityModel>;
+
+    extern template class ObjectTrackerT<ConstantVelocityModel>;
+
+    extern template class ObjectTrackerT<ConstantAccelerationModel>;
+
+    extern template class ObjectTrackerT<XywhVelocityModel>;
+}
@@ -0,0 +1,113 @@
+/**
+ * @desc:   offline batch tracking of recorded sequences, where throughput and quality matter more than latency.
+ *          the SORT forward pass (ObjectTrackerT) runs over the whole sequence and records the filtered state of
+ *          every tracker in every frame; then every finished track is smoothed by a Rauch-Tung-Striebel backward
+ *          pass with the same motion model (KalmanBoxTrackerT::smooth). the tracks are smoothed in parallel, and
+ *          whole archives run their sequences in parallel, with cv::parallel_for_.
+ *          the smoothed trajectories are returned in a columnar table.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <ObjectTracking/KalmanBoxTracker.h>
+#include <ObjectTracking/MotionModels.h>
+
+namespace ObjectTracking {
+    /**
+     * @brief smoothed trajectories, one row per track and frame, stored column by column.
+     *        rows are grouped by track, tracks in creation order, and sorted by frame within a track.
+     */
+    struct TrackTable {
+        std::vector<int> trackerId;
+        std::vector<int> frame;                 // frame f is the detection matrix at index f - 1 of the sequence
+        std::vector<float> xc, yc, w, h;
+        std::vector<float> dx, dy;              // velocity of the box center
+        std::vector<float> score, classId;      // of the last matched detection
+        std::vector<uint8_t> observed;          // 1 if matched in this frame, 0 if bridged by the smoother
+        std::vector<int> trackOffsets{0};       // rows of track t are [trackOffsets[t], trackOffsets[t + 1])
+
+        [[nodiscard]] int size() const;
+
+        [[nodiscard]] int getNumTracks() const;
+
+        /**
+         * @brief resize all the row columns
+         */
+        void resize(int rows);
+    };
+
+    template<class MotionModel>
+    class OfflineTrackerT {
+        // variables
+    public:
+        using Ptr = std::shared_ptr<OfflineTrackerT>;
+        using Tracker = KalmanBoxTrackerT<MotionModel>;
+    private:
+        int maxAge;         // tracker's maximal unmatch count
+        int minHits;        // tracker's minimal match count
+        float iouThresh;    // IoU threshold
+
+        /**
+         * @brief filtered states of one tracker, one entry per frame from its creation on
+         */
+        struct TrackHistory {
+            int trackerId = -1;
+            int firstFrame = 0;
+            int length = 0;             // frames up to the last matched one, the coasting tail is dropped
+            bool confirmed = false;     // output by the online tracker at least once
+            std::vector<typename Tracker::StateVec> x;
+            std::vector<typename Tracker::StateMat> P;
+            std::vector<float> score, classId;
+            std::vector<uint8_t> observed;
+        };
+
+        // methods
+    public:
+        /**
+         * @param maxAge, minHits, iouThresh forward pass parameters, see ObjectTrackerT
+         */
+        explicit OfflineTrackerT(int maxAge = 1, int minHits = 3, float iouThresh = 0.3);
+
+        virtual ~OfflineTrackerT();
+
+        OfflineTrackerT(OfflineTrackerT const &) = delete;
+
+        OfflineTrackerT &operator=(OfflineTrackerT const &) = delete;
+
+        /**
+         * @brief track and smooth a sequence. only the tracks confirmed by the forward pass are returned, from their
+         *        first to their last matched frame, including their tentative start; unmatched frames in between are
+         *        bridged by the smoother. tracker ids come from the global tracker id counter.
+         * @param frames detections per frame, Mat(M, 6) [xc, yc, w, h, score, class_id], frame f at index f - 1
+         * @return smoothed tracks
+         */
+        [[nodiscard]] TrackTable process(std::vector<cv::Mat> const &frames) const;
+
+        /**
+         * @brief track and smooth independent sequences in parallel, e.g. a whole archive. every sequence runs its own
+         *        forward pass, the tracker ids are unique across the sequences.
+         * @param sequences detections per frame of every sequence, see process(frames)
+         * @return one table per sequence
+         */
+        [[nodiscard]] std::vector<TrackTable> process(std::vector<std::vector<cv::Mat>> const &sequences) const;
+
+    private:
+        /**
+         * @brief smooth a track and write its rows
+         * @param row first row of the track in the table
+         */
+        static void writeTrack(TrackHistory &history, TrackTable &table, int row);
+    };
+
+    using OfflineTracker = OfflineTrackerT<ConstantVelocityModel>;
+
+    extern template class OfflineTrackerT<ConstantVelocityModel>;
+
+    extern template class OfflineTrackerT<ConstantAccelerationModel>;
+
+    extern template class OfflineTrackerT<XywhVelocityModel>;
+}
@@ -0,0 +1,174 @@
+/**
+ * @desc:   binary session log of the tracker input, to replay production sessions offline.
+ *          SessionRecorder appends the configuration once, then the detections, embeddings and timestamp of every
+ *          update, with the assignment strategies it used so that a replay does not depend on the timings of the cost
+ *          model. the tracking thread only appends the frame to an in-memory buffer; a writer thread swaps the buffer
+ *          and writes it to the file, so no file I/O happens on the hot path. if the writer falls behind by more than
+ *          the buffer limit, frames are dropped (and counted) instead of blocking the tracking thread; the frame
+ *          numbers of the log then have gaps, from which the replay diverges.
+ *          SessionReader reads a log back frame by frame.
+ *
+ *          layout, native endianness:
+ *              header  char[4] "OTRS", uint32 version, char[32] motion model name, int32 maxAge, int32 minHits,
+ *                      float iouThresh, int32 firstTrackerId, int32 hasPreFilter, float scoreThresh,
+ *                      float nmsIouThresh, int32 classAware, int32 galleryCapacity, float iouWeight,
+ *                      float maxCosineDistance, int32 quantized, int32 maxDormantAge, float dormant iouThresh,
+ *                      int32 dormant classAware, float cascadeScoreThresh, float cascadeLowIouThresh,
+ *                      int32 assignment policy, int32 exploreInterval, int32 n, double[n] assignment cost model
+ *                      estimates, int32 maxTracks, int32 maxDetections
+ *              frame   int32 frame, int64 timestamp (ns), int32 rows, int32 cols, float[rows * cols] detections,
+ *                      int32 rows, int32 cols, float[rows * cols] embeddings (0 rows without), int32 n,
+ *                      int32[n] assignment strategies of the update
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <ObjectTracking/Appearance.h>
+#include <ObjectTracking/AssignmentPlanner.h>
+#include <ObjectTracking/DormantTracks.h>
+
+namespace ObjectTracking {
+    /**
+     * @brief tracker configuration stored at the beginning of a session log
+     */
+    struct SessionConfig {
+        std::string motionModel;    // MotionModel::name
+        int maxAge = 1;
+        int minHits = 3;
+        float iouThresh = 0.3f;
+        int firstTrackerId = 0;     // KalmanBoxTrackerBase::getFilterCount() when the recording started
+        bool hasPreFilter = false;  // the ROI / exclusion masks of the pre-filter are not recorded
+        float scoreThresh = 0;
+        float nmsIouThresh = 1;
+        bool classAware = true;
+        AppearanceParams appearance;    // used by the updates with embeddings
+        DormantParams dormant;
+        float cascadeScoreThresh = 0;   // CascadeParams, 0 disables the cascade
+        float cascadeLowIouThresh = 0.5f;
+        AssignmentParams assignment;
+        std::vector<double> assignmentCalibration;  // cost model when the recording started, empty for the defaults
+        int maxTracks = 0;          // TrackerCapacity of the fixed-capacity mode, 0 without
+        int maxDetections = 0;
+    };
+
+    class SessionRecorder {
+        // variables
+    public:
+        using Ptr = std::shared_ptr<SessionRecorder>;
+    private:
+        std::FILE *file = nullptr;
+        size_t maxBufferedBytes;
+        std::vector<char> active;       // frames appended by the tracking thread
+        std::vector<char> writing;      // frames being written by the writer thread
+        std::mutex mutex;
+        std::condition_variable wakeUp, written;
+        bool stopping = false;
+        bool started = false;
+        std::atomic<uint64_t> numRecorded{0}, numDropped{0};
+        std::thread writer;
+
+        // methods
+    public:
+        /**
+         * @param path log file, truncated
+         * @param maxBufferedBytes frames are dropped while this many bytes wait to be written
+         * @throws std::runtime_error if the file can not be opened
+         */
+        explicit SessionRecorder(std::string const &path, size_t maxBufferedBytes = 64u << 20u);
+
+        /**
+         * @brief writes the remaining frames and closes the file
+         */
+        virtual ~SessionRecorder();
+
+        SessionRecorder(SessionRecorder const &) = delete;
+
+        SessionRecorder &operator=(SessionRecorder const &) = delete;
+
+        /**
+         * @brief write the header, must be called once before the first record
+         */
+        void begin(SessionConfig const &config);
+
+        /**
+         * @brief append the input of one update, or count it as dropped if the writer is too far behind
+         * @param frame tracker frame count
+         * @param timestamp frame timestamp in nanoseconds
+         * @param bboxesDet detections given to update, Mat(M, 6)
+         * @param embeddings embeddings given to update, Mat(M, dim) CV_32F, empty without
+         * @param strategies strategies of its assignment solves, see ObjectTrackerBase::getLastAssignmentStrategies
+         */
+        void record(int frame, int64_t timestamp, cv::Mat const &bboxesDet, cv::Mat const &embeddings = cv::Mat(),
+                    std::vector<AssignmentStrategy> const &strategies = {});
+
+        /**
+         * @brief block until all the recorded frames are written
+         */
+        void flush();
+
+        [[nodiscard]] uint64_t getRecordedCount() const;
+
+        [[nodiscard]] uint64_t getDroppedCount() const;
+
+    private:
+        void append(void const *data, size_t bytes);
+
+        void run();
+    };
+
+    class SessionReader {
+        // variables
+    public:
+        using Ptr = std::shared_ptr<SessionReader>;
+
+        struct Frame {
+            int frame = 0;
+            int64_t timestamp = 0;
+            cv::Mat bboxesDet;
+            cv::Mat embeddings;     // empty for an update without embeddings
+            std::vector<AssignmentStrategy> strategies;     // see ObjectTrackerBase::forceAssignmentStrategies
+        };
+
+    private:
+        std::FILE *file = nullptr;
+        SessionConfig config;
+
+        // methods
+    public:
+        /**
+         * @throws std::runtime_error if the file can not be opened or is not a session log of this version
+         */
+        explicit SessionReader(std::string const &path);
+
+        virtual ~SessionReader();
+
+        SessionReader(SessionReader const &) = delete;
+
+        SessionReader &operator=(SessionReader const &) = delete;
+
+        [[nodiscard]] SessionConfig const &getConfig() const;
+
+        /**
+         * @brief read the next frame
+         * @return false at the end of the log or on a truncated frame
+         */
+        bool next(Frame &frame);
+
+    private:
+        /**
+         * @brief read a rows x cols float matrix into matrix
+         * @return false on a truncated matrix
+         */
+        bool readMatrix(int rows, int cols, cv::Mat &matrix);
+    };
+}
@@ -0,0 +1,191 @@
+/**
+ * @desc:   zero-copy transport of the tracker output to other processes through POSIX shared memory.
+ *          the segment holds a header and a ring of frame slots with a fixed binary layout (below). every slot is a
+ *          seqlock: its sequence is odd while the publisher writes it, and 2 * (frame sequence + 1) once complete.
+ *          readers map the segment read-only and read the slots in place; after using a frame they re-check the
+ *          slot sequence to know whether it was overwritten meanwhile. no syscall nor lock on the hot path.
+ *
+ *          layout, little endian, offsets in bytes:
+ *              ShmHeader                       0
+ *              slot k                          sizeof(ShmHeader) + k * slotBytes
+ *                  ShmSlotHeader               0
+ *                  ShmTrack[maxTracks]         sizeof(ShmSlotHeader)
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <ObjectTracking/TrackSnapshot.h>
+
+namespace ObjectTracking {
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "the shared memory seqlock needs lock-free 64-bit atomics");
+
+    constexpr uint32_t SHM_MAGIC = 0x4f54524b;  // "OTRK"
+    constexpr uint32_t SHM_VERSION = 1;
+
+    struct ShmHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t numSlots;
+        uint32_t maxTracks;             // track capacity of a slot
+        uint64_t slotBytes;
+        std::atomic<uint64_t> published;    // number of published frames, the latest one is published - 1
+        uint64_t reserved[2];
+    };
+
+    struct ShmSlotHeader {
+        std::atomic<uint64_t> sequence;     // seqlock, odd while written, 2 * (frame sequence + 1) when complete
+        int32_t frame;                  // tracker frame count
+        uint32_t numTracks;
+        uint32_t numDropped;            // tracks that did not fit in the slot
+        uint32_t reserved;
+        int64_t timestamp;              // publisher steady clock, nanoseconds
+    };
+
+    struct ShmTrack {
+        int32_t trackerId;
+        float xc, yc, w, h;
+        float score;
+        float classId;
+        float dx, dy;
+        uint32_t flags;                 // ShmTrack::CONFIRMED
+        static constexpr uint32_t CONFIRMED = 1;
+    };
+
+    static_assert(sizeof(ShmHeader) == 48 && sizeof(ShmSlotHeader) == 32 && sizeof(ShmTrack) == 40,
+                  "the shared memory layout must not change silently");
+
+    /**
+     * @brief writer side, creates (or replaces) the shared memory segment
+     */
+    class ShmTrackPublisher {
+        // variables
+    public:
+        using Ptr = std::shared_ptr<ShmTrackPublisher>;
+    private:
+        std::string name;
+        void *mapping = nullptr;
+        size_t mappingBytes = 0;
+        ShmHeader *header = nullptr;
+        uint64_t next = 0;              // sequence of the next published frame
+
+        // methods
+    public:
+        /**
+         * @param name shared memory object name, "/name"
+         * @param numSlots number of frames in the ring, readers lagging more than that miss frames
+         * @param maxTracks track capacity of a frame
+         * @throws std::runtime_error if the segment can not be created
+         */
+        ShmTrackPublisher(std::string name, int numSlots = 16, int maxTracks = 256);
+
+        virtual ~ShmTrackPublisher();
+
+        ShmTrackPublisher(ShmTrackPublisher const &) = delete;
+
+        ShmTrackPublisher &operator=(ShmTrackPublisher const &) = delete;
+
+        /**
+         * @brief publish the output of ObjectTracker::update
+         * @param bboxesPost Mat(N, 9) [[xc,yc,w,h,score,class_id,dx,dy,tracker_id];[...];...]
+         * @param frame frame number stored with the tracks
+         */
+        void publish(cv::Mat const &bboxesPost, int frame);
+
+        /**
+         * @brief publish a track snapshot (all live tracks, confirmed flag set for the output ones)
+         */
+        void publish(TrackSnapshot const &snapshot);
+
+        [[nodiscard]] uint64_t getPublishedCount() const;
+
+    private:
+        ShmSlotHeader *beginFrame(int frame);
+
+        void endFrame(ShmSlotHeader *slot, uint32_t numTracks, uint32_t numDropped);
+
+        [[nodiscard]] ShmTrack *getTracks(ShmSlotHeader *slot) const;
+    };
+
+    /**
+     * @brief reader side, maps an existing segment read-only
+     */
+    class ShmTrackReader {
+        // variables
+    public:
+        using Ptr = std::shared_ptr<ShmTrackReader>;
+
+        /**
+         * @brief frame read in place from the shared memory
+         */
+        struct FrameView {
+            uint64_t sequence = 0;      // frame sequence, 0 for the first published frame
+            int32_t frame = 0;
+            int64_t timestamp = 0;
+            uint32_t numTracks = 0;
+            uint32_t numDropped = 0;
+            ShmTrack const *tracks = nullptr;
+            ShmSlotHeader const *slot = nullptr;
+        };
+
+    private:
+        void const *mapping = nullptr;
+        size_t mappingBytes = 0;
+        ShmHeader const *header = nullptr;
+
+        // methods
+    public:
+        /**
+         * @param name shared memory object name given to the publisher
+         * @throws std::runtime_error if the segment does not exist or has an incompatible layout
+         */
+        explicit ShmTrackReader(std::string const &name);
+
+        virtual ~ShmTrackReader();
+
+        ShmTrackReader(ShmTrackReader const &) = delete;
+
+        ShmTrackReader &operator=(ShmTrackReader const &) = delete;
+
+        /**
+         * @brief number of frames published so far
+         */
+        [[nodiscard]] uint64_t getPublishedCount() const;
+
+        /**
+         * @brief view a published frame in place
+         * @param sequence frame sequence, in [published - numSlots, published)
+         * @param view output, valid until the publisher wraps around the ring, check with isValid after use
+         * @return false if the frame is not published yet, already overwritten or being written
+         */
+        bool view(uint64_t sequence, FrameView &view) const;
+
+        /**
+         * @brief view the latest published frame in place
+         */
+        bool viewLatest(FrameView &view) const;
+
+        /**
+         * @brief whether a viewed frame is still intact, call it after reading the view to validate what was read
+         */
+        [[nodiscard]] bool isValid(FrameView const &view) const;
+
+        /**
+         * @brief consistent copy of a frame
+         * @return false if the frame is not available (see view)
+         */
+        bool copy(uint64_t sequence, FrameView &view, std::vector<ShmTrack> &tracks) const;
+
+        [[nodiscard]] int getNumSlots() const;
+
+        [[nodiscard]] int getMaxTracks() const;
+
+    private:
+        [[nodiscard]] ShmSlotHeader const *getSlot(uint64_t sequence) const;
+    };
+}
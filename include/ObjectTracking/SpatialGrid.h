@@ -0,0 +1,106 @@
+/**
+ * @desc:   uniform grid index over axis aligned boxes.
+ *          the grid is unbounded (cells are hashed by their integer coordinates) and updated incrementally:
+ *          moving an item only touches the grid cells when its cell range changes.
+ *          items covering more than maxCellsPerItem cells (e.g. diverged predictions) are not spread over the grid
+ *          but kept in a separate list that every query checks.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <opencv2/core.hpp>
+
+namespace ObjectTracking {
+    class SpatialGrid {
+        // variables
+    public:
+        using Ptr = std::shared_ptr<SpatialGrid>;
+    private:
+        struct CellRange {
+            int x0, y0, x1, y1;     // inclusive cell coordinates
+            bool oversized;         // too many cells, item is in the oversized list instead
+
+            bool operator==(CellRange const &other) const {
+                return x0 == other.x0 && y0 == other.y0 && x1 == other.x1 && y1 == other.y1 &&
+                       oversized == other.oversized;
+            }
+        };
+
+        struct Item {
+            cv::Rect2f rect;
+            CellRange cells;
+            unsigned queryStamp;            // last query which reported this item, avoids duplicates
+        };
+
+        static int64_t const maxCellsPerItem;
+
+        float cellSize;
+        std::unordered_map<int64_t, std::vector<int>> cells;
+        std::vector<int> oversized;
+        std::unordered_map<int, Item> items;
+        unsigned queryStamp = 0;
+
+        // methods
+    public:
+        /**
+         * @brief grid index
+         * @param cellSize width and height of a grid cell, best around the typical box size
+         */
+        explicit SpatialGrid(float cellSize = 128);
+
+        virtual ~SpatialGrid();
+
+        /**
+         * @brief insert an item or move it if the key is already indexed
+         * @param key item key
+         * @param rect item box
+         */
+        void set(int key, cv::Rect2f const &rect);
+
+        /**
+         * @brief remove an item, does nothing for keys not indexed
+         * @param key item key
+         */
+        void remove(int key);
+
+        void clear();
+
+        /**
+         * @brief find the items overlapping a region. not const: the items are stamped with the query to report
+         *        them once, so queries must not run concurrently with each other or with the updates.
+         * @param region query region
+         * @param keys output, keys of the items whose box overlaps the region with a positive area, each key is
+         *             appended once
+         */
+        void query(cv::Rect2f const &region, std::vector<int> &keys);
+
+        [[nodiscard]] size_t size() const;
+
+        [[nodiscard]] float getCellSize() const;
+
+        /**
+         * @return estimated bytes of the cells and items, hash nodes and buckets included
+         */
+        [[nodiscard]] size_t getMemoryBytes() const;
+
+        /**
+         * @brief drop the empty cells, which are otherwise kept for reuse, and release the unused storage
+         */
+        void shrink();
+
+    private:
+        [[nodiscard]] CellRange getCellRange(cv::Rect2f const &rect) const;
+
+        void addToCells(int key, CellRange const &range);
+
+        void removeFromCells(int key, CellRange const &range);
+
+        static int64_t getCellKey(int x, int y);
+
+        static bool overlaps(cv::Rect2f const &a, cv::Rect2f const &b);
+    };
+}
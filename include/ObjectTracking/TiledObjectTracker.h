@@ -0,0 +1,96 @@
+/**
+ * @desc:   spatially tiled SORT for very high-resolution frames.
+ *          the frame is partitioned into a grid of core tiles, every tile runs its own ObjectTracker on the
+ *          detections inside its core region extended by an overlap margin, and the tiles are updated in parallel.
+ *          a track is reported only by the tile whose core contains its center; when a track crosses into another
+ *          tile's core, the new owner's local track inherits the global id of the previous owner (handoff).
+ *          the overlap should cover the distance an object travels during the minHits confirmation frames, so the
+ *          receiving tile has a confirmed track by the time the object enters its core.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <ObjectTracking/ObjectTracker.h>
+
+namespace ObjectTracking {
+    class TiledObjectTracker {
+        // variables
+    public:
+        using Ptr = std::shared_ptr<TiledObjectTracker>;
+    private:
+        struct Tile {
+            ObjectTracker::Ptr tracker;
+            cv::Mat bboxesDet;          // this frame's detections, Mat(M, 6)
+            cv::Mat bboxesPost;         // this frame's tracker output, Mat(N, 9), local tracker ids
+        };
+
+        struct GlobalTrack {
+            int globalId;
+            int lastFrame;
+        };
+
+        cv::Size frameSize;
+        cv::Size tileGrid;          // tile columns, tile rows
+        float overlap;              // overlap margin in pixels
+        float handoffIouThresh;     // minimal IoU between the previous global box and the new owner's box
+        vector<Tile> tiles;
+        std::map<pair<int, int>, GlobalTrack> localToGlobal;    // (tile, local tracker id) -> global id
+        cv::Mat previousBboxesPost; // last frame's merged output, Mat(N, 9), global tracker ids
+        int nextGlobalId = 0;
+        int frameCount = 0;
+        int maxUnreportedFrames;    // frames after which a local track not reported anymore is surely dead
+
+        // methods
+    public:
+        /**
+         * @brief tiled tracker
+         * @param frameSize         size of the full frame
+         * @param tileGrid          number of tile columns (width) and rows (height)
+         * @param overlap           overlap margin of the tiles in pixels
+         * @param maxAge            tracker's maximal unmatch count, see ObjectTracker
+         * @param minHits           tracker's minimal match count, see ObjectTracker
+         * @param iouThresh         IoU threshold, see ObjectTracker
+         * @param handoffIouThresh  minimal IoU to hand a track over from one tile to another
+         */
+        TiledObjectTracker(cv::Size const &frameSize, cv::Size const &tileGrid, float overlap,
+                           int maxAge = 1, int minHits = 3, float iouThresh = 0.3, float handoffIouThresh = 0.3);
+
+        virtual ~TiledObjectTracker();
+
+        TiledObjectTracker(const TiledObjectTracker &) = delete;
+
+        TiledObjectTracker &operator=(const TiledObjectTracker &) = delete;
+
+        /**
+         * @brief bbox tracking over all tiles, same contract as ObjectTracker::update.
+         * @param bboxesDet detections, Mat(M, 6) with the format [[xc,yc,w,h,score,class_id];[...];...]
+         * @return matched bboxes, Mat(N, 9) with the format [[xc,yc,w,h,score,class_id,dx,dy,tracker_id];[...];...],
+         *         tracker_id being unique over all tiles.
+         */
+        cv::Mat update(cv::Mat const &bboxesDet);
+
+        [[nodiscard]] int getTileCount() const;
+
+    private:
+        /**
+         * @brief index of the tile whose core contains the point, points outside the frame are clamped to it.
+         */
+        [[nodiscard]] int getOwnerTile(float x, float y) const;
+
+        /**
+         * @brief IoU of two bboxes
+         * @param a bbox [xc, yc, w, h, ...]
+         * @param b bbox [xc, yc, w, h, ...]
+         */
+        static float getIou(float const *a, float const *b);
+
+        /**
+         * @brief map the owned tracks of all tiles to global ids.
+         * @param owned (tile index, row in the tile's output) of every owned track, in tile order
+         * @param bboxesPost merged output, tracker ids are overwritten with the global ids
+         */
+        void assignGlobalIds(vector<pair<int, int>> const &owned, cv::Mat &bboxesPost);
+    };
+}
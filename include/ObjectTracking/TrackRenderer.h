@@ -0,0 +1,141 @@
+/**
+ * @desc:   overlay renderer drawing track snapshots off the tracking thread. submit copies the frame and the confirmed
+ *          tracks of a snapshot into a buffer of a small pool and returns; a worker thread draws the boxes, the id
+ *          labels and the velocity arrows into that buffer, then hands it to the optional sink and keeps it as the
+ *          latest rendered frame for takeLatest. submit never waits for the worker: when every buffer is in use the
+ *          frame is dropped. the id labels are rendered once per track and blended from a cache afterwards, and a
+ *          reduced-cost mode draws only the boxes and / or renders one submitted frame out of n.
+ *          the colors are the ones of ObjectTrackerBase::draw.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <ObjectTracking/FlatIdMap.h>
+#include <ObjectTracking/TrackSnapshot.h>
+
+namespace ObjectTracking {
+    /**
+     * @brief renderer parameters, the reduced-cost mode is boxesOnly and / or decimation > 1
+     */
+    struct RenderParams {
+        bool boxesOnly = false;     // no labels and velocity arrows
+        bool withScore = false;     // label "id: score" instead of "id"
+        int decimation = 1;         // render one submitted frame out of decimation, the others are skipped
+        int maxLabels = 1024;       // cached id labels, the cache is emptied when full
+    };
+
+    /**
+     * @brief renderer counters since the construction
+     */
+    struct RenderStats {
+        long submitted = 0;     // submit calls
+        long skipped = 0;       // frames not rendered because of the decimation
+        long dropped = 0;       // frames not rendered because every buffer was in use
+        long rendered = 0;
+        double renderTime = 0;  // ms, drawing of the last rendered frame
+    };
+
+    class TrackRenderer {
+        // variables
+    public:
+        using Ptr = std::shared_ptr<TrackRenderer>;
+        /**
+         * @brief called on the worker thread with every rendered frame, the image is only valid during the call
+         */
+        using Sink = std::function<void(cv::Mat const &image, int frame)>;
+    private:
+        struct Buffer {
+            cv::Mat image;
+            std::vector<TrackState> tracks;     // confirmed tracks of the snapshot
+            int frame = 0;
+        };
+
+        struct Label {
+            cv::Mat image, mask;
+            cv::Point offset;       // top-left corner relative to the text origin (bottom-left of the text)
+        };
+
+        RenderParams params;
+        Sink sink;
+        std::vector<Buffer> buffers;
+        std::vector<int> freeBuffers;
+        std::vector<int> pending;   // buffers to render, in submission order
+        int latest = -1;            // latest rendered buffer, -1 if none or taken
+        FlatIdMap<Label> labels;    // worker only, tracker id -> rendered label
+        RenderStats stats;
+        std::mutex mutex;
+        std::condition_variable jobAvailable, idle;
+        bool rendering = false;     // the worker is drawing a buffer taken from pending
+        bool stopping = false;
+        std::thread worker;
+
+        // methods
+    public:
+        /**
+         * @param numBuffers frame buffers of the pool, >= 2: one is kept as the latest rendered frame
+         * @param sink optional, called on the worker thread with every rendered frame
+         */
+        explicit TrackRenderer(RenderParams const &params = RenderParams(), int numBuffers = 3, Sink sink = nullptr);
+
+        /**
+         * @brief renders the frames already submitted, then stops the worker
+         */
+        virtual ~TrackRenderer();
+
+        TrackRenderer(TrackRenderer const &) = delete;
+
+        TrackRenderer &operator=(TrackRenderer const &) = delete;
+
+        /**
+         * @brief queue a frame for rendering, never waits for the worker. once the buffers have the frame size and
+         *        the capacity of the tracks, no allocation happens here nor on the worker (except for new labels).
+         * @param frame image to draw on, CV_8UC3, copied
+         * @param snapshot tracks to draw, its confirmed tracks are copied; the snapshot may be released right after
+         * @return false if the frame is skipped (decimation) or dropped (every buffer in use)
+         */
+        bool submit(cv::Mat const &frame, TrackSnapshot const &snapshot);
+
+        /**
+         * @brief take the latest rendered frame not taken yet, by swapping buffers: image receives the rendered frame
+         *        and its previous content is recycled into the pool, so passing the same Mat every time avoids
+         *        allocations. image must not be shared with other Mats.
+         * @param frame optional output, frame of the snapshot of the rendered image
+         * @return false if no frame was rendered since the last call, image is then unchanged
+         */
+        bool takeLatest(cv::Mat &image, int *frame = nullptr);
+
+        /**
+         * @brief block until all the submitted frames are rendered
+         */
+        void flush();
+
+        [[nodiscard]] RenderStats getStats();
+
+        [[nodiscard]] RenderParams const &getParams() const;
+
+    private:
+        void run();
+
+        /**
+         * @brief worker only: draw the tracks on an image
+         */
+        void draw(cv::Mat &image, std::vector<TrackState> const &tracks);
+
+        /**
+         * @return cached label of a tracker, rendered if missing
+         */
+        Label const &getLabel(int trackerId);
+
+        /**
+         * @brief blend a label with its text origin at origin, clipped to the image
+         */
+        static void blendLabel(cv::Mat &image, Label const &label, cv::Point origin);
+    };
+}
@@ -0,0 +1,154 @@
+/**
+ * @desc:   immutable track snapshots published by the tracking thread and read concurrently by any number of threads.
+ *          snapshots live in a small pool of slots, each with an atomic reader count. the writer fills a slot that
+ *          is neither current nor read, then publishes it with a single atomic store of the current slot index.
+ *          readers pin the current slot by incrementing its reader count and re-checking the index (lock-free,
+ *          no copy). the writer never blocks: if every slot is pinned the publication of that frame is skipped.
+ *          a snapshot also carries the motion of its tracks and the update times, so that readers can sample the
+ *          boxes at any time between and after the updates (TrackSnapshot::sample) without running the tracker.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ObjectTracking {
+    /**
+     * @brief state of one track in a snapshot
+     */
+    struct TrackState {
+        int trackerId;
+        float xc, yc, w, h;     // current box, corrected if matched in the frame, predicted otherwise
+        float dx, dy;           // velocity
+        float score;            // score of the last matched detection
+        float classId;          // class of the last matched detection
+        int hitStreak;
+        int timeSinceUpdate;
+        bool confirmed;         // in the tracker output of the frame
+        float prevXc, prevYc, prevW, prevH; // box at the end of the previous update, the current box for a new track
+        float dz[4], ddz[4];    // velocity and acceleration per frame of the motion model measurement (see areaRatio)
+    };
+
+    /**
+     * @brief box of a confirmed track sampled at a given time
+     */
+    struct TrackSample {
+        int trackerId;
+        float xc, yc, w, h;
+        float score;
+        float classId;
+    };
+
+    struct TrackSnapshot {
+        int frame = 0;          // TrackerStats::frameCount of the update publishing the snapshot
+        int64_t timestamp = 0;      // start of the update, steady clock nanoseconds
+        int64_t prevTimestamp = 0;  // start of the previous update, timestamp for the first update
+        double framePeriod = 0;     // smoothed interval between the updates in nanoseconds, 0 before the second one
+        bool areaRatio = false;     // the measurement is [xc, yc, area, aspect ratio] instead of [xc, yc, w, h]
+        std::vector<TrackState> tracks;
+
+        /**
+         * @brief boxes of the confirmed tracks at a given time, in closed form: between the previous and this update
+         *        the boxes are interpolated linearly from prevXc.. to xc.., after this update they are extrapolated
+         *        with the motion model, z + dz*k + ddz*k^2/2 for k frames (framePeriod). never allocates once
+         *        samples has the capacity of the tracks.
+         * @param time steady clock nanoseconds, e.g. the display time of the samples
+         * @param maxExtrapolation extrapolation horizon in frames, later times are sampled at the horizon
+         * @param samples output, cleared then filled in the order of the tracks
+         */
+        void sample(int64_t time, float maxExtrapolation, std::vector<TrackSample> &samples) const;
+    };
+
+    class SnapshotBuffer {
+        // variables
+    private:
+        struct Slot {
+            std::atomic<int> readers{0};
+            TrackSnapshot snapshot;
+        };
+
+        int numSlots;
+        std::unique_ptr<Slot[]> slots;
+        std::atomic<int> current{-1};   // published slot, -1 before the first publication
+        int writing = -1;               // slot being filled by the writer, -1 if none
+
+        // methods
+    public:
+        /**
+         * @brief read access to a published snapshot, the snapshot stays valid and unchanged while the handle lives
+         */
+        class Handle {
+            // variables
+        private:
+            Slot *slot = nullptr;
+
+            // methods
+        public:
+            Handle() = default;
+
+            explicit Handle(Slot *slot);
+
+            Handle(Handle &&other) noexcept;
+
+            Handle &operator=(Handle &&other) noexcept;
+
+            Handle(Handle const &) = delete;
+
+            Handle &operator=(Handle const &) = delete;
+
+            ~Handle();
+
+            /**
+             * @brief false if nothing was published yet
+             */
+            explicit operator bool() const;
+
+            TrackSnapshot const &operator*() const;
+
+            TrackSnapshot const *operator->() const;
+
+            void release();
+        };
+
+        /**
+         * @param numSlots number of snapshots in the pool, >= 2; readers holding handles for long need more slots
+         */
+        explicit SnapshotBuffer(int numSlots = 4);
+
+        virtual ~SnapshotBuffer();
+
+        SnapshotBuffer(SnapshotBuffer const &) = delete;
+
+        SnapshotBuffer &operator=(SnapshotBuffer const &) = delete;
+
+        /**
+         * @brief pin the latest published snapshot, thread-safe, never blocks the writer
+         * @return handle to the snapshot, empty if nothing was published yet
+         */
+        Handle acquire() const;
+
+        /**
+         * @brief writer only: get a free slot to fill, its previous content is kept so buffers are reused
+         * @return snapshot to fill, nullptr if every slot is pinned by readers (skip this publication)
+         */
+        TrackSnapshot *beginWrite();
+
+        /**
+         * @brief writer only: publish the snapshot returned by the last beginWrite
+         */
+        void publish();
+
+        /**
+         * @brief allocate room for maxTracks tracks in every slot, call it before any reader attaches
+         */
+        void reserve(size_t maxTracks);
+
+        /**
+         * @brief writer only: bytes of the track storage of all the slots
+         */
+        [[nodiscard]] size_t getMemoryBytes() const;
+    };
+}
@@ -0,0 +1,92 @@
+/**
+ * @desc:   bounded trajectory history of a track: the latest corrected boxes with their frame and timestamp, in a
+ *          fixed-capacity ring buffer (TrajectoryBuffer) kept by every tracker when enabled, see
+ *          ObjectTrackerT::setHistoryLength. the ring is mirrored (every point is written twice, capacity apart),
+ *          so the stored points are always one contiguous oldest-to-newest range and are read without copying.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ObjectTracking {
+    /**
+     * @brief corrected box of a track in one frame
+     */
+    struct TrajectoryPoint {
+        int frame;              // TrackerStats::frameCount of the update
+        int64_t timestamp;      // steady clock at the start of the update, nanoseconds
+        float xc, yc, w, h;
+    };
+
+    /**
+     * @brief read-only view of contiguous trajectory points, valid until the next update of the tracker
+     */
+    struct TrajectorySpan {
+        TrajectoryPoint const *points = nullptr;
+        size_t count = 0;
+
+        [[nodiscard]] TrajectoryPoint const *begin() const { return points; }
+
+        [[nodiscard]] TrajectoryPoint const *end() const { return points + count; }
+
+        [[nodiscard]] size_t size() const { return count; }
+
+        [[nodiscard]] bool empty() const { return count == 0; }
+
+        [[nodiscard]] TrajectoryPoint const &operator[](size_t i) const { return points[i]; }
+
+        [[nodiscard]] TrajectoryPoint const &front() const { return points[0]; }
+
+        [[nodiscard]] TrajectoryPoint const &back() const { return points[count - 1]; }
+    };
+
+    class TrajectoryBuffer {
+        // variables
+    private:
+        int cap = 0;
+        int count = 0, head = 0;                // stored points, next slot to write
+        std::vector<TrajectoryPoint> points;    // 2 x cap, slot i mirrored at i + cap
+
+        // methods
+    public:
+        TrajectoryBuffer();
+
+        virtual ~TrajectoryBuffer();
+
+        /**
+         * @brief clear the buffer and (re)allocate it
+         * @param capacity number of points kept, the oldest one is overwritten when full; 0 releases the storage
+         */
+        void reset(int capacity);
+
+        /**
+         * @brief drop the stored points, the storage is kept
+         */
+        void clear();
+
+        void push(TrajectoryPoint const &point);
+
+        [[nodiscard]] int size() const;
+
+        [[nodiscard]] int getCapacity() const;
+
+        /**
+         * @return bytes of the point storage
+         */
+        [[nodiscard]] size_t getMemoryBytes() const;
+
+        /**
+         * @brief stored points, oldest first
+         */
+        [[nodiscard]] TrajectorySpan getPoints() const;
+
+        /**
+         * @brief the latest points, oldest first
+         * @param n maximal number of points
+         */
+        [[nodiscard]] TrajectorySpan getLatest(int n) const;
+    };
+}
@@ -4,7 +4,10 @@
 #include <iostream>
 #include <map>
 
+#include <ObjectTracking/AsyncObjectTracker.h>
+#include <ObjectTracking/KeypointBoxConverter.h>
 #include <ObjectTracking/ObjectTracker.h>
+#include <ObjectTracking/TrackRenderer.h>
 
 #include <AndreiUtils/utils.hpp>
 #include <AndreiUtils/utilsFiles.h>
@@ -18,7 +21,13 @@ using namespace PerceptionData;
 using namespace std;
 using namespace VisualPerception;
 
+using ObjectTracking::AsyncObjectTracker;
+using ObjectTracking::DetectionPreFilter;
+using ObjectTracking::KeypointBoxConverter;
 using ObjectTracking::ObjectTracker;
+using ObjectTracking::RenderParams;
+using ObjectTracking::SnapshotBuffer;
+using ObjectTracking::TrackRenderer;
 
 vector<string> split(const string &s, char delim) {
     std::istringstream iss(s);
@@ -106,13 +115,20 @@ void oldDemo(int argc, char **argv) {
     // tracking
     cout << "Tracking..." << endl;
     ObjectTracker::Ptr mot = std::make_shared<ObjectTracker>(1, 3, 0.3f);
+    // the overlays are drawn on the renderer thread, the latest rendered frame is shown
+    TrackRenderer renderer;
+    Mat preview;
     cv::namedWindow("SORT", cv::WindowFlags::WINDOW_NORMAL);
     for (auto [image, boundingBoxesDetections]: motPairs) {
-        Mat trackedBoundingBoxes = mot->update(boundingBoxesDetections);
+        mot->update(boundingBoxesDetections);
 
         // show result
-        ObjectTracker::draw(image, trackedBoundingBoxes);
-        cv::imshow("SORT", image);
+        if (SnapshotBuffer::Handle snapshot = mot->getSnapshot()) {
+            renderer.submit(image, *snapshot);
+        }
+        if (renderer.takeLatest(preview)) {
+            cv::imshow("SORT", preview);
+        }
         cv::waitKey(int(3000.0 / fps));
     }
 
@@ -142,6 +158,20 @@ void demo() {
     cv::Mat *outputColorData;
     cout << std::setprecision(15);
     ObjectTracker::Ptr tracker = std::make_shared<ObjectTracker>(1, 3, 0.3f);
+    // drop duplicated skeletons of the same person before they reach the association
+    tracker->setPreFilter(std::make_shared<DetectionPreFilter>(0.0f, 0.7f));
+    // all the skeletons of a frame in one flat buffer [x, y, confidence], reused across frames
+    KeypointBoxConverter converter(0.0f, 1);
+    vector<float> keypoints, personScores;
+    // frame t is tracked on the tracking thread while the perception of frame t + 1 runs, its result is shown then
+    AsyncObjectTracker asyncTracker(tracker);
+    std::future<Mat> pendingTracks;
+    Mat pendingImage;
+    // the overlays of the tracked frames are drawn on the renderer thread, the latest rendered frame is shown
+    RenderParams renderParams;
+    renderParams.withScore = true;
+    TrackRenderer renderer(renderParams);
+    Mat preview;
     for (; exit == 0;) {
         // cout << "In while at " << count << endl;
         if (!p.perceptionIteration()) {
@@ -158,50 +188,56 @@ void demo() {
             cout << "No color data!" << endl;
             continue;
         }
-        auto const &imageSize = output.getInput<ColorData>()->getIntrinsics().size;
 
-        // N x 6; N = nr detected people ; 6 = [center_x, center_y, w, h, score, class]
-        cv::Mat detectionBoundingBoxes(0, 6, CV_32F);
+        keypoints.clear();
+        personScores.clear();
+        int numJoints = 0;
         for (auto const &device: output.getDevicesList()) {
             PerceptionDataContainer *deviceOutputContainer;
             if (output.getDeviceDataIfContains<PersonDetectionContainer>(deviceOutputContainer, device)) {
-                auto persons = *(PersonDetectionContainer *) deviceOutputContainer;
-                for (auto const &personData: persons) {
+                for (auto const &personData: *(PersonDetectionContainer *) deviceOutputContainer) {
                     auto const &skeletonKeypoints = personData.second.getSkeleton().getJointImagePositions();
-                    float minX = (float) imageSize.w, maxX = 0, minY = (float) imageSize.h, maxY = 0;
-                    // collect bounding box data from person
-                    for (auto const &keyPoint: skeletonKeypoints) {
-                        auto const &x = keyPoint.second.x();
-                        auto const &y = keyPoint.second.y();
-                        if (AndreiUtils::less(x, minX)) {
-                            minX = x;
-                        }
-                        if (AndreiUtils::greater(x, maxX)) {
-                            maxX = x;
-                        }
-                        if (AndreiUtils::less(y, minY)) {
-                            minY = y;
-                        }
-                        if (AndreiUtils::greater(y, maxY)) {
-                            maxY = y;
-                        }
+                    numJoints = std::max(numJoints, (int) skeletonKeypoints.size());
+                }
+            }
+        }
+        for (auto const &device: output.getDevicesList()) {
+            PerceptionDataContainer *deviceOutputContainer;
+            if (output.getDeviceDataIfContains<PersonDetectionContainer>(deviceOutputContainer, device)) {
+                for (auto const &personData: *(PersonDetectionContainer *) deviceOutputContainer) {
+                    // joints not in the skeleton stay at (0, 0) with a zero confidence, i.e. missing
+                    size_t offset = keypoints.size();
+                    keypoints.resize(offset + 3 * (size_t) numJoints, 0.0f);
+                    for (auto const &keyPoint: personData.second.getSkeleton().getJointImagePositions()) {
+                        keypoints[offset++] = (float) keyPoint.second.x();
+                        keypoints[offset++] = (float) keyPoint.second.y();
+                        keypoints[offset++] = 1.0f;
                     }
-                    float w = maxX - minX, h = maxY - minY;
-                    Mat bbox = (Mat_<float>(1, 6) << minX + w / 2, minY +
-                                                                   h / 2, w, h, personData.second.getConfidence(), 0);
-                    cv::vconcat(detectionBoundingBoxes, bbox, detectionBoundingBoxes);
+                    personScores.push_back((float) personData.second.getConfidence());
                 }
             }
         }
-        Mat trackedBoundingBoxes = tracker->update(detectionBoundingBoxes);
+        // render the result of the previous frame; it is waited for before submitting this frame, so the latest
+        // snapshot is the one of the previous frame
+        if (pendingTracks.valid()) {
+            pendingTracks.get();
+            if (SnapshotBuffer::Handle snapshot = tracker->getSnapshot()) {
+                renderer.submit(pendingImage, *snapshot);
+            }
+        }
+
+        // N x 6; N = nr detected people ; 6 = [center_x, center_y, w, h, score, class]
+        cv::Mat detectionBoundingBoxes = converter.convert(keypoints.data(), (int) personScores.size(),
+                                                           std::max(numJoints, 1), personScores.data());
+        pendingTracks = asyncTracker.submit(detectionBoundingBoxes);
 
         if (output.getOutputDataIfContains<ColorData>(outputColorData)) {
             imshow("Color - Output", *outputColorData);
         }
-
-        // show result
-        ObjectTracker::draw(*outputColorData, trackedBoundingBoxes, true);
-        cv::imshow("SORT RESULT", *outputColorData);
+        if (renderer.takeLatest(preview)) {
+            cv::imshow("SORT RESULT", preview);
+        }
+        outputColorData->copyTo(pendingImage);
 
         int key = cv::waitKey(1);
         if (key == 27 || key == 'q') {
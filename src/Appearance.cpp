@@ -0,0 +1,260 @@
+#include "ObjectTracking/Appearance.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <ObjectTracking/MemoryUsage.h>
+
+using namespace ObjectTracking;
+
+FeatureGallery::FeatureGallery() = default;
+
+FeatureGallery::~FeatureGallery() = default;
+
+void FeatureGallery::reset(int capacity, int dim, bool isQuantized) {
+    assert(capacity > 0 && dim > 0);
+    cap = capacity;
+    dimension = dim;
+    count = 0;
+    head = 0;
+    quantized = isQuantized;
+    if (quantized) {
+        features.clear();
+        quantizedFeatures.resize((size_t) cap * dimension);
+    } else {
+        quantizedFeatures.clear();
+        features.resize((size_t) cap * dimension);
+    }
+}
+
+void FeatureGallery::clear() {
+    count = 0;
+    head = 0;
+}
+
+void FeatureGallery::push(float const *feature) {
+    assert(cap > 0);
+    size_t offset = (size_t) head * dimension;
+    if (quantized) {
+        // normalization folded into the quantization, no float copy is needed
+        float scale = getNormScale(feature, dimension);
+        int8_t *out = quantizedFeatures.data() + offset;
+        for (int k = 0; k < dimension; ++k) {
+            out[k] = (int8_t) std::lround(std::clamp(feature[k] * scale, -1.0f, 1.0f) * 127.0f);
+        }
+    } else {
+        normalize(feature, features.data() + offset, dimension);
+    }
+    head = (head + 1) % cap;
+    count = std::min(count + 1, cap);
+}
+
+int FeatureGallery::size() const {
+    return count;
+}
+
+int FeatureGallery::getCapacity() const {
+    return cap;
+}
+
+int FeatureGallery::getDim() const {
+    return dimension;
+}
+
+size_t FeatureGallery::getMemoryBytes() const {
+    return memory_usage::capacityBytes(features) + memory_usage::capacityBytes(quantizedFeatures);
+}
+
+bool FeatureGallery::isQuantized() const {
+    return quantized;
+}
+
+float const *FeatureGallery::getFeatures() const {
+    return features.data();
+}
+
+int8_t const *FeatureGallery::getQuantizedFeatures() const {
+    return quantizedFeatures.data();
+}
+
+float FeatureGallery::getNormScale(float const *in, int dim) {
+    float sum = 0;
+    for (int k = 0; k < dim; ++k) {
+        sum += in[k] * in[k];
+    }
+    return sum > 0 ? 1.0f / std::sqrt(sum) : 0.0f;
+}
+
+void FeatureGallery::save(blob::Writer &writer) const {
+    writer.put((int32_t) cap);
+    writer.put((int32_t) dimension);
+    writer.put((int32_t) count);
+    writer.put((int32_t) head);
+    writer.put((uint8_t) quantized);
+    size_t values = (size_t) cap * dimension;
+    if (quantized) {
+        writer.putBytes(quantizedFeatures.data(), values * sizeof(int8_t));
+    } else {
+        writer.putBytes(features.data(), values * sizeof(float));
+    }
+}
+
+bool FeatureGallery::load(blob::Reader &reader) {
+    int32_t newCap, newDim, newCount, newHead;
+    uint8_t newQuantized;
+    if (!reader.get(newCap) || !reader.get(newDim) || !reader.get(newCount) || !reader.get(newHead) ||
+        !reader.get(newQuantized) || newCap < 0 || newDim < 0 || newCount < 0 || newCount > newCap ||
+        newHead < 0 || (newCap > 0 && newHead >= newCap)) {
+        return false;
+    }
+    size_t values = (size_t) newCap * newDim;
+    std::vector<float> newFeatures;
+    std::vector<int8_t> newQuantizedFeatures;
+    if (newQuantized) {
+        newQuantizedFeatures.resize(values);
+        if (!reader.getBytes(newQuantizedFeatures.data(), values * sizeof(int8_t))) {
+            return false;
+        }
+    } else {
+        newFeatures.resize(values);
+        if (!reader.getBytes(newFeatures.data(), values * sizeof(float))) {
+            return false;
+        }
+    }
+    cap = newCap;
+    dimension = newDim;
+    count = newCount;
+    head = newHead;
+    quantized = newQuantized != 0;
+    features.swap(newFeatures);
+    quantizedFeatures.swap(newQuantizedFeatures);
+    return true;
+}
+
+void FeatureGallery::normalize(float const *in, float *out, int dim) {
+    float scale = getNormScale(in, dim);
+    for (int k = 0; k < dim; ++k) {
+        out[k] = in[k] * scale;
+    }
+}
+
+void FeatureGallery::quantize(float const *in, int8_t *out, int dim) {
+    for (int k = 0; k < dim; ++k) {
+        out[k] = (int8_t) std::lround(std::clamp(in[k], -1.0f, 1.0f) * 127.0f);
+    }
+}
+
+AppearanceMatcher::AppearanceMatcher() = default;
+
+AppearanceMatcher::~AppearanceMatcher() = default;
+
+void AppearanceMatcher::computeDistances(cv::Mat const &embeddings,
+                                         std::vector<FeatureGallery const *> const &galleries, cv::Mat &distances) {
+    assert(embeddings.type() == CV_32F);
+    int numDet = embeddings.rows, dim = embeddings.cols;
+    distances.create(numDet, (int) galleries.size(), CV_32F);
+    distances.setTo(cv::Scalar(1.0));
+    if (numDet == 0 || galleries.empty()) {
+        return;
+    }
+
+    normalized.create(numDet, dim, CV_32F);
+    for (int i = 0; i < numDet; ++i) {
+        FeatureGallery::normalize(embeddings.ptr<float>(i), normalized.ptr<float>(i), dim);
+    }
+
+    // offsets of the float galleries in the stacked features, the quantized ones take no rows
+    offsets.assign(1, 0);
+    bool anyQuantized = false;
+    for (auto const *gallery: galleries) {
+        if (gallery->size() > 0 && gallery->getDim() != dim) {
+            throw std::runtime_error("embedding dim " + std::to_string(dim) + " does not match the gallery dim " +
+                                     std::to_string(gallery->getDim()));
+        }
+        bool quantized = gallery->isQuantized();
+        offsets.push_back(offsets.back() + (quantized ? 0 : gallery->size()));
+        anyQuantized |= quantized && gallery->size() > 0;
+    }
+
+    // each gallery goes through the kernel of its storage, both kinds may be mixed
+    if (offsets.back() > 0) {
+        computeFloatDistances(galleries, distances);
+    }
+    if (anyQuantized) {
+        computeQuantizedDistances(galleries, distances);
+    }
+}
+
+size_t AppearanceMatcher::getMemoryBytes() const {
+    return memory_usage::matBytes(normalized) + memory_usage::matBytes(stacked) + memory_usage::matBytes(similarities) +
+           memory_usage::capacityBytes(quantizedDet) + memory_usage::capacityBytes(offsets);
+}
+
+void AppearanceMatcher::shrink() {
+    normalized.release();
+    stacked.release();
+    similarities.release();
+    memory_usage::release(quantizedDet);
+    memory_usage::release(offsets);
+}
+
+void AppearanceMatcher::computeFloatDistances(std::vector<FeatureGallery const *> const &galleries,
+                                              cv::Mat &distances) {
+    int dim = normalized.cols;
+    stacked.create(offsets.back(), dim, CV_32F);
+    for (int j = 0; j < (int) galleries.size(); ++j) {
+        if (galleries[j]->isQuantized()) {
+            continue;
+        }
+        std::copy_n(galleries[j]->getFeatures(), (size_t) galleries[j]->size() * dim, stacked.ptr<float>(offsets[j]));
+    }
+
+    // all cosine similarities in one GEMM, M x sum(gallery sizes)
+    cv::gemm(normalized, stacked, 1.0, cv::noArray(), 0.0, similarities, cv::GEMM_2_T);
+
+    for (int i = 0; i < normalized.rows; ++i) {
+        float const *row = similarities.ptr<float>(i);
+        for (int j = 0; j < (int) galleries.size(); ++j) {
+            if (offsets[j + 1] > offsets[j]) {
+                float best = *std::max_element(row + offsets[j], row + offsets[j + 1]);
+                distances.at<float>(i, j) = 1.0f - best;
+            }
+        }
+    }
+}
+
+void AppearanceMatcher::computeQuantizedDistances(std::vector<FeatureGallery const *> const &galleries,
+                                                  cv::Mat &distances) {
+    int dim = normalized.cols;
+    quantizedDet.resize((size_t) normalized.rows * dim);
+    for (int i = 0; i < normalized.rows; ++i) {
+        FeatureGallery::quantize(normalized.ptr<float>(i), quantizedDet.data() + (size_t) i * dim, dim);
+    }
+
+    float const scale = 1.0f / (127.0f * 127.0f);
+    for (int i = 0; i < normalized.rows; ++i) {
+        int8_t const *det = quantizedDet.data() + (size_t) i * dim;
+        for (int j = 0; j < (int) galleries.size(); ++j) {
+            if (!galleries[j]->isQuantized()) {
+                continue;
+            }
+            int8_t const *features = galleries[j]->getQuantizedFeatures();
+            int32_t best = INT32_MIN;
+            for (int k = 0; k < galleries[j]->size(); ++k) {
+                best = std::max(best, dot(det, features + (size_t) k * dim, dim));
+            }
+            if (galleries[j]->size() > 0) {
+                distances.at<float>(i, j) = 1.0f - (float) best * scale;
+            }
+        }
+    }
+}
+
+int32_t AppearanceMatcher::dot(int8_t const *a, int8_t const *b, int dim) {
+    int32_t sum = 0;
+    for (int k = 0; k < dim; ++k) {
+        sum += int32_t(a[k]) * int32_t(b[k]);
+    }
+    return sum;
+}
@@ -0,0 +1,428 @@
+#include "ObjectTracking/AssignmentPlanner.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <ObjectTracking/MemoryUsage.h>
+
+using namespace ObjectTracking;
+
+namespace {
+    char const CALIBRATION_MAGIC[] = "AssignmentPlanner";
+    int const CALIBRATION_VERSION = 1;
+    // seed of the cost model without calibration, nanoseconds per unit of work, rough mean of assignmentBench runs
+    double const DEFAULT_NS_PER_WORK[AssignmentPlanner::numStrategies] = {2.0, 3.0, 3.0};
+    int const MEAN_TIMINGS = 8;     // the estimates are the mean of their first timings, then a running average
+}
+
+AssignmentPlanner::AssignmentPlanner() {
+    for (int s = 0; s < numStrategies; ++s) {
+        for (int b = 0; b < numBuckets; ++b) {
+            nsPerWork[s][b] = DEFAULT_NS_PER_WORK[s];
+            numTimed[s][b] = 0;
+            sinceTimed[s][b] = 0;
+        }
+    }
+}
+
+AssignmentPlanner::~AssignmentPlanner() = default;
+
+void AssignmentPlanner::setParams(AssignmentParams const &assignmentParams) {
+    assert(assignmentParams.exploreInterval >= 0);
+    params = assignmentParams;
+}
+
+AssignmentParams const &AssignmentPlanner::getParams() const {
+    return params;
+}
+
+void AssignmentPlanner::reserve(int maxRows, int maxCols) {
+    size_t maxNodes = (size_t) maxRows + maxCols, maxPairs = (size_t) maxRows * maxCols;
+    km.reserve(maxRows, maxCols);
+    parent.reserve(maxNodes);
+    componentOf.reserve(maxNodes);
+    componentStart.reserve(maxNodes + 1);
+    componentNodes.reserve(maxNodes);
+    blockRows.reserve(maxRows);
+    blockCols.reserve(maxCols);
+    blockCost.reserve(maxPairs);
+    blockResult.reserve(std::min(maxRows, maxCols));
+    candidates.reserve(maxPairs);
+    rowUsed.reserve(maxRows);
+    colUsed.reserve(maxCols);
+}
+
+size_t AssignmentPlanner::getMemoryBytes() const {
+    return km.getMemoryBytes() + memory_usage::capacityBytes(parent) + memory_usage::capacityBytes(componentOf) +
+           memory_usage::capacityBytes(componentStart) + memory_usage::capacityBytes(componentNodes) +
+           memory_usage::capacityBytes(blockRows) + memory_usage::capacityBytes(blockCols) +
+           memory_usage::capacityBytes(blockCost) + memory_usage::capacityBytes(blockResult) +
+           memory_usage::capacityBytes(candidates) + memory_usage::capacityBytes(rowUsed) +
+           memory_usage::capacityBytes(colUsed);
+}
+
+void AssignmentPlanner::shrink() {
+    km.shrink();
+    memory_usage::release(parent);
+    memory_usage::release(componentOf);
+    memory_usage::release(componentStart);
+    memory_usage::release(componentNodes);
+    memory_usage::release(blockRows);
+    memory_usage::release(blockCols);
+    memory_usage::release(blockCost);
+    memory_usage::release(blockResult);
+    memory_usage::release(candidates);
+    memory_usage::release(rowUsed);
+    memory_usage::release(colUsed);
+}
+
+void AssignmentPlanner::compute(float const *costMatrix, int rows, int cols, float background,
+                                std::vector<std::pair<int, int>> &result) {
+    if (params.policy == AssignmentPolicy::Dense || background < 0 || rows == 0 || cols == 0) {
+        solveDense(costMatrix, rows, cols, result);
+        lastStrategy = AssignmentStrategy::Dense;
+        lastComponents = 0;
+        decisions[(int) AssignmentStrategy::Dense]++;
+        return;
+    }
+
+    analyze(costMatrix, rows, cols, background);
+    int bucket = getBucket(rows, cols);
+    int numAllowed = params.policy == AssignmentPolicy::Exact ? 2 : numStrategies;
+    int chosen = 0, explored = -1;
+    double bestNs = std::numeric_limits<double>::infinity();
+    for (int s = 0; s < numAllowed; ++s) {
+        double ns = predictNs((AssignmentStrategy) s, rows, cols);
+        if (ns < bestNs) {
+            bestNs = ns;
+            chosen = s;
+        }
+        if (explored < 0 && params.exploreInterval > 0 && sinceTimed[s][bucket] >= params.exploreInterval) {
+            explored = s;
+        }
+        sinceTimed[s][bucket]++;
+    }
+    // a strategy not timed for a while is run instead, its estimate may be stale
+    solve((AssignmentStrategy) (explored >= 0 ? explored : chosen), costMatrix, rows, cols, background, result);
+}
+
+void AssignmentPlanner::computeWith(AssignmentStrategy strategy, float const *costMatrix, int rows, int cols,
+                                    float background, std::vector<std::pair<int, int>> &result) {
+    assert(background >= 0 || strategy == AssignmentStrategy::Dense);
+    if (rows == 0 || cols == 0) {
+        result.clear();
+        return;
+    }
+    if (strategy == AssignmentStrategy::Dense) {
+        lastComponents = 0;
+    } else {
+        analyze(costMatrix, rows, cols, background);
+    }
+    solve(strategy, costMatrix, rows, cols, background, result);
+}
+
+double AssignmentPlanner::predictNs(AssignmentStrategy strategy, int rows, int cols) const {
+    return nsPerWork[(int) strategy][getBucket(rows, cols)] * getWork(strategy, rows, cols);
+}
+
+AssignmentStrategy AssignmentPlanner::getLastStrategy() const {
+    return lastStrategy;
+}
+
+int AssignmentPlanner::getLastComponents() const {
+    return lastComponents;
+}
+
+long AssignmentPlanner::getDecisionCount(AssignmentStrategy strategy) const {
+    return decisions[(int) strategy];
+}
+
+void AssignmentPlanner::saveCalibration(std::string const &path) const {
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("can not write assignment calibration " + path);
+    }
+    file << CALIBRATION_MAGIC << ' ' << CALIBRATION_VERSION << ' ' << numBuckets << '\n';
+    file.precision(6);
+    for (int s = 0; s < numStrategies; ++s) {
+        file << getStrategyName((AssignmentStrategy) s);
+        for (int b = 0; b < numBuckets; ++b) {
+            file << ' ' << nsPerWork[s][b];
+        }
+        file << '\n';
+    }
+    if (!file) {
+        throw std::runtime_error("can not write assignment calibration " + path);
+    }
+}
+
+void AssignmentPlanner::loadCalibration(std::string const &path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("can not open assignment calibration " + path);
+    }
+    std::string magic, name;
+    int version = 0, buckets = 0;
+    file >> magic >> version >> buckets;
+    if (magic != CALIBRATION_MAGIC || version != CALIBRATION_VERSION || buckets != numBuckets) {
+        throw std::runtime_error(path + " is not an assignment calibration of this version");
+    }
+    std::vector<double> loaded(numStrategies * numBuckets);
+    for (int s = 0; s < numStrategies; ++s) {
+        file >> name;
+        if (name != getStrategyName((AssignmentStrategy) s)) {
+            throw std::runtime_error("invalid assignment calibration " + path);
+        }
+        for (int b = 0; b < numBuckets; ++b) {
+            double &value = loaded[s * numBuckets + b];
+            if (!(file >> value) || !std::isfinite(value) || value <= 0) {
+                throw std::runtime_error("invalid assignment calibration " + path);
+            }
+        }
+    }
+    setCalibration(loaded);
+}
+
+void AssignmentPlanner::getCalibration(std::vector<double> &estimates) const {
+    estimates.assign(&nsPerWork[0][0], &nsPerWork[0][0] + numStrategies * numBuckets);
+}
+
+void AssignmentPlanner::setCalibration(std::vector<double> const &estimates) {
+    if (estimates.size() != (size_t) numStrategies * numBuckets ||
+        !std::all_of(estimates.begin(), estimates.end(), [](double value) {
+            return std::isfinite(value) && value > 0;
+        })) {
+        throw std::runtime_error("invalid assignment cost model estimates");
+    }
+    std::copy(estimates.begin(), estimates.end(), &nsPerWork[0][0]);
+    std::fill(&numTimed[0][0], &numTimed[0][0] + numStrategies * numBuckets, MEAN_TIMINGS);
+}
+
+char const *AssignmentPlanner::getStrategyName(AssignmentStrategy strategy) {
+    switch (strategy) {
+        case AssignmentStrategy::Components:
+            return "Components";
+        case AssignmentStrategy::Greedy:
+            return "Greedy";
+        default:
+            return "Dense";
+    }
+}
+
+int AssignmentPlanner::getBucket(int rows, int cols) {
+    int n = std::max(rows, cols), bucket = 0;
+    while (n > 1 && bucket < numBuckets - 1) {
+        n >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+double AssignmentPlanner::getWork(AssignmentStrategy strategy, int rows, int cols) const {
+    double scan = (double) rows * cols;
+    switch (strategy) {
+        case AssignmentStrategy::Components:
+            return scan + componentWork;
+        case AssignmentStrategy::Greedy:
+            return scan + numNonBackground * std::log2(numNonBackground + 2.0);
+        default: {
+            double n = std::max(rows, cols);
+            return n * n * n;
+        }
+    }
+}
+
+void AssignmentPlanner::analyze(float const *costMatrix, int rows, int cols, float background) {
+    int numNodes = rows + cols;
+    parent.resize(numNodes);
+    for (int node = 0; node < numNodes; ++node) {
+        parent[node] = node;
+    }
+    numNonBackground = 0;
+    for (int i = 0; i < rows; ++i) {
+        float const *costRow = costMatrix + (size_t) i * cols;
+        for (int j = 0; j < cols; ++j) {
+            if (!std::isfinite(costRow[j])) {
+                throw kuhn_munkres::NonFiniteCostException();
+            }
+            assert(costRow[j] <= background);
+            if (costRow[j] < background) {
+                numNonBackground++;
+                int a = findRoot(i), b = findRoot(rows + j);
+                if (a != b) {
+                    parent[std::max(a, b)] = std::min(a, b);
+                }
+            }
+        }
+    }
+
+    // nodes grouped by root, in increasing order; parent is then the insertion cursor
+    componentOf.resize(numNodes);
+    componentStart.assign(numNodes + 1, 0);
+    for (int node = 0; node < numNodes; ++node) {
+        componentOf[node] = findRoot(node);
+        componentStart[componentOf[node] + 1]++;
+    }
+    for (int node = 0; node < numNodes; ++node) {
+        componentStart[node + 1] += componentStart[node];
+        parent[node] = componentStart[node];
+    }
+    componentNodes.resize(numNodes);
+    for (int node = 0; node < numNodes; ++node) {
+        componentNodes[parent[componentOf[node]]++] = node;
+    }
+
+    lastComponents = 0;
+    componentWork = 0;
+    for (int root = 0; root < numNodes; ++root) {
+        int begin = componentStart[root], end = componentStart[root + 1];
+        if (end - begin < 2) {
+            continue;
+        }
+        int numRows = (int) (std::lower_bound(componentNodes.begin() + begin, componentNodes.begin() + end, rows) -
+                             (componentNodes.begin() + begin));
+        int numCols = end - begin - numRows;
+        double side = std::max(numRows, numCols);
+        componentWork += numRows == 1 || numCols == 1 ? side : side * side * side;
+        lastComponents++;
+    }
+}
+
+int AssignmentPlanner::findRoot(int node) {
+    while (parent[node] != node) {
+        parent[node] = parent[parent[node]];
+        node = parent[node];
+    }
+    return node;
+}
+
+void AssignmentPlanner::solveDense(float const *costMatrix, int rows, int cols,
+                                   std::vector<std::pair<int, int>> &result) {
+    if (rows == 0 || cols == 0) {
+        result.clear();
+        return;
+    }
+    km.compute(costMatrix, rows, cols, result);
+}
+
+void AssignmentPlanner::solveComponents(float const *costMatrix, int rows, int cols,
+                                        std::vector<std::pair<int, int>> &result) {
+    result.clear();
+    int numNodes = rows + cols;
+    for (int root = 0; root < numNodes; ++root) {
+        int begin = componentStart[root], end = componentStart[root + 1];
+        if (end - begin < 2) {
+            continue;
+        }
+        blockRows.clear();
+        blockCols.clear();
+        for (int k = begin; k < end; ++k) {
+            int node = componentNodes[k];
+            if (node < rows) {
+                blockRows.push_back(node);
+            } else {
+                blockCols.push_back(node - rows);
+            }
+        }
+        int numRows = (int) blockRows.size(), numCols = (int) blockCols.size();
+        auto cost = [&](int r, int c) { return costMatrix[(size_t) blockRows[r] * cols + blockCols[c]]; };
+        if (numRows == 1 || numCols == 1) {
+            // a single row or column takes its cheapest pair
+            int bestRow = 0, bestCol = 0;
+            for (int r = 0; r < numRows; ++r) {
+                for (int c = 0; c < numCols; ++c) {
+                    if (cost(r, c) < cost(bestRow, bestCol)) {
+                        bestRow = r;
+                        bestCol = c;
+                    }
+                }
+            }
+            result.emplace_back(blockRows[bestRow], blockCols[bestCol]);
+            continue;
+        }
+        blockCost.resize((size_t) numRows * numCols);
+        for (int r = 0; r < numRows; ++r) {
+            for (int c = 0; c < numCols; ++c) {
+                blockCost[(size_t) r * numCols + c] = cost(r, c);
+            }
+        }
+        km.compute(blockCost.data(), numRows, numCols, blockResult);
+        for (auto [r, c]: blockResult) {
+            result.emplace_back(blockRows[r], blockCols[c]);
+        }
+    }
+    completeAssignment(rows, cols, result);
+}
+
+void AssignmentPlanner::solveGreedy(float const *costMatrix, int rows, int cols, float background,
+                                    std::vector<std::pair<int, int>> &result) {
+    result.clear();
+    candidates.clear();
+    for (int i = 0; i < rows; ++i) {
+        float const *costRow = costMatrix + (size_t) i * cols;
+        for (int j = 0; j < cols; ++j) {
+            if (costRow[j] < background) {
+                candidates.emplace_back(costRow[j], i * cols + j);
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    rowUsed.assign(rows, 0);
+    colUsed.assign(cols, 0);
+    for (auto const &candidate: candidates) {
+        int i = candidate.second / cols, j = candidate.second % cols;
+        if (!rowUsed[i] && !colUsed[j]) {
+            rowUsed[i] = colUsed[j] = 1;
+            result.emplace_back(i, j);
+        }
+    }
+    completeAssignment(rows, cols, result);
+}
+
+void AssignmentPlanner::completeAssignment(int rows, int cols, std::vector<std::pair<int, int>> &result) {
+    rowUsed.assign(rows, 0);
+    colUsed.assign(cols, 0);
+    for (auto [i, j]: result) {
+        rowUsed[i] = colUsed[j] = 1;
+    }
+    // the pairs left all have the background cost
+    size_t numPairs = std::min(rows, cols);
+    for (int i = 0, j = 0; i < rows && result.size() < numPairs; ++i) {
+        if (!rowUsed[i]) {
+            while (colUsed[j]) {
+                ++j;
+            }
+            colUsed[j] = 1;
+            result.emplace_back(i, j);
+        }
+    }
+    std::sort(result.begin(), result.end());
+}
+
+void AssignmentPlanner::solve(AssignmentStrategy strategy, float const *costMatrix, int rows, int cols,
+                              float background, std::vector<std::pair<int, int>> &result) {
+    auto start = std::chrono::steady_clock::now();
+    switch (strategy) {
+        case AssignmentStrategy::Components:
+            solveComponents(costMatrix, rows, cols, result);
+            break;
+        case AssignmentStrategy::Greedy:
+            solveGreedy(costMatrix, rows, cols, background, result);
+            break;
+        default:
+            solveDense(costMatrix, rows, cols, result);
+            break;
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    int s = (int) strategy, bucket = getBucket(rows, cols);
+    numTimed[s][bucket] = std::min(numTimed[s][bucket] + 1, MEAN_TIMINGS);
+    nsPerWork[s][bucket] += (ns / std::max(getWork(strategy, rows, cols), 1.0) - nsPerWork[s][bucket]) /
+                            numTimed[s][bucket];
+    sinceTimed[s][bucket] = 0;
+    decisions[s]++;
+    lastStrategy = strategy;
+}
@@ -0,0 +1,94 @@
+#include "ObjectTracking/AsyncObjectTracker.h"
+#include <cassert>
+
+using namespace ObjectTracking;
+
+template<class MotionModel>
+AsyncObjectTrackerT<MotionModel>::AsyncObjectTrackerT(typename Tracker::Ptr tracker, int maxInFlight)
+        : tracker(std::move(tracker)), maxInFlight(maxInFlight) {
+    assert(this->tracker != nullptr && maxInFlight >= 1);
+    worker = std::thread(&AsyncObjectTrackerT::run, this);
+}
+
+template<class MotionModel>
+AsyncObjectTrackerT<MotionModel>::~AsyncObjectTrackerT() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    jobAvailable.notify_one();
+    worker.join();
+}
+
+template<class MotionModel>
+std::future<cv::Mat> AsyncObjectTrackerT<MotionModel>::submit(cv::Mat const &bboxesDet, cv::Mat const &embeddings) {
+    // an empty clone loses the column count
+    Job job{bboxesDet.rows > 0 ? bboxesDet.clone() : cv::Mat(0, 6, CV_32F), embeddings.clone(), {}};
+    std::future<cv::Mat> result = job.result.get_future();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        slotFree.wait(lock, [this] { return inFlight < maxInFlight; });
+        inFlight++;
+        queue.push_back(std::move(job));
+    }
+    jobAvailable.notify_one();
+    return result;
+}
+
+template<class MotionModel>
+void AsyncObjectTrackerT<MotionModel>::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    slotFree.wait(lock, [this] { return inFlight == 0; });
+}
+
+template<class MotionModel>
+int AsyncObjectTrackerT<MotionModel>::getInFlight() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return inFlight;
+}
+
+template<class MotionModel>
+typename AsyncObjectTrackerT<MotionModel>::Tracker::Ptr const &AsyncObjectTrackerT<MotionModel>::getTracker() const {
+    return tracker;
+}
+
+template<class MotionModel>
+void AsyncObjectTrackerT<MotionModel>::run() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobAvailable.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                return;     // stopping, the frames in flight are all tracked
+            }
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        try {
+            cv::Mat bboxesPost = tracker->update(job.bboxesDet, job.embeddings);
+            if (tracker->isFixedCapacity()) {
+                // the output is a view of the tracker buffer, overwritten by the next frame
+                bboxesPost = bboxesPost.rows > 0 ? bboxesPost.clone() : cv::Mat(0, 9, CV_32F);
+            }
+            job.result.set_value(bboxesPost);
+        } catch (...) {
+            job.result.set_exception(std::current_exception());
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            inFlight--;
+        }
+        slotFree.notify_all();
+    }
+}
+
+namespace ObjectTracking {
+    template class AsyncObjectTrackerT<ConstantVelocityModel>;
+
+    template class AsyncObjectTrackerT<ConstantAccelerationModel>;
+
+    template class AsyncObjectTrackerT<XywhVelocityModel>;
+}
@@ -0,0 +1,192 @@
+#include "ObjectTracking/DetectionPreFilter.h"
+#include <algorithm>
+
+using namespace ObjectTracking;
+
+DetectionPreFilter::DetectionPreFilter(float scoreThresh, float nmsIouThresh, bool classAware)
+        : scoreThresh(scoreThresh), nmsIouThresh(nmsIouThresh), classAware(classAware) {}
+
+DetectionPreFilter::~DetectionPreFilter() = default;
+
+void DetectionPreFilter::apply(cv::Mat const &bboxesDet, cv::Mat &bboxesOut, std::vector<int> *keptIndices) {
+    filter(bboxesDet);
+    int n = bboxesDet.rows;
+    int kept = 0;
+    for (int i = 0; i < n; ++i) {
+        kept += keep[i];
+    }
+    bboxesOut.create(kept, 6, CV_32F);
+    if (keptIndices) {
+        keptIndices->clear();
+    }
+    for (int i = 0, k = 0; i < n; ++i) {
+        if (keep[i]) {
+            std::copy_n(bboxesDet.ptr<float>(i), 6, bboxesOut.ptr<float>(k++));
+            if (keptIndices) {
+                keptIndices->push_back(i);
+            }
+        }
+    }
+}
+
+void DetectionPreFilter::select(cv::Mat const &bboxesDet, std::vector<int> &keptIndices) {
+    filter(bboxesDet);
+    keptIndices.clear();
+    for (int i = 0; i < bboxesDet.rows; ++i) {
+        if (keep[i]) {
+            keptIndices.push_back(i);
+        }
+    }
+}
+
+void DetectionPreFilter::reserve(int maxDetections) {
+    auto n = (size_t) maxDetections;
+    for (auto *column: {&xc, &yc, &score, &classId, &sortedClassId, &ious}) {
+        column->reserve(n);
+    }
+    for (auto *flags: {&keep, &inRoi, &alive}) {
+        flags->reserve(n);
+    }
+    order.reserve(n);
+    boxes.reserve(maxDetections);
+}
+
+void DetectionPreFilter::filter(cv::Mat const &bboxesDet) {
+    assert(bboxesDet.rows >= 0 && bboxesDet.cols == 6); // detections, [xc, yc, w, h, score, class_id]
+    int n = bboxesDet.rows;
+
+    // gather the columns used by the filters
+    xc.resize(n);
+    yc.resize(n);
+    score.resize(n);
+    classId.resize(n);
+    for (int i = 0; i < n; ++i) {
+        float const *row = bboxesDet.ptr<float>(i);
+        xc[i] = row[0];
+        yc[i] = row[1];
+        score[i] = row[4];
+        classId[i] = row[5];
+    }
+
+    // score threshold
+    keep.resize(n);
+    for (int i = 0; i < n; ++i) {
+        keep[i] = (unsigned char) (score[i] >= scoreThresh);
+    }
+
+    // static masks
+    if (!rois.empty()) {
+        inRoi.assign(n, 0);
+        for (auto const &roi: rois) {
+            float x0 = roi.x, y0 = roi.y, x1 = roi.x + roi.width, y1 = roi.y + roi.height;
+            for (int i = 0; i < n; ++i) {
+                inRoi[i] |= (unsigned char) (xc[i] >= x0 && xc[i] < x1 && yc[i] >= y0 && yc[i] < y1);
+            }
+        }
+        for (int i = 0; i < n; ++i) {
+            keep[i] &= inRoi[i];
+        }
+    }
+    for (auto const &zone: exclusions) {
+        float x0 = zone.x, y0 = zone.y, x1 = zone.x + zone.width, y1 = zone.y + zone.height;
+        for (int i = 0; i < n; ++i) {
+            keep[i] &= (unsigned char) !(xc[i] >= x0 && xc[i] < x1 && yc[i] >= y0 && yc[i] < y1);
+        }
+    }
+    if (!roiMask.empty()) {
+        for (int i = 0; i < n; ++i) {
+            if (!keep[i]) {
+                continue;
+            }
+            auto x = (int) std::floor(xc[i]), y = (int) std::floor(yc[i]);
+            keep[i] = (unsigned char) (x >= 0 && y >= 0 && x < roiMask.cols && y < roiMask.rows &&
+                                       roiMask.at<unsigned char>(y, x) != 0);
+        }
+    }
+
+    // non-maximum suppression
+    if (nmsIouThresh < 1.0f) {
+        suppress(bboxesDet);
+    }
+}
+
+void DetectionPreFilter::suppress(cv::Mat const &bboxesDet) {
+    order.clear();
+    for (int i = 0; i < (int) keep.size(); ++i) {
+        if (keep[i]) {
+            order.push_back(i);
+        }
+    }
+    // ties keep the detection order, std::sort does not allocate unlike std::stable_sort
+    std::sort(order.begin(), order.end(), [this](int a, int b) {
+        return score[a] > score[b] || (score[a] == score[b] && a < b);
+    });
+
+    // candidates in decreasing score order
+    int k = (int) order.size();
+    boxes.clear();
+    boxes.reserve(k);
+    sortedClassId.resize(k);
+    alive.assign(k, 1);
+    for (int a = 0; a < k; ++a) {
+        boxes.push_back(bboxesDet.ptr<float>(order[a]));
+        sortedClassId[a] = classId[order[a]];
+    }
+
+    ious.resize(k);
+    for (int a = 0; a < k; ++a) {
+        if (!alive[a]) {
+            continue;
+        }
+        box_kernels::iouOneToMany(boxes, a, boxes, a + 1, k, ious.data());
+        float ownClass = sortedClassId[a];
+        for (int b = a + 1; b < k; ++b) {
+            alive[b] &= (unsigned char) !(ious[b - a - 1] > nmsIouThresh &&
+                                          (!classAware || sortedClassId[b] == ownClass));
+        }
+    }
+
+    for (int a = 0; a < k; ++a) {
+        keep[order[a]] = alive[a];
+    }
+}
+
+void DetectionPreFilter::setScoreThresh(float thresh) {
+    scoreThresh = thresh;
+}
+
+void DetectionPreFilter::setNmsIouThresh(float thresh, bool isClassAware) {
+    nmsIouThresh = thresh;
+    classAware = isClassAware;
+}
+
+float DetectionPreFilter::getScoreThresh() const {
+    return scoreThresh;
+}
+
+float DetectionPreFilter::getNmsIouThresh() const {
+    return nmsIouThresh;
+}
+
+bool DetectionPreFilter::isClassAware() const {
+    return classAware;
+}
+
+void DetectionPreFilter::addRoi(cv::Rect2f const &roi) {
+    rois.push_back(roi);
+}
+
+void DetectionPreFilter::addExclusion(cv::Rect2f const &zone) {
+    exclusions.push_back(zone);
+}
+
+void DetectionPreFilter::setRoiMask(cv::Mat const &mask) {
+    assert(mask.empty() || mask.type() == CV_8U);
+    roiMask = mask.clone();
+}
+
+void DetectionPreFilter::clearMasks() {
+    rois.clear();
+    exclusions.clear();
+    roiMask.release();
+}
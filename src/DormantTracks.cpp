@@ -0,0 +1,161 @@
+#include "ObjectTracking/DormantTracks.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <ObjectTracking/BoxKernels.h>
+#include <ObjectTracking/MemoryUsage.h>
+
+using namespace ObjectTracking;
+
+namespace {
+    float const POSITION_SCALE = 2.0f;      // 1/2 pixel
+    float const VELOCITY_SCALE = 64.0f;     // 1/64 pixel per frame
+
+    template<typename T>
+    T quantize(float value, float scale) {
+        float scaled = std::round(value * scale);
+        return (T) std::clamp(scaled, (float) std::numeric_limits<T>::min(), (float) std::numeric_limits<T>::max());
+    }
+}
+
+DormantTrackStore::DormantTrackStore() = default;
+
+DormantTrackStore::~DormantTrackStore() = default;
+
+void DormantTrackStore::setParams(DormantParams const &dormantParams) {
+    assert(dormantParams.maxDormantAge >= 0);
+    params = dormantParams;
+    clear();
+}
+
+DormantParams const &DormantTrackStore::getParams() const {
+    return params;
+}
+
+void DormantTrackStore::reserveFixed(int maxTracks) {
+    assert(maxTracks > 0);
+    capacity = (size_t) maxTracks;
+    indexed = false;
+    tracks.reserve(capacity);
+    indexById.reserve(capacity);
+    candidateIds.reserve(capacity);
+}
+
+void DormantTrackStore::add(int trackerId, int lastFrame, cv::Vec4f const &bbox, cv::Vec2f const &velocity,
+                            float classId) {
+    if (params.maxDormantAge <= 0) {
+        return;
+    }
+    if (capacity > 0 && tracks.size() >= capacity) {
+        auto oldest = std::min_element(tracks.begin(), tracks.end(), [](DormantTrack const &a, DormantTrack const &b) {
+            return a.lastFrame < b.lastFrame;
+        });
+        removeAt((int) (oldest - tracks.begin()));
+    }
+    DormantTrack track{trackerId, lastFrame,
+                       quantize<int16_t>(bbox[0], POSITION_SCALE), quantize<int16_t>(bbox[1], POSITION_SCALE),
+                       quantize<uint16_t>(bbox[2], POSITION_SCALE), quantize<uint16_t>(bbox[3], POSITION_SCALE),
+                       quantize<int16_t>(velocity[0], VELOCITY_SCALE), quantize<int16_t>(velocity[1], VELOCITY_SCALE),
+                       quantize<int16_t>(classId, 1.0f)};
+    indexById[trackerId] = (int) tracks.size();
+    tracks.push_back(track);
+    if (indexed) {
+        sweptIndex.set(trackerId, getSweptRegion(track));
+    }
+}
+
+void DormantTrackStore::expire(int frame) {
+    for (int i = 0; i < (int) tracks.size();) {
+        if (frame - tracks[i].lastFrame > params.maxDormantAge) {
+            removeAt(i);    // the last record moved to i
+        } else {
+            ++i;
+        }
+    }
+}
+
+void DormantTrackStore::findCandidates(float const *bbox, std::vector<int> &indices) {
+    indices.clear();
+    if (!indexed) {
+        for (int i = 0; i < (int) tracks.size(); ++i) {
+            indices.push_back(i);
+        }
+        return;
+    }
+    candidateIds.clear();
+    sweptIndex.query(cv::Rect2f(bbox[0] - bbox[2] / 2, bbox[1] - bbox[3] / 2, bbox[2], bbox[3]), candidateIds);
+    for (int trackerId: candidateIds) {
+        indices.push_back(indexById.at(trackerId));
+    }
+}
+
+float DormantTrackStore::getIou(int index, float const *bbox, int frame) const {
+    DormantTrack const &track = tracks[index];
+    if (params.classAware && track.classId != quantize<int16_t>(bbox[5], 1.0f)) {
+        return 0;
+    }
+    cv::Vec4f extrapolated = extrapolate(track, frame);
+    // integer corners as in BoxSet::push_back
+    float ax1 = float(int(bbox[0] - bbox[2] / 2.0)), ay1 = float(int(bbox[1] - bbox[3] / 2.0));
+    float bx1 = float(int(extrapolated[0] - extrapolated[2] / 2.0));
+    float by1 = float(int(extrapolated[1] - extrapolated[3] / 2.0));
+    return box_kernels::iou(ax1, ay1, ax1 + float(int(bbox[2])), ay1 + float(int(bbox[3])),
+                            bx1, by1, bx1 + float(int(extrapolated[2])), by1 + float(int(extrapolated[3])));
+}
+
+DormantTrack const &DormantTrackStore::get(int index) const {
+    return tracks[index];
+}
+
+void DormantTrackStore::remove(std::vector<int> const &trackerIds) {
+    for (int trackerId: trackerIds) {
+        int const *index = indexById.find(trackerId);
+        if (index != nullptr) {
+            removeAt(*index);
+        }
+    }
+}
+
+void DormantTrackStore::clear() {
+    tracks.clear();
+    indexById.clear();
+    sweptIndex.clear();
+}
+
+int DormantTrackStore::size() const {
+    return (int) tracks.size();
+}
+
+size_t DormantTrackStore::getMemoryBytes() const {
+    return memory_usage::capacityBytes(tracks) + indexById.getMemoryBytes() + sweptIndex.getMemoryBytes() +
+           memory_usage::capacityBytes(candidateIds);
+}
+
+cv::Vec4f DormantTrackStore::extrapolate(DormantTrack const &track, int frame) {
+    auto elapsed = (float) (frame - track.lastFrame);
+    return {(float) track.xc / POSITION_SCALE + elapsed * (float) track.dx / VELOCITY_SCALE,
+            (float) track.yc / POSITION_SCALE + elapsed * (float) track.dy / VELOCITY_SCALE,
+            (float) track.w / POSITION_SCALE, (float) track.h / POSITION_SCALE};
+}
+
+void DormantTrackStore::removeAt(int index) {
+    int trackerId = tracks[index].trackerId;
+    indexById.erase(trackerId);
+    if (indexed) {
+        sweptIndex.remove(trackerId);
+    }
+    if (index != (int) tracks.size() - 1) {
+        tracks[index] = tracks.back();
+        indexById[tracks[index].trackerId] = index;
+    }
+    tracks.pop_back();
+}
+
+cv::Rect2f DormantTrackStore::getSweptRegion(DormantTrack const &track) const {
+    cv::Vec4f first = extrapolate(track, track.lastFrame);
+    cv::Vec4f last = extrapolate(track, track.lastFrame + params.maxDormantAge);
+    float x0 = std::min(first[0], last[0]) - first[2] / 2, x1 = std::max(first[0], last[0]) + first[2] / 2;
+    float y0 = std::min(first[1], last[1]) - first[3] / 2, y1 = std::max(first[1], last[1]) + first[3] / 2;
+    return {x0, y0, x1 - x0, y1 - y0};
+}
@@ -0,0 +1,282 @@
+#include "ObjectTracking/KalmanBatch.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace ObjectTracking;
+
+template<class MotionModel>
+KalmanBatchT<MotionModel>::KalmanBatchT()
+        : F(MotionModel::transitionMatrix()), H(MotionModel::measurementMatrix()) {}
+
+template<class MotionModel>
+KalmanBatchT<MotionModel>::~KalmanBatchT() = default;
+
+template<class MotionModel>
+void KalmanBatchT<MotionModel>::predict(Tracker *const *trackers, int count) {
+    for (int first = 0; first < count; first += LANES) {
+        predictBlock(trackers + first, std::min(LANES, count - first));
+    }
+}
+
+template<class MotionModel>
+void KalmanBatchT<MotionModel>::update(Tracker *const *trackers, float const *const *bboxes, int count) {
+    for (int first = 0; first < count; first += LANES) {
+        updateBlock(trackers + first, bboxes + first, std::min(LANES, count - first));
+    }
+}
+
+template<class MotionModel>
+void KalmanBatchT<MotionModel>::predictBlock(Tracker *const *trackers, int count) {
+    float x[dimX][LANES], P[dimX * dimX][LANES], Q[dimX * dimX][LANES], FP[dimX * dimX][LANES];
+
+    // gather, with the state constrained as in predict; the unused lanes repeat the last tracker
+    for (int l = 0; l < LANES; ++l) {
+        Tracker const &tracker = *trackers[std::min(l, count - 1)];
+        typename Tracker::StateVec xl = tracker.getCurrentState();
+        MotionModel::constrain(xl);
+        typename Tracker::StateMat const &Pl = tracker.getErrorCov();
+        typename Tracker::StateMat Ql = MotionModel::processNoiseCov(xl);
+        for (int e = 0; e < dimX; ++e) {
+            x[e][l] = xl[e];
+        }
+        for (int e = 0; e < dimX * dimX; ++e) {
+            P[e][l] = Pl.val[e];
+            Q[e][l] = Ql.val[e];
+        }
+    }
+
+    // F*P
+    for (int i = 0; i < dimX; ++i) {
+        for (int j = 0; j < dimX; ++j) {
+            float acc[LANES] = {};
+            for (int k = 0; k < dimX; ++k) {
+                float f = F(i, k);
+                if (f != 0) {
+                    for (int l = 0; l < LANES; ++l) {
+                        acc[l] += f * P[k * dimX + j][l];
+                    }
+                }
+            }
+            std::copy_n(acc, LANES, FP[i * dimX + j]);
+        }
+    }
+    // P'(k) = F*P(k-1)*Ft + Q
+    for (int i = 0; i < dimX; ++i) {
+        for (int j = 0; j < dimX; ++j) {
+            float acc[LANES] = {};
+            for (int k = 0; k < dimX; ++k) {
+                float f = F(j, k);
+                if (f != 0) {
+                    for (int l = 0; l < LANES; ++l) {
+                        acc[l] += FP[i * dimX + k][l] * f;
+                    }
+                }
+            }
+            for (int l = 0; l < LANES; ++l) {
+                P[i * dimX + j][l] = acc[l] + Q[i * dimX + j][l];
+            }
+        }
+    }
+    // x'(k) = F*x(k-1)
+    float xPred[dimX][LANES];
+    for (int i = 0; i < dimX; ++i) {
+        float acc[LANES] = {};
+        for (int k = 0; k < dimX; ++k) {
+            float f = F(i, k);
+            if (f != 0) {
+                for (int l = 0; l < LANES; ++l) {
+                    acc[l] += f * x[k][l];
+                }
+            }
+        }
+        std::copy_n(acc, LANES, xPred[i]);
+    }
+
+    // scatter
+    for (int l = 0; l < count; ++l) {
+        typename Tracker::StateVec xl;
+        typename Tracker::StateMat Pl;
+        for (int e = 0; e < dimX; ++e) {
+            xl[e] = xPred[e][l];
+        }
+        for (int e = 0; e < dimX * dimX; ++e) {
+            Pl.val[e] = P[e][l];
+        }
+        trackers[l]->setPredicted(xl, Pl);
+    }
+}
+
+template<class MotionModel>
+void KalmanBatchT<MotionModel>::updateBlock(Tracker *const *trackers, float const *const *bboxes, int count) {
+    int const cols = dimX + 1;  // right-hand sides: the columns of H*P'(k), then the innovation
+    float x[dimX][LANES], P[dimX * dimX][LANES], R[dimZ * dimZ][LANES], z[dimZ][LANES];
+    float HP[dimZ * dimX][LANES], S[dimZ * dimZ][LANES], rhs[dimZ * cols][LANES];
+
+    // gather, the unused lanes repeat the last tracker
+    for (int l = 0; l < LANES; ++l) {
+        int index = std::min(l, count - 1);
+        Tracker const &tracker = *trackers[index];
+        float const *bbox = bboxes[index];
+        typename Tracker::StateVec const &xl = tracker.getCurrentState();
+        typename Tracker::StateMat const &Pl = tracker.getErrorCov();
+        typename Tracker::MeasCovMat Rl = MotionModel::measurementNoiseCov(xl);
+        typename Tracker::MeasVec zl = MotionModel::bboxToZ({bbox[0], bbox[1], bbox[2], bbox[3]});
+        for (int e = 0; e < dimX; ++e) {
+            x[e][l] = xl[e];
+        }
+        for (int e = 0; e < dimX * dimX; ++e) {
+            P[e][l] = Pl.val[e];
+        }
+        for (int e = 0; e < dimZ * dimZ; ++e) {
+            R[e][l] = Rl.val[e];
+        }
+        for (int e = 0; e < dimZ; ++e) {
+            z[e][l] = zl[e];
+        }
+    }
+
+    // H*P'(k), right-hand sides of the columns
+    for (int m = 0; m < dimZ; ++m) {
+        for (int j = 0; j < dimX; ++j) {
+            float acc[LANES] = {};
+            for (int k = 0; k < dimX; ++k) {
+                float h = H(m, k);
+                if (h != 0) {
+                    for (int l = 0; l < LANES; ++l) {
+                        acc[l] += h * P[k * dimX + j][l];
+                    }
+                }
+            }
+            std::copy_n(acc, LANES, HP[m * dimX + j]);
+            std::copy_n(acc, LANES, rhs[m * cols + j]);
+        }
+    }
+    // S = H*P'(k)*Ht + R
+    for (int m = 0; m < dimZ; ++m) {
+        for (int c = 0; c < dimZ; ++c) {
+            float acc[LANES] = {};
+            for (int k = 0; k < dimX; ++k) {
+                float h = H(c, k);
+                if (h != 0) {
+                    for (int l = 0; l < LANES; ++l) {
+                        acc[l] += HP[m * dimX + k][l] * h;
+                    }
+                }
+            }
+            for (int l = 0; l < LANES; ++l) {
+                S[m * dimZ + c][l] = acc[l] + R[m * dimZ + c][l];
+            }
+        }
+    }
+    // innovation z(k) - H*x'(k), last right-hand side
+    for (int m = 0; m < dimZ; ++m) {
+        float acc[LANES] = {};
+        for (int k = 0; k < dimX; ++k) {
+            float h = H(m, k);
+            if (h != 0) {
+                for (int l = 0; l < LANES; ++l) {
+                    acc[l] += h * x[k][l];
+                }
+            }
+        }
+        for (int l = 0; l < LANES; ++l) {
+            rhs[m * cols + dimX][l] = z[m][l] - acc[l];
+        }
+    }
+
+    // S = L*Lt in place, lower triangle
+    for (int j = 0; j < dimZ; ++j) {
+        float *d = S[j * dimZ + j];
+        for (int k = 0; k < j; ++k) {
+            for (int l = 0; l < LANES; ++l) {
+                d[l] -= S[j * dimZ + k][l] * S[j * dimZ + k][l];
+            }
+        }
+        for (int l = 0; l < LANES; ++l) {
+            d[l] = std::sqrt(d[l]);
+        }
+        for (int i = j + 1; i < dimZ; ++i) {
+            float *a = S[i * dimZ + j];
+            for (int k = 0; k < j; ++k) {
+                for (int l = 0; l < LANES; ++l) {
+                    a[l] -= S[i * dimZ + k][l] * S[j * dimZ + k][l];
+                }
+            }
+            for (int l = 0; l < LANES; ++l) {
+                a[l] /= d[l];
+            }
+        }
+    }
+    // inv(S)*[H*P'(k), z(k) - H*x'(k)] by forward and back substitution
+    for (int c = 0; c < cols; ++c) {
+        for (int m = 0; m < dimZ; ++m) {
+            float *r = rhs[m * cols + c];
+            for (int k = 0; k < m; ++k) {
+                for (int l = 0; l < LANES; ++l) {
+                    r[l] -= S[m * dimZ + k][l] * rhs[k * cols + c][l];
+                }
+            }
+            for (int l = 0; l < LANES; ++l) {
+                r[l] /= S[m * dimZ + m][l];
+            }
+        }
+        for (int m = dimZ - 1; m >= 0; --m) {
+            float *r = rhs[m * cols + c];
+            for (int k = m + 1; k < dimZ; ++k) {
+                for (int l = 0; l < LANES; ++l) {
+                    r[l] -= S[k * dimZ + m][l] * rhs[k * cols + c][l];
+                }
+            }
+            for (int l = 0; l < LANES; ++l) {
+                r[l] /= S[m * dimZ + m][l];
+            }
+        }
+    }
+
+    // K(k) = (inv(S)*H*P'(k))t: x(k) = x'(k) + K(k)*(z(k) - H*x'(k)), P(k) = P'(k) - K(k)*H*P'(k)
+    for (int i = 0; i < dimX; ++i) {
+        float acc[LANES] = {};
+        for (int m = 0; m < dimZ; ++m) {
+            for (int l = 0; l < LANES; ++l) {
+                acc[l] += HP[m * dimX + i][l] * rhs[m * cols + dimX][l];
+            }
+        }
+        for (int l = 0; l < LANES; ++l) {
+            x[i][l] += acc[l];
+        }
+    }
+    for (int i = 0; i < dimX; ++i) {
+        for (int j = 0; j < dimX; ++j) {
+            float acc[LANES] = {};
+            for (int m = 0; m < dimZ; ++m) {
+                for (int l = 0; l < LANES; ++l) {
+                    acc[l] += rhs[m * cols + i][l] * HP[m * dimX + j][l];
+                }
+            }
+            for (int l = 0; l < LANES; ++l) {
+                P[i * dimX + j][l] -= acc[l];
+            }
+        }
+    }
+
+    // scatter
+    for (int l = 0; l < count; ++l) {
+        typename Tracker::StateVec xl;
+        typename Tracker::StateMat Pl;
+        for (int e = 0; e < dimX; ++e) {
+            xl[e] = x[e][l];
+        }
+        for (int e = 0; e < dimX * dimX; ++e) {
+            Pl.val[e] = P[e][l];
+        }
+        trackers[l]->setCorrected(xl, Pl);
+    }
+}
+
+namespace ObjectTracking {
+    template class KalmanBatchT<ConstantVelocityModel>;
+
+    template class KalmanBatchT<ConstantAccelerationModel>;
+
+    template class KalmanBatchT<XywhVelocityModel>;
+}
@@ -2,75 +2,129 @@
 
 using namespace ObjectTracking;
 
-int KalmanBoxTracker::count = 0;
-
-KalmanBoxTracker::KalmanBoxTracker(cv::Mat const &bbox) {
-    id = KalmanBoxTracker::count;
-    KalmanBoxTracker::count++;
-
-    kf = std::make_shared<cv::KalmanFilter>(KF_DIM_X, KF_DIM_Z);  // no control vector
-    // state transition matrix (A), x(k) = A*x(k-1) + B*u(k) + w(k)
-    kf->transitionMatrix = (cv::Mat_<float>(KF_DIM_X, KF_DIM_X) <<
-                                1, 0, 0, 0, 1, 0, 0,
-                                0, 1, 0, 0, 0, 1, 0,
-                                0, 0, 1, 0, 0, 0, 1,
-                                0, 0, 0, 1, 0, 0, 0,
-                                0, 0, 0, 0, 1, 0, 0,
-                                0, 0, 0, 0, 0, 1, 0,
-                                0, 0, 0, 0, 0, 0, 1);
-    // measurement matrix (H), z(k) = H*x(k) + v(k)
-    kf->measurementMatrix = (cv::Mat_<float>(KF_DIM_Z, KF_DIM_X) <<
-                                1, 0, 0, 0, 0, 0, 0,
-                                0, 1, 0, 0, 0, 0, 0,
-                                0, 0, 1, 0, 0, 0, 0,
-                                0, 0, 0, 1, 0, 0, 0);
-    // measurement noise covariance matrix (R), K(k) = P`(k)*Ct*inv(C*P`(k)*Ct + R)
-    kf->measurementNoiseCov = (cv::Mat_<float>(KF_DIM_Z, KF_DIM_Z) <<
-                                1,  0,  0,  0,
-                                0,  1,  0,  0,
-                                0,  0,  10, 0,
-                                0,  0,  0,  10);
-    // posteriori error estimate covariance matrix (P(k)): P(k)=(I-K(k)*H)*P'(k)
-    kf->errorCovPost = (cv::Mat_<float>(KF_DIM_X, KF_DIM_X) <<
-                                10, 0,  0,  0,  0,   0,   0,
-                                0,  10, 0,  0,  0,   0,   0,
-                                0,  0,  10, 0,  0,   0,   0,
-                                0,  0,  0,  10, 0,   0,   0,
-                                0,  0,  0,  0,  1e4, 0,   0,
-                                0,  0,  0,  0,  0,   1e4, 0,
-                                0,  0,  0,  0,  0,   0,   1e4);
-    // process noise covariance matrix (Q), P'(k) = A*P(k-1)*At + Q
-    kf->processNoiseCov = (cv::Mat_<float>(KF_DIM_X, KF_DIM_X) <<
-                                1, 0, 0, 0, 0,    0,    0,
-                                0, 1, 0, 0, 0,    0,    0,
-                                0, 0, 1, 0, 0,    0,    0,
-                                0, 0, 0, 1, 0,    0,    0,
-                                0, 0, 0, 0, 1e-2, 0,    0,
-                                0, 0, 0, 0, 0,    1e-2, 0,
-                                0, 0, 0, 0, 0,    0,    1e-4);
-    // corrected state (x(k)): x(k)=x'(k)+K(k)*(z(k)-H*x'(k))
-    cv::vconcat(convertBBoxToZ(bbox),
-                cv::Mat(KF_DIM_X - KF_DIM_Z, 1, CV_32F, cv::Scalar(0)),
-                kf->statePost);
-}
-
-KalmanBoxTracker::~KalmanBoxTracker() = default;
-
-cv::Mat KalmanBoxTracker::update(cv::Mat const &bbox) {
+std::atomic<int> KalmanBoxTrackerBase::count{0};
+
+KalmanBoxTrackerBase::KalmanBoxTrackerBase() {
+    id = KalmanBoxTrackerBase::count++;
+}
+
+KalmanBoxTrackerBase::KalmanBoxTrackerBase(int id, int timeSinceUpdate, int hitStreak)
+        : id(id), timeSinceUpdate(timeSinceUpdate), hitStreak(hitStreak) {}
+
+KalmanBoxTrackerBase::~KalmanBoxTrackerBase() = default;
+
+void KalmanBoxTrackerBase::resetIdentity() {
+    id = KalmanBoxTrackerBase::count++;
+    timeSinceUpdate = 0;
+    hitStreak = 0;
+    gallery.clear();
+    trajectory.clear();
+}
+
+void KalmanBoxTrackerBase::resetIdentity(int trackerId, int initialHitStreak) {
+    id = trackerId;
+    timeSinceUpdate = 0;
+    hitStreak = initialHitStreak;
+    gallery.clear();
+    trajectory.clear();
+}
+
+int KalmanBoxTrackerBase::getFilterCount() {
+    return KalmanBoxTrackerBase::count.load();
+}
+
+void KalmanBoxTrackerBase::setFilterCount(int value) {
+    KalmanBoxTrackerBase::count.store(value);
+}
+
+int KalmanBoxTrackerBase::getFilterId() const {
+    return id;
+}
+
+int KalmanBoxTrackerBase::getTimeSinceUpdate() const {
+    return timeSinceUpdate;
+}
+
+int KalmanBoxTrackerBase::getHitStreak() const {
+    return hitStreak;
+}
+
+FeatureGallery &KalmanBoxTrackerBase::getGallery() {
+    return gallery;
+}
+
+FeatureGallery const &KalmanBoxTrackerBase::getGallery() const {
+    return gallery;
+}
+
+TrajectoryBuffer &KalmanBoxTrackerBase::getTrajectory() {
+    return trajectory;
+}
+
+TrajectoryBuffer const &KalmanBoxTrackerBase::getTrajectory() const {
+    return trajectory;
+}
+
+template<class MotionModel>
+KalmanBoxTrackerT<MotionModel>::KalmanBoxTrackerT(cv::Mat const &bbox) {
+    MeasVec z = MotionModel::bboxToZ(readBBox(bbox));
+    x = MotionModel::initialState(z);
+    P = MotionModel::initialErrorCov(z);
+    xPost = x;
+}
+
+template<class MotionModel>
+KalmanBoxTrackerT<MotionModel>::KalmanBoxTrackerT(int id, StateVec const &x, StateMat const &P,
+                                                  StateVec const &xPost, int timeSinceUpdate, int hitStreak)
+        : KalmanBoxTrackerBase(id, timeSinceUpdate, hitStreak), x(x), P(P), xPost(xPost) {}
+
+template<class MotionModel>
+KalmanBoxTrackerT<MotionModel>::~KalmanBoxTrackerT() = default;
+
+template<class MotionModel>
+void KalmanBoxTrackerT<MotionModel>::reset(cv::Mat const &bbox) {
+    resetIdentity();
+    MeasVec z = MotionModel::bboxToZ(readBBox(bbox));
+    x = MotionModel::initialState(z);
+    P = MotionModel::initialErrorCov(z);
+    xPost = x;
+}
+
+template<class MotionModel>
+void KalmanBoxTrackerT<MotionModel>::reset(cv::Mat const &bbox, int trackerId, int initialHitStreak) {
+    resetIdentity(trackerId, initialHitStreak);
+    MeasVec z = MotionModel::bboxToZ(readBBox(bbox));
+    x = MotionModel::initialState(z);
+    P = MotionModel::initialErrorCov(z);
+    xPost = x;
+}
+
+template<class MotionModel>
+cv::Vec4f KalmanBoxTrackerT<MotionModel>::update(cv::Mat const &bbox) {
     timeSinceUpdate = 0;
     hitStreak += 1;
-    xPost = kf->correct(convertBBoxToZ(bbox));
-    cv::Mat bboxPost = convertXToBBox(xPost);
-    return bboxPost;
+
+    // K(k) = P'(k)*Ht*inv(H*P'(k)*Ht + R)
+    MeasVec z = MotionModel::bboxToZ(readBBox(bbox));
+    cv::Matx<float, MotionModel::dimZ, MotionModel::dimX> HP = H * P;
+    MeasCovMat S = HP * H.t() + MotionModel::measurementNoiseCov(x);
+    GainMat K = (S.inv(cv::DECOMP_CHOLESKY) * HP).t();
+    // x(k) = x'(k) + K(k)*(z(k) - H*x'(k)), P(k) = P'(k) - K(k)*H*P'(k)
+    x = x + K * (z - H * x);
+    P = P - K * HP;
+
+    xPost = x;
+    return MotionModel::xToBBox(xPost);
 }
 
-cv::Mat KalmanBoxTracker::predict() {
-    // bbox area (ds/dt + s) shouldn't be negative
-    if (kf->statePost.at<float>(6, 0) + kf->statePost.at<float>(2, 0) <= 0)
-        kf->statePost.at<float>(6, 0) *= 0;
+template<class MotionModel>
+cv::Vec4f KalmanBoxTrackerT<MotionModel>::predict() {
+    MotionModel::constrain(x);
 
-    cv::Mat xPred = kf->predict();
-    cv::Mat bboxPred = convertXToBBox(xPred);
+    // x'(k) = F*x(k-1), P'(k) = F*P(k-1)*Ft + Q
+    P = F * P * F.t() + MotionModel::processNoiseCov(x);
+    x = F * x;
+    cv::Vec4f bboxPred = MotionModel::xToBBox(x);
 
     hitStreak = timeSinceUpdate > 0 ? 0 : hitStreak;
     timeSinceUpdate++;
@@ -78,42 +132,79 @@ cv::Mat KalmanBoxTracker::predict() {
     return bboxPred;
 }
 
-int KalmanBoxTracker::getFilterCount() {
-    return KalmanBoxTracker::count;
+template<class MotionModel>
+void KalmanBoxTrackerT<MotionModel>::setPredicted(StateVec const &xPred, StateMat const &PPred) {
+    x = xPred;
+    P = PPred;
+    hitStreak = timeSinceUpdate > 0 ? 0 : hitStreak;
+    timeSinceUpdate++;
 }
 
-int KalmanBoxTracker::getFilterId() const {
-    return id;
+template<class MotionModel>
+void KalmanBoxTrackerT<MotionModel>::setCorrected(StateVec const &xCorr, StateMat const &PCorr) {
+    timeSinceUpdate = 0;
+    hitStreak += 1;
+    x = xCorr;
+    P = PCorr;
+    xPost = x;
 }
 
-int KalmanBoxTracker::getTimeSinceUpdate() const {
-    return timeSinceUpdate;
+template<class MotionModel>
+cv::Vec2f KalmanBoxTrackerT<MotionModel>::getVelocity() const {
+    return MotionModel::velocity(xPost);
 }
 
-int KalmanBoxTracker::getHitStreak() const {
-    return hitStreak;
+template<class MotionModel>
+cv::Vec4f KalmanBoxTrackerT<MotionModel>::getBBox() const {
+    return MotionModel::xToBBox(x);
 }
 
-cv::Mat KalmanBoxTracker::getState() {
-    return xPost.clone();
+template<class MotionModel>
+typename KalmanBoxTrackerT<MotionModel>::StateVec const &KalmanBoxTrackerT<MotionModel>::getState() const {
+    return xPost;
 }
 
-cv::Mat KalmanBoxTracker::convertBBoxToZ(cv::Mat const &bbox) {
-    assert(bbox.rows == 1 && bbox.cols >= 4);
-    float x = bbox.at<float>(0, 0);
-    float y = bbox.at<float>(0, 1);
-    float s = bbox.at<float>(0, 2) * bbox.at<float>(0, 3);
-    float r = bbox.at<float>(0, 2) / bbox.at<float>(0, 3);
+template<class MotionModel>
+size_t KalmanBoxTrackerT<MotionModel>::getMemoryBytes() const {
+    return sizeof(*this) + gallery.getMemoryBytes() + trajectory.getMemoryBytes();
+}
 
-    return (cv::Mat_<float>(KF_DIM_Z, 1) << x, y, s, r);  // NOLINT(modernize-return-braced-init-list)
+template<class MotionModel>
+typename KalmanBoxTrackerT<MotionModel>::StateVec const &KalmanBoxTrackerT<MotionModel>::getCurrentState() const {
+    return x;
 }
 
-cv::Mat KalmanBoxTracker::convertXToBBox(cv::Mat const &state) {
-    assert(state.rows == KF_DIM_X && state.cols == 1);
-    float x = state.at<float>(0, 0);
-    float y = state.at<float>(1, 0);
-    auto w = float(sqrt(double(state.at<float>(2, 0) * state.at<float>(3, 0))));
-    float h = state.at<float>(2, 0) / w;
+template<class MotionModel>
+typename KalmanBoxTrackerT<MotionModel>::StateMat const &KalmanBoxTrackerT<MotionModel>::getErrorCov() const {
+    return P;
+}
+
+template<class MotionModel>
+void KalmanBoxTrackerT<MotionModel>::smooth(StateVec *x, StateMat const *P, int count) {
+    for (int k = count - 2; k >= 0; --k) {
+        // the prediction made from x(k) by predict, x'(k+1) = F*x(k), P'(k+1) = F*P(k)*Ft + Q
+        StateVec xk = x[k];
+        MotionModel::constrain(xk);
+        StateMat FP = F * P[k];
+        StateMat PPred = FP * F.t() + MotionModel::processNoiseCov(xk);
+        StateVec xPred = F * xk;
+        // C(k) = P(k)*Ft*inv(P'(k+1)), xs(k) = x(k) + C(k)*(xs(k+1) - x'(k+1))
+        StateMat C = (PPred.inv(cv::DECOMP_CHOLESKY) * FP).t();
+        x[k] = xk + C * (x[k + 1] - xPred);
+    }
+}
+
+template<class MotionModel>
+cv::Vec4f KalmanBoxTrackerT<MotionModel>::readBBox(cv::Mat const &bbox) {
+    assert(bbox.rows == 1 && bbox.cols >= 4 && bbox.type() == CV_32F);
+    auto const *data = bbox.ptr<float>(0);
+    return {data[0], data[1], data[2], data[3]};
+}
+
+namespace ObjectTracking {
+    template class KalmanBoxTrackerT<ConstantVelocityModel>;
+
+    template class KalmanBoxTrackerT<ConstantAccelerationModel>;
 
-    return (cv::Mat_<float>(1, 4) << x, y, w, h);  // NOLINT(modernize-return-braced-init-list)
+    template class KalmanBoxTrackerT<XywhVelocityModel>;
 }
@@ -0,0 +1,61 @@
+#include "ObjectTracking/KeypointBoxConverter.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+
+using namespace ObjectTracking;
+
+KeypointBoxConverter::KeypointBoxConverter(float minConfidence, int minKeypoints, float padding)
+        : minConfidence(minConfidence), minKeypoints(std::max(minKeypoints, 1)), padding(padding) {}
+
+KeypointBoxConverter::~KeypointBoxConverter() = default;
+
+cv::Mat KeypointBoxConverter::convert(float const *keypoints, int numPersons, int numJoints, float const *scores,
+                                      float classId) {
+    assert(numPersons >= 0 && numJoints > 0 && (numPersons == 0 || keypoints != nullptr));
+    reserve(std::max(numPersons, 1));
+    personIndices.clear();
+    int numBoxes = 0;
+    for (int p = 0; p < numPersons; ++p) {
+        float const *joints = keypoints + (size_t) p * numJoints * 3;
+        // masked reductions, a missing joint contributes the neutral element
+        float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, confidenceSum = 0;
+        int count = 0;
+        for (int j = 0; j < numJoints; ++j) {
+            float x = joints[3 * j], y = joints[3 * j + 1], confidence = joints[3 * j + 2];
+            bool detected = confidence >= minConfidence && (x != 0 || y != 0);
+            minX = std::min(minX, detected ? x : FLT_MAX);
+            minY = std::min(minY, detected ? y : FLT_MAX);
+            maxX = std::max(maxX, detected ? x : -FLT_MAX);
+            maxY = std::max(maxY, detected ? y : -FLT_MAX);
+            confidenceSum += detected ? confidence : 0.0f;
+            count += detected;
+        }
+        if (count < minKeypoints) {
+            continue;
+        }
+
+        float w = (maxX - minX) * (1 + 2 * padding), h = (maxY - minY) * (1 + 2 * padding);
+        float *row = bboxesBuffer.ptr<float>(numBoxes++);
+        row[0] = (minX + maxX) / 2;
+        row[1] = (minY + maxY) / 2;
+        row[2] = w;
+        row[3] = h;
+        row[4] = scores != nullptr ? scores[p] : confidenceSum / (float) count;
+        row[5] = classId;
+        personIndices.push_back(p);
+    }
+    // view of the buffer, an empty rowRange would lose the column count
+    return {numBoxes, 6, CV_32F, bboxesBuffer.ptr<float>()};
+}
+
+std::vector<int> const &KeypointBoxConverter::getPersonIndices() const {
+    return personIndices;
+}
+
+void KeypointBoxConverter::reserve(int maxPersons) {
+    if (bboxesBuffer.rows < maxPersons) {
+        bboxesBuffer.create(std::max(maxPersons, 2 * bboxesBuffer.rows), 6, CV_32F);
+        personIndices.reserve(bboxesBuffer.rows);
+    }
+}
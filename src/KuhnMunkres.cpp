@@ -1,4 +1,7 @@
 #include "ObjectTracking/KuhnMunkres.h"
+#include <algorithm>
+#include <cmath>
+#include <ObjectTracking/MemoryUsage.h>
 
 using namespace ObjectTracking::kuhn_munkres;
 
@@ -9,17 +12,75 @@ KuhnMunkres::KuhnMunkres() = default;
 KuhnMunkres::~KuhnMunkres() = default;
 
 vector<pair<int, int>> KuhnMunkres::compute(Vec2f const &costMatrix) {
-    this->C = KuhnMunkres::padMatrix(costMatrix);
-    this->n = (int) C.size();
-    this->originalLength = (int) costMatrix.size();
-    this->originalWidth = (int) costMatrix.size() == 0 ? 0 : (int) costMatrix[0].size();
-    this->rowCovered = Vec1b(n, false);
-    this->colCovered = Vec1b(n, false);
+    int rows = (int) costMatrix.size();
+    int cols = 0;
+    for (auto const &row: costMatrix) cols = max(cols, int(row.size()));
+    // irregular rows are padded with zeros
+    Vec1f flat((size_t) rows * cols, 0.0f);
+    for (int i = 0; i < rows; ++i) {
+        std::copy(costMatrix[i].begin(), costMatrix[i].end(), flat.begin() + (long) i * cols);
+    }
+
+    vector<pair<int, int>> result;
+    compute(flat.data(), rows, cols, result);
+    return result;
+}
+
+void KuhnMunkres::compute(float const *costMatrix, int rows, int cols, vector<pair<int, int>> &result) {
+    initialize(costMatrix, rows, cols);
+    solve(result);
+}
+
+void KuhnMunkres::reserve(int maxRows, int maxCols) {
+    auto size = (size_t) max(maxRows, maxCols);
+    C.reserve(size * size);
+    marked.reserve(size * size);
+    rowCovered.reserve(size);
+    colCovered.reserve(size);
+    path.reserve((2 * size + 1) * 2);
+}
+
+size_t KuhnMunkres::getMemoryBytes() const {
+    return ObjectTracking::memory_usage::capacityBytes(C) + ObjectTracking::memory_usage::capacityBytes(rowCovered) +
+           ObjectTracking::memory_usage::capacityBytes(colCovered) + ObjectTracking::memory_usage::capacityBytes(marked) +
+           ObjectTracking::memory_usage::capacityBytes(path);
+}
+
+void KuhnMunkres::shrink() {
+    ObjectTracking::memory_usage::release(C);
+    ObjectTracking::memory_usage::release(rowCovered);
+    ObjectTracking::memory_usage::release(colCovered);
+    ObjectTracking::memory_usage::release(marked);
+    ObjectTracking::memory_usage::release(path);
+}
+
+void KuhnMunkres::initialize(float const *costMatrix, int rows, int cols) {
+    this->n = max(rows, cols);
+    this->originalLength = rows;
+    this->originalWidth = rows == 0 ? 0 : cols;
+    this->C.assign((size_t) n * n, 0.0f);
+    for (int i = 0; i < rows; ++i) {
+        float const *costRow = costMatrix + (long) i * cols;
+        bool finite = true;
+        for (int j = 0; j < cols; ++j) {
+            finite &= std::isfinite(costRow[j]);
+        }
+        if (!finite) {
+            throw NonFiniteCostException();
+        }
+        std::copy(costRow, costRow + cols, this->C.begin() + (long) i * n);
+    }
+    this->rowCovered.assign(n, false);
+    this->colCovered.assign(n, false);
     this->Z0_r = 0;
     this->Z0_c = 0;
-    this->path = Vec2i(n * n, Vec1i(2));
-    this->marked = KuhnMunkres::makeMatrix(n, 0);
-    vector<StepFunc> steps = {
+    // an augmenting path alternates primed and starred zeros, at most 2n + 1 of them
+    this->path.assign((size_t) (2 * n + 1) * 2, 0);
+    this->marked.assign((size_t) n * n, 0);
+}
+
+void KuhnMunkres::solve(vector<pair<int, int>> &result) {
+    static StepFunc const steps[] = {
             nullptr,
             &KuhnMunkres::step1,
             &KuhnMunkres::step2,
@@ -37,16 +98,14 @@ vector<pair<int, int>> KuhnMunkres::compute(Vec2f const &costMatrix) {
         step = (this->*func)();
     }
 
-    vector<pair<int, int>> result;
+    result.clear();
     for (int i = 0; i < this->originalLength; ++i) {
         for (int j = 0; j < this->originalWidth; ++j) {
-            if (this->marked[i][j] == 1) {
+            if (this->marked[i * n + j] == 1) {
                 result.emplace_back(i, j);
             }
         }
     }
-
-    return result;
 }
 
 Vec2f KuhnMunkres::makeCostMatrix(Vec2f const &profixMatrix, InversionFunc func) {
@@ -69,40 +128,13 @@ Vec2f KuhnMunkres::makeCostMatrix(Vec2f const &profixMatrix, InversionFunc func)
     return costMatrix;
 }
 
-Vec2f KuhnMunkres::padMatrix(Vec2f const &matrix, float const padValue) {
-    int maxColumns = 0;
-    int totalRows = (int) matrix.size();
-    for (auto const &row: matrix) maxColumns = max(maxColumns, int(row.size()));
-    totalRows = max(totalRows, maxColumns);
-
-    Vec2f newMatrix;
-    for (auto const &row: matrix) {
-        auto newRow = row;
-        while (newRow.size() < totalRows) {
-            // Row too short, pad it.
-            newRow.push_back(padValue);
-        }
-        newMatrix.push_back(newRow);
-    }
-
-    while (newMatrix.size() < totalRows) {
-        newMatrix.emplace_back(totalRows, padValue);
-    }
-
-    return newMatrix;
-}
-
-Vec2i KuhnMunkres::makeMatrix(int const &n, int const &val) {
-    return Vec2i(n, Vec1i(n, val));  // NOLINT(modernize-return-braced-init-list)
-}
-
 int KuhnMunkres::step1() {
     for (int i = 0; i < this->n; ++i) {
-        float minVal = *std::min_element(this->C[i].begin(), this->C[i].end());
+        float minVal = *std::min_element(this->C.begin() + (long) i * n, this->C.begin() + (long) (i + 1) * n);
         // Find the minimum value for this row and substract that mininum
         // from every element in the row.
         for (int j = 0; j < this->n; ++j)
-            this->C[i][j] -= minVal;
+            this->C[i * n + j] -= minVal;
     }
     return 2;
 }
@@ -110,8 +142,8 @@ int KuhnMunkres::step1() {
 int KuhnMunkres::step2() {
     for (int i = 0; i < this->n; ++i) {
         for (int j = 0; j < this->n; ++j) {
-            if (this->C[i][j] == 0 && !this->colCovered[j] && !this->rowCovered[i]) {
-                this->marked[i][j] = 1;
+            if (this->C[i * n + j] == 0 && !this->colCovered[j] && !this->rowCovered[i]) {
+                this->marked[i * n + j] = 1;
                 this->colCovered[j] = true;
                 this->rowCovered[i] = true;
                 break;
@@ -126,7 +158,7 @@ int KuhnMunkres::step3() {
     int count = 0;
     for (int i = 0; i < this->n; ++i) {
         for (int j = 0; j < this->n; ++j) {
-            if (this->marked[i][j] == 1 and !this->colCovered[j]) {
+            if (this->marked[i * n + j] == 1 and !this->colCovered[j]) {
                 this->colCovered[j] = true;
                 count += 1;
             }
@@ -147,7 +179,7 @@ int KuhnMunkres::step4() {
         if (row < 0) {
             return 6;
         } else {
-            this->marked[row][col] = 2;
+            this->marked[row * n + col] = 2;
             starCol = findStarInRow(row);
             if (starCol >= 0) {
                 col = starCol;
@@ -164,19 +196,19 @@ int KuhnMunkres::step4() {
 
 int KuhnMunkres::step5() {
     int count = 0;
-    this->path[count][0] = this->Z0_r;
-    this->path[count][1] = this->Z0_c;
+    this->path[2 * count] = this->Z0_r;
+    this->path[2 * count + 1] = this->Z0_c;
     while (true) {
-        int row = findStarInCol(this->path[count][1]);
+        int row = findStarInCol(this->path[2 * count + 1]);
         if (row >= 0) {
             count += 1;
-            this->path[count][0] = row;
-            this->path[count][1] = this->path[count - 1][1];
+            this->path[2 * count] = row;
+            this->path[2 * count + 1] = this->path[2 * (count - 1) + 1];
 
-            int col = findPrimeInRow(this->path[count][0]);
+            int col = findPrimeInRow(this->path[2 * count]);
             count += 1;
-            this->path[count][0] = this->path[count - 1][0];
-            this->path[count][1] = col;
+            this->path[2 * count] = this->path[2 * (count - 1)];
+            this->path[2 * count + 1] = col;
         } else {
             this->convertPath(path, count);
             this->clearCovers();
@@ -192,12 +224,12 @@ int KuhnMunkres::step6() {
     for (int i = 0; i < this->n; ++i) {
         for (int j = 0; j < this->n; ++j) {
             if (this->rowCovered[i]) {
-                this->C[i][j] += minVal;
+                this->C[i * n + j] += minVal;
                 events += 1;
             }
 
             if (!this->colCovered[j]) {
-                this->C[i][j] -= minVal;
+                this->C[i * n + j] -= minVal;
                 events += 1;
             }
 
@@ -218,8 +250,8 @@ float KuhnMunkres::findSmallest() const {
     float minVal = __FLT_MAX__;
     for (int i = 0; i < this->n; ++i) {
         for (int j = 0; j < this->n; ++j) {
-            if (!this->rowCovered[i] && !this->colCovered[j] && minVal > this->C[i][j]) {
-                minVal = this->C[i][j];
+            if (!this->rowCovered[i] && !this->colCovered[j] && minVal > this->C[i * n + j]) {
+                minVal = this->C[i * n + j];
             }
         }
     }
@@ -234,7 +266,7 @@ pair<int, int> KuhnMunkres::findAZero(int const i0, int const j0) const {
     while (!done) {
         int j = j0;
         while (true) {
-            if (this->C[i][j] == 0 && !this->rowCovered[i] & !this->colCovered[j]) {
+            if (this->C[i * n + j] == 0 && !this->rowCovered[i] & !this->colCovered[j]) {
                 row = i;
                 col = j;
                 done = true;
@@ -255,7 +287,7 @@ pair<int, int> KuhnMunkres::findAZero(int const i0, int const j0) const {
 
 int KuhnMunkres::findStarInRow(int const row) const {
     for (int j = 0; j < this->n; ++j) {
-        if (this->marked[row][j] == 1) {
+        if (this->marked[row * n + j] == 1) {
             return j;
         }
     }
@@ -264,7 +296,7 @@ int KuhnMunkres::findStarInRow(int const row) const {
 
 int KuhnMunkres::findStarInCol(int const col) const {
     for (int i = 0; i < this->n; ++i) {
-        if (this->marked[i][col] == 1) {
+        if (this->marked[i * n + col] == 1) {
             return i;
         }
     }
@@ -273,16 +305,16 @@ int KuhnMunkres::findStarInCol(int const col) const {
 
 int KuhnMunkres::findPrimeInRow(int const row) const {
     for (int j = 0; j < this->n; ++j) {
-        if (this->marked[row][j] == 2) {
+        if (this->marked[row * n + j] == 2) {
             return j;
         }
     }
     return -1;
 }
 
-void KuhnMunkres::convertPath(Vec2i const &_path, int const count) {
+void KuhnMunkres::convertPath(Vec1i const &_path, int const count) {
     for (int i = 0; i < count + 1; ++i) {
-        auto &x = this->marked[_path[i][0]][_path[i][1]];
+        auto &x = this->marked[_path[2 * i] * n + _path[2 * i + 1]];
         x = int(x != 1);
     }
 }
@@ -297,8 +329,8 @@ void KuhnMunkres::clearCovers() {
 void KuhnMunkres::erasePrimes() {
     for (int i = 0; i < this->n; ++i) {
         for (int j = 0; j < this->n; ++j) {
-            if (this->marked[i][j] == 2) {
-                this->marked[i][j] = 0;
+            if (this->marked[i * n + j] == 2) {
+                this->marked[i * n + j] = 0;
             }
         }
     }
@@ -0,0 +1,104 @@
+#include "ObjectTracking/MultiStreamTracker.h"
+
+using namespace ObjectTracking;
+
+template<class MotionModel>
+MultiStreamTrackerT<MotionModel>::MultiStreamTrackerT(int numStreams, int maxAge, int minHits, float iouThresh) {
+    assert(numStreams > 0);
+    for (int i = 0; i < numStreams; ++i) {
+        streams.push_back(make_shared<Stream>(maxAge, minHits, iouThresh));
+    }
+}
+
+template<class MotionModel>
+MultiStreamTrackerT<MotionModel>::MultiStreamTrackerT(int numStreams, TrackerCapacity const &capacity, int maxAge,
+                                                      int minHits, float iouThresh) {
+    assert(numStreams > 0);
+    for (int i = 0; i < numStreams; ++i) {
+        streams.push_back(make_shared<Stream>(capacity, maxAge, minHits, iouThresh));
+    }
+    int maxTracks = numStreams * capacity.maxTracks;
+    batchTrackers.reserve(maxTracks);
+    batchBBoxes.reserve(maxTracks);
+}
+
+template<class MotionModel>
+MultiStreamTrackerT<MotionModel>::~MultiStreamTrackerT() = default;
+
+template<class MotionModel>
+void MultiStreamTrackerT<MotionModel>::update(vector<cv::Mat> const &bboxesDet, vector<cv::Mat> &bboxesPost) {
+    update(bboxesDet, vector<cv::Mat>(), bboxesPost);
+}
+
+template<class MotionModel>
+void MultiStreamTrackerT<MotionModel>::update(vector<cv::Mat> const &bboxesDet, vector<cv::Mat> const &embeddings,
+                                              vector<cv::Mat> &bboxesPost) {
+    assert(bboxesDet.size() == streams.size() && (embeddings.empty() || embeddings.size() == streams.size()));
+    auto start = std::chrono::steady_clock::now();
+    int numStreams = (int) streams.size();
+    bboxesPost.resize(numStreams);
+    cv::Mat noEmbeddings;
+    for (int i = 0; i < numStreams; ++i) {
+        streams[i]->beginUpdate(bboxesDet[i], embeddings.empty() ? noEmbeddings : embeddings[i], &bboxesPost[i],
+                                nullptr);
+    }
+
+    // predict the trackers of all the streams at once
+    auto phaseStart = std::chrono::steady_clock::now();
+    batchTrackers.clear();
+    for (auto const &stream: streams) {
+        for (auto const &tracker: stream->trackers) {
+            batchTrackers.push_back(tracker.get());
+        }
+    }
+    kalman.predict(batchTrackers.data(), (int) batchTrackers.size());
+    stats.numTracks = (int) batchTrackers.size();
+    stats.predictTime = Stream::getElapsedMs(phaseStart);
+
+    for (auto const &stream: streams) {
+        stream->associateTracks();
+    }
+
+    // correct the matched trackers of all the streams at once
+    phaseStart = std::chrono::steady_clock::now();
+    batchTrackers.clear();
+    batchBBoxes.clear();
+    for (auto const &stream: streams) {
+        for (auto const &pair: stream->matchedDetPred) {
+            batchTrackers.push_back(stream->trackers[pair.second].get());
+            batchBBoxes.push_back(stream->stage.bboxesDet.template ptr<float>(pair.first));
+        }
+    }
+    kalman.update(batchTrackers.data(), batchBBoxes.data(), (int) batchTrackers.size());
+    stats.numCorrected = (int) batchTrackers.size();
+    stats.correctTime = Stream::getElapsedMs(phaseStart);
+
+    for (auto const &stream: streams) {
+        stream->endUpdate();
+    }
+    stats.totalTime = Stream::getElapsedMs(start);
+}
+
+template<class MotionModel>
+int MultiStreamTrackerT<MotionModel>::getStreamCount() const {
+    return (int) streams.size();
+}
+
+template<class MotionModel>
+typename MultiStreamTrackerT<MotionModel>::Stream::Ptr const &MultiStreamTrackerT<MotionModel>::getStream(
+        int index) const {
+    return streams[index];
+}
+
+template<class MotionModel>
+MultiStreamStats const &MultiStreamTrackerT<MotionModel>::getStats() const {
+    return stats;
+}
+
+namespace ObjectTracking {
+    template class MultiStreamTrackerT<ConstantVelocityModel>;
+
+    template class MultiStreamTrackerT<ConstantAccelerationModel>;
+
+    template class MultiStreamTrackerT<XywhVelocityModel>;
+}
@@ -1,81 +1,894 @@
 #include "ObjectTracking/ObjectTracker.h"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
 
 using namespace ObjectTracking;
 
-int const ObjectTracker::maxColors = 2022;
-std::vector<cv::Scalar> ObjectTracker::colors;
-bool ObjectTracker::colorsInitialized = false;
+namespace {
+    char const STATE_MAGIC[4] = {'O', 'T', 'S', 'T'};
+    uint32_t const STATE_VERSION = 1;
+    size_t const MODEL_NAME_BYTES = 32;
+}
+
+int const ObjectTrackerBase::maxColors = 2022;
+std::vector<cv::Scalar> ObjectTrackerBase::colors;
+std::once_flag ObjectTrackerBase::colorsInitialized;
 
-ObjectTracker::ObjectTracker(int maxAge, int minHits, float iouThresh)
+ObjectTrackerBase::ObjectTrackerBase(int maxAge, int minHits, float iouThresh)
         : maxAge(maxAge), minHits(minHits), iouThresh(iouThresh) {
-    km = std::make_shared<KuhnMunkres>();
-    if (!ObjectTracker::colorsInitialized) {
-        ObjectTracker::initializeColors();
+    assert(iouThresh > 0 && iouThresh <= 1);
+    stageStrategies.reserve(2);     // the main and the low-score stage
+    // trackers may be constructed in parallel, e.g. by the offline tracker
+    std::call_once(ObjectTrackerBase::colorsInitialized, ObjectTrackerBase::initializeColors);
+}
+
+ObjectTrackerBase::~ObjectTrackerBase() = default;
+
+void ObjectTrackerBase::setPreFilter(DetectionPreFilter::Ptr filter) {
+    if (filter != nullptr && isFixedCapacity()) {
+        filter->reserve(capacity.maxDetections);
+    }
+    preFilter = std::move(filter);
+}
+
+DetectionPreFilter::Ptr ObjectTrackerBase::getPreFilter() const {
+    return preFilter;
+}
+
+TrackerStats const &ObjectTrackerBase::getStats() const {
+    return stats;
+}
+
+SnapshotBuffer::Handle ObjectTrackerBase::getSnapshot() const {
+    return snapshots.acquire();
+}
+
+bool ObjectTrackerBase::sampleAt(int64_t time, vector<TrackSample> &samples, float maxExtrapolation) const {
+    SnapshotBuffer::Handle snapshot = snapshots.acquire();
+    if (!snapshot) {
+        samples.clear();
+        return false;
+    }
+    snapshot->sample(time, maxExtrapolation, samples);
+    return true;
+}
+
+bool ObjectTrackerBase::isFixedCapacity() const {
+    return capacity.maxTracks > 0;
+}
+
+TrackerCapacity const &ObjectTrackerBase::getCapacity() const {
+    return capacity;
+}
+
+void ObjectTrackerBase::reserveCapacity() {
+    int maxTracks = capacity.maxTracks, maxDetections = capacity.maxDetections;
+    assert(maxTracks > 0 && maxDetections > 0);
+    planner.reserve(maxDetections, maxTracks);
+    trackerIndexById.reserve(maxTracks);
+    reports.reserve(maxTracks);
+    detBoxes.reserve(maxDetections);
+    predBoxes.reserve(maxTracks);
+    bboxesFiltered.create(maxDetections, 6, CV_32F);
+    keptIndices.reserve(maxDetections);
+    filterIndices.reserve(maxDetections);
+    predBuffer.create(maxTracks, 6, CV_32F);
+    postBuffer.create(maxTracks, 9, CV_32F);
+    costBuffer.reserve((size_t) maxDetections * maxTracks);
+    stageDets.reserve(maxDetections);
+    stagePreds.reserve(maxTracks);
+    stageCost.reserve((size_t) maxDetections * maxTracks);
+    assignment.reserve(std::min(maxDetections, maxTracks));
+    detMatched.reserve(maxDetections);
+    predMatched.reserve(maxTracks);
+    matchedDetPred.reserve(std::min(maxDetections, maxTracks));
+    lostDets.reserve(maxDetections);
+    lostPreds.reserve(maxTracks);
+    galleries.reserve(maxTracks);
+    snapshots.reserve(maxTracks);
+    dormant.reserveFixed(maxTracks);
+    dormantMatches.reserve((size_t) maxDetections * maxTracks);
+    dormantCandidates.reserve(maxTracks);
+    dormantUsed.reserve(maxTracks);
+    revivalIds.reserve(maxDetections);
+    revivedIds.reserve(maxDetections);
+}
+
+void ObjectTrackerBase::selectDetections(cv::Mat const &bboxesInput) {
+    int numInput = bboxesInput.rows, maxDetections = capacity.maxDetections;
+    keptIndices.clear();
+    if (numInput > maxDetections) {
+        // bounded heap of the best detections, its front is the worst kept one
+        auto isBetter = [&](int a, int b) {
+            float scoreA = bboxesInput.at<float>(a, 4), scoreB = bboxesInput.at<float>(b, 4);
+            return scoreA > scoreB || (scoreA == scoreB && a < b);
+        };
+        for (int i = 0; i < numInput; ++i) {
+            if ((int) keptIndices.size() < maxDetections) {
+                keptIndices.push_back(i);
+                std::push_heap(keptIndices.begin(), keptIndices.end(), isBetter);
+            } else if (isBetter(i, keptIndices.front())) {
+                std::pop_heap(keptIndices.begin(), keptIndices.end(), isBetter);
+                keptIndices.back() = i;
+                std::push_heap(keptIndices.begin(), keptIndices.end(), isBetter);
+            }
+        }
+        std::sort(keptIndices.begin(), keptIndices.end());
+        stats.droppedDetections = numInput - maxDetections;
+    } else {
+        for (int i = 0; i < numInput; ++i) {
+            keptIndices.push_back(i);
+        }
+    }
+
+    int numKept = (int) keptIndices.size();
+    for (int k = 0; k < numKept; ++k) {
+        std::copy_n(bboxesInput.ptr<float>(keptIndices[k]), 6, bboxesFiltered.ptr<float>(k));
+    }
+    if (preFilter != nullptr && numKept > 0) {
+        preFilter->select(bboxesFiltered.rowRange(0, numKept), filterIndices);
+        // compact in place, filterIndices[k] >= k
+        numKept = (int) filterIndices.size();
+        for (int k = 0; k < numKept; ++k) {
+            int from = filterIndices[k];
+            if (from != k) {
+                keptIndices[k] = keptIndices[from];
+                std::copy_n(bboxesFiltered.ptr<float>(from), 6, bboxesFiltered.ptr<float>(k));
+            }
+        }
+        keptIndices.resize(numKept);
+    }
+    bboxesSelected = bboxesFiltered.rowRange(0, numKept);
+}
+
+void ObjectTrackerBase::indexTrack(int trackerId, float const *bbox) {
+    if (!isFixedCapacity()) {
+        trackIndex.set(trackerId, getBBoxRect(bbox));
     }
 }
 
-ObjectTracker::~ObjectTracker() = default;
+void ObjectTrackerBase::unindexTrack(int trackerId) {
+    if (!isFixedCapacity()) {
+        trackIndex.remove(trackerId);
+    }
+}
+
+void ObjectTrackerBase::setAppearanceParams(AppearanceParams const &params) {
+    assert(params.galleryCapacity > 0 && params.iouWeight >= 0 && params.iouWeight <= 1);
+    appearanceParams = params;
+}
+
+AppearanceParams const &ObjectTrackerBase::getAppearanceParams() const {
+    return appearanceParams;
+}
+
+void ObjectTrackerBase::setEventParams(TrackEventParams const &params) {
+    eventParams = params;
+}
+
+TrackEventParams const &ObjectTrackerBase::getEventParams() const {
+    return eventParams;
+}
+
+void ObjectTrackerBase::setCascadeParams(CascadeParams const &params) {
+    assert(params.scoreThresh >= 0 && params.lowIouThresh > 0 && params.lowIouThresh <= 1);
+    cascadeParams = params;
+}
+
+CascadeParams const &ObjectTrackerBase::getCascadeParams() const {
+    return cascadeParams;
+}
+
+void ObjectTrackerBase::setAssignmentParams(AssignmentParams const &params) {
+    planner.setParams(params);
+}
 
-cv::Mat ObjectTracker::update(cv::Mat const &bboxesDet) {
-    assert(bboxesDet.rows >= 0 && bboxesDet.cols == 6); // detections, [xc, yc, w, h, score, class_id]
+AssignmentParams const &ObjectTrackerBase::getAssignmentParams() const {
+    return planner.getParams();
+}
+
+void ObjectTrackerBase::loadAssignmentCalibration(std::string const &path) {
+    planner.loadCalibration(path);
+}
+
+void ObjectTrackerBase::getAssignmentCalibration(std::vector<double> &estimates) const {
+    planner.getCalibration(estimates);
+}
+
+void ObjectTrackerBase::setAssignmentCalibration(std::vector<double> const &estimates) {
+    planner.setCalibration(estimates);
+}
+
+std::vector<AssignmentStrategy> const &ObjectTrackerBase::getLastAssignmentStrategies() const {
+    return stageStrategies;
+}
+
+void ObjectTrackerBase::forceAssignmentStrategies(std::vector<AssignmentStrategy> const &strategies) {
+    forcedStrategies = strategies;
+}
+
+void ObjectTrackerBase::setMemoryParams(MemoryParams const &params) {
+    assert(params.window > 0);
+    memoryParams = params;
+    windowUpdates = 0;
+    windowSide = 0;
+}
+
+MemoryParams const &ObjectTrackerBase::getMemoryParams() const {
+    return memoryParams;
+}
 
-    // predictions used in data association, [xc, yc, w, h, score, class_id]
-    cv::Mat bboxesPred(0, 6, CV_32F, cv::Scalar(0));
-    // bounding boxes estimate, [xc, yc, w, h, score, class_id, vx, vy, tracker_id]
-    cv::Mat bboxesPost(0, 9, CV_32F, cv::Scalar(0));
+size_t ObjectTrackerBase::getSolverMemoryBytes() const {
+    using namespace memory_usage;
+    auto boxBytes = [](box_kernels::BoxSet const &boxes) {
+        return capacityBytes(boxes.x1) + capacityBytes(boxes.y1) + capacityBytes(boxes.x2) + capacityBytes(boxes.y2);
+    };
+    return planner.getMemoryBytes() + capacityBytes(costBuffer) + capacityBytes(stageDets) +
+           capacityBytes(stagePreds) + capacityBytes(stageCost) + capacityBytes(assignment) +
+           capacityBytes(detMatched) + capacityBytes(predMatched) + capacityBytes(matchedDetPred) +
+           capacityBytes(lostDets) + capacityBytes(lostPreds) + boxBytes(detBoxes) + boxBytes(predBoxes) +
+           capacityBytes(candidateIds) + appearanceMatcher.getMemoryBytes() + capacityBytes(galleries) +
+           matBytes(appearanceDist);
+}
 
+int ObjectTrackerBase::getHistoryLength() const {
+    return historyLength;
+}
+
+void ObjectTrackerBase::setDormantParams(DormantParams const &params) {
+    assert(params.maxDormantAge >= 0 && params.iouThresh > 0);
+    dormant.setParams(params);
+    stats.numDormantTracks = 0;
+}
+
+DormantParams const &ObjectTrackerBase::getDormantParams() const {
+    return dormant.getParams();
+}
+
+template<class MotionModel>
+ObjectTrackerT<MotionModel>::ObjectTrackerT(int maxAge, int minHits, float iouThresh)
+        : ObjectTrackerBase(maxAge, minHits, iouThresh) {}
+
+template<class MotionModel>
+ObjectTrackerT<MotionModel>::ObjectTrackerT(TrackerCapacity const &trackerCapacity, int maxAge, int minHits,
+                                           float iouThresh)
+        : ObjectTrackerBase(maxAge, minHits, iouThresh) {
+    capacity = trackerCapacity;
+    reserveCapacity();
+    trackers.reserve(capacity.maxTracks);
+    pool.reserve(capacity.maxTracks);
+    refillPool();
+}
+
+template<class MotionModel>
+ObjectTrackerT<MotionModel>::~ObjectTrackerT() = default;
+
+template<class MotionModel>
+cv::Mat ObjectTrackerT<MotionModel>::update(cv::Mat const &bboxesInput) {
+    return update(bboxesInput, cv::Mat());
+}
+
+template<class MotionModel>
+cv::Mat ObjectTrackerT<MotionModel>::update(cv::Mat const &bboxesInput, cv::Mat const &embeddingsInput) {
+    cv::Mat bboxesPost;
+    updateImpl(bboxesInput, embeddingsInput, &bboxesPost, nullptr);
+    return bboxesPost;
+}
+
+template<class MotionModel>
+void ObjectTrackerT<MotionModel>::updateEvents(cv::Mat const &bboxesInput, vector<TrackEvent> &eventsOut,
+                                               cv::Mat const &embeddingsInput) {
+    updateImpl(bboxesInput, embeddingsInput, nullptr, &eventsOut);
+}
+
+template<class MotionModel>
+void ObjectTrackerT<MotionModel>::updateImpl(cv::Mat const &bboxesInput, cv::Mat const &embeddingsInput,
+                                             cv::Mat *bboxesPost, vector<TrackEvent> *eventsOut) {
+    beginUpdate(bboxesInput, embeddingsInput, bboxesPost, eventsOut);
     // kalman bbox tracker predict
+    for (auto const &tracker: trackers) {
+        tracker->predict();
+    }
+    associateTracks();
+    // update matched trackers with assigned detections
+    for (auto pair: matchedDetPred) {
+        trackers[pair.second]->update(stage.bboxesDet.rowRange(pair.first, pair.first + 1));
+    }
+    endUpdate();
+}
+
+template<class MotionModel>
+void ObjectTrackerT<MotionModel>::beginUpdate(cv::Mat const &bboxesInput, cv::Mat const &embeddingsInput,
+                                              cv::Mat *bboxesPost, vector<TrackEvent> *eventsOut) {
+    assert(bboxesInput.rows >= 0 && bboxesInput.cols == 6); // detections, [xc, yc, w, h, score, class_id]
+    assert(embeddingsInput.empty() || (embeddingsInput.rows == bboxesInput.rows && embeddingsInput.type() == CV_32F));
+    bool withAppearance = !embeddingsInput.empty();
+    stage.start = std::chrono::steady_clock::now();
+    stage.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(stage.start.time_since_epoch()).count();
+    stage.withAppearance = withAppearance;
+    stage.bboxesPost = bboxesPost;
+    stats.frameCount++;
+    stats.numInputDetections = bboxesInput.rows;
+    stage.bboxesInput = bboxesInput;
+    stage.embeddingsInput = embeddingsInput;
+    events = eventsOut;
+    if (events != nullptr) {
+        events->clear();
+    }
+
+    // optional pre-filter, the rest of the update only sees the kept detections
+    auto phaseStart = std::chrono::steady_clock::now();
+    stats.droppedDetections = 0;
+    stats.droppedTracks = 0;
+    stats.revivedTracks = 0;
+    bool isFiltered = preFilter != nullptr || isFixedCapacity();
+    if (isFixedCapacity()) {
+        selectDetections(bboxesInput);
+    } else if (preFilter != nullptr) {
+        preFilter->apply(bboxesInput, bboxesFiltered, withAppearance ? &keptIndices : nullptr);
+    }
+    if (isFiltered && withAppearance) {
+        embeddingsFiltered.create((int) keptIndices.size(), embeddingsInput.cols, CV_32F);
+        for (int k = 0; k < (int) keptIndices.size(); ++k) {
+            std::copy_n(embeddingsInput.ptr<float>(keptIndices[k]), embeddingsInput.cols,
+                        embeddingsFiltered.ptr<float>(k));
+        }
+    }
+    stage.bboxesDet = isFixedCapacity() ? bboxesSelected : preFilter != nullptr ? bboxesFiltered : bboxesInput;
+    stage.embeddings = isFiltered ? embeddingsFiltered : embeddingsInput;
+    stats.numDetections = stage.bboxesDet.rows;
+    stats.preFilterTime = getElapsedMs(phaseStart);
+
+    // prediction rows used in data association [xc, yc, w, h, score, class_id] and output rows
+    // [xc, yc, w, h, score, class_id, vx, vy, tracker_id] are written to buffers, grown here in the default mode
+    if (predBuffer.rows < (int) trackers.size()) {
+        predBuffer.create(2 * (int) trackers.size(), 6, CV_32F);
+        postBuffer.create(2 * (int) trackers.size(), 9, CV_32F);
+    }
+    stage.phaseStart = std::chrono::steady_clock::now();
+}
+
+template<class MotionModel>
+void ObjectTrackerT<MotionModel>::associateTracks() {
+    // the trackers are predicted, their current box is the prediction
+    int numPred = 0;
+    trackerIndexById.clear();
     for (auto it = trackers.begin(); it != trackers.end();) {
-        cv::Mat bboxPred = (*it)->predict();   // Mat(1, 4)
-        if (isAnyNan<float>(bboxPred))
-            trackers.erase(it);     // remove the NAN value and corresponding tracker
-        else {
-            cv::hconcat(bboxPred, cv::Mat(1, 2, CV_32F, cv::Scalar(0)), bboxPred);   // Mat(1, 6)
-            cv::vconcat(bboxesPred, bboxPred, bboxesPred);  // Mat(N, 6)
+        cv::Vec4f bboxPred = (*it)->getBBox();
+        if (isAnyNan(bboxPred)) {
+            unindexTrack((*it)->getFilterId());
+            reportDeleted((*it)->getFilterId(), bboxPred.val);
+            if (isFixedCapacity()) {
+                pool.push_back(*it);
+            }
+            it = trackers.erase(it);    // remove the NAN value and corresponding tracker
+        } else {
+            float *predRow = predBuffer.ptr<float>(numPred);
+            std::copy_n(bboxPred.val, 4, predRow);
+            predRow[4] = predRow[5] = 0;
+            indexTrack((*it)->getFilterId(), bboxPred.val);
+            trackerIndexById[(*it)->getFilterId()] = numPred++;
             ++it;
         }
     }
+    stage.numPred = numPred;
+    cv::Mat bboxesPred = predBuffer.rowRange(0, numPred);   // Mat(N, 6)
 
-    TypeAssociate asTuple = dataAssociate(bboxesDet, bboxesPred);
-    TypeMatchedPairs matchedDetPred = std::get<0>(asTuple);
-    TypeLostDets lostDets = std::get<1>(asTuple);
-    TypeLostPreds lostPreds = std::get<2>(asTuple);
+    stats.predictTime = getElapsedMs(stage.phaseStart);
 
-    // update matched trackers with assigned detections
+    auto phaseStart = std::chrono::steady_clock::now();
+    if (stage.withAppearance) {
+        // galleries of another embedding dim (e.g. a new appearance model) match nothing until they are reset
+        static FeatureGallery const emptyGallery;
+        galleries.clear();
+        for (auto const &tracker: trackers) {
+            FeatureGallery const &gallery = tracker->getGallery();
+            galleries.push_back(gallery.getDim() == stage.embeddings.cols ? &gallery : &emptyGallery);
+        }
+        appearanceMatcher.computeDistances(stage.embeddings, galleries, appearanceDist);
+    }
+    dataAssociate(stage.bboxesDet, bboxesPred, stage.withAppearance ? &appearanceDist : nullptr);
+    stats.associateTime = getElapsedMs(phaseStart);
+    stage.phaseStart = std::chrono::steady_clock::now();
+}
+
+template<class MotionModel>
+void ObjectTrackerT<MotionModel>::endUpdate() {
+    cv::Mat const &bboxesDet = stage.bboxesDet, &embeddings = stage.embeddings;
+    cv::Mat bboxesPred = predBuffer.rowRange(0, stage.numPred);
+    bool withAppearance = stage.withAppearance;
+    int64_t timestamp = stage.timestamp;
+    int numOutput = 0;
+
+    // matched trackers are corrected, their current box is the correction
     for (auto pair: matchedDetPred) {
         int detInd = pair.first;
         int predInd = pair.second;
-        cv::Mat bboxPost = trackers[predInd]->update(bboxesDet.rowRange(detInd, detInd + 1));
+        cv::Vec4f bboxPost = trackers[predInd]->getBBox();
+        indexTrack(trackers[predInd]->getFilterId(), bboxPost.val);
+        if (historyLength > 0) {
+            recordTrajectory(*trackers[predInd], bboxPost.val, timestamp);
+        }
+        bool isLowScore = cascadeParams.scoreThresh > 0 && bboxesDet.at<float>(detInd, 4) < cascadeParams.scoreThresh;
+        if (withAppearance && !isLowScore) {
+            FeatureGallery &gallery = trackers[predInd]->getGallery();
+            // also reset when the appearance params changed since the gallery was created
+            if (gallery.getCapacity() != appearanceParams.galleryCapacity || gallery.getDim() != embeddings.cols ||
+                gallery.isQuantized() != appearanceParams.quantized) {
+                gallery.reset(appearanceParams.galleryCapacity, embeddings.cols, appearanceParams.quantized);
+            }
+            gallery.push(embeddings.ptr<float>(detInd));
+        }
 
-        if (trackers[predInd]->getHitStreak() >= minHits) {
-            float score = bboxesDet.at<float>(detInd, 4);
-            int classId = (int) bboxesDet.at<float>(detInd, 5);
-            float dx = trackers[predInd]->getState().at<float>(4, 0);
-            float dy = trackers[predInd]->getState().at<float>(5, 0);
-            int trackerId = trackers[predInd]->getFilterId();
-            cv::Mat tailData = (cv::Mat_<float>(1, 5) << score, classId, dx, dy, trackerId);
-            cv::hconcat(bboxPost, tailData, bboxPost);
-            cv::vconcat(bboxesPost, bboxPost, bboxesPost);  // Mat(N, 9)
+        bool isOutput = trackers[predInd]->getHitStreak() >= minHits;
+        float score = bboxesDet.at<float>(detInd, 4);
+        int classId = (int) bboxesDet.at<float>(detInd, 5);
+        cv::Vec2f velocity = trackers[predInd]->getVelocity();
+        int trackerId = trackers[predInd]->getFilterId();
+        reportMatched(trackerId, bboxPost, score, (float) classId, velocity, isOutput);
+        if (isOutput) {
+            if (stage.bboxesPost != nullptr) {
+                float *postRow = postBuffer.ptr<float>(numOutput);
+                std::copy_n(bboxPost.val, 4, postRow);
+                postRow[4] = score;
+                postRow[5] = (float) classId;
+                postRow[6] = velocity[0];
+                postRow[7] = velocity[1];
+                postRow[8] = (float) trackerId;
+            }
+            numOutput++;
         }
     }
 
-    // remove dead trackers
+    // unmatched trackers kept alive coast on their prediction
+    for (int predInd: lostPreds) {
+        if (trackers[predInd]->getTimeSinceUpdate() <= maxAge) {
+            reportLost(trackers[predInd]->getFilterId(), bboxesPred.ptr<float>(predInd),
+                       trackers[predInd]->getVelocity());
+        }
+    }
+
+    // remove dead trackers, their box is still the prediction
     trackers.erase(std::remove_if(trackers.begin(), trackers.end(),
-                                  [&](KalmanBoxTracker::Ptr const &kbt) -> bool {
-                                      return kbt->getTimeSinceUpdate() > this->maxAge;
+                                  [&](typename Tracker::Ptr const &kbt) -> bool {
+                                      if (kbt->getTimeSinceUpdate() > this->maxAge) {
+                                          unindexTrack(kbt->getFilterId());
+                                          addDormant(kbt->getFilterId(),
+                                                     stats.frameCount - kbt->getTimeSinceUpdate(),
+                                                     MotionModel::xToBBox(kbt->getState()), kbt->getVelocity());
+                                          reportDeleted(kbt->getFilterId(), kbt->getBBox().val);
+                                          if (isFixedCapacity()) {
+                                              pool.push_back(kbt);
+                                          }
+                                          return true;
+                                      }
+                                      return false;
                                   }), trackers.end());
 
+    // over capacity, only the highest scored unmatched detections start tracks
+    if (isFixedCapacity() && trackers.size() + lostDets.size() > (size_t) capacity.maxTracks) {
+        int room = capacity.maxTracks - (int) trackers.size();
+        std::sort(lostDets.begin(), lostDets.end(), [&](int a, int b) {
+            float scoreA = bboxesDet.at<float>(a, 4), scoreB = bboxesDet.at<float>(b, 4);
+            return scoreA > scoreB || (scoreA == scoreB && a < b);
+        });
+        stats.droppedTracks = (int) lostDets.size() - room;
+        lostDets.resize(room);
+        std::sort(lostDets.begin(), lostDets.end());
+    }
+
+    // unmatched detections revive dormant tracks if they can
+    reviveDormant(bboxesDet);
+
     // create and initialize new trackers for unmatched detections
-    for (int lostInd: lostDets) {
+    for (int k = 0; k < (int) lostDets.size(); ++k) {
+        int lostInd = lostDets[k];
         cv::Mat lostBbox = bboxesDet.rowRange(lostInd, lostInd + 1);
-        trackers.push_back(make_shared<KalmanBoxTracker>(lostBbox));
+        trackers.push_back(createTracker(lostBbox, revivalIds[k]));
+        if (withAppearance) {
+            FeatureGallery &gallery = trackers.back()->getGallery();
+            gallery.reset(appearanceParams.galleryCapacity, embeddings.cols, appearanceParams.quantized);
+            gallery.push(embeddings.ptr<float>(lostInd));
+        }
+        if (historyLength > 0) {
+            recordTrajectory(*trackers.back(), lostBbox.ptr<float>(0), timestamp);
+        }
+        indexTrack(trackers.back()->getFilterId(), lostBbox.ptr<float>(0));
+        reportCreated(trackers.back()->getFilterId(), lostBbox.ptr<float>(0), revivalIds[k] >= 0);
     }
 
-    return bboxesPost;
+    trackerIndexById.clear();
+    for (int i = 0; i < (int) trackers.size(); ++i) {
+        trackerIndexById[trackers[i]->getFilterId()] = i;
+    }
+    stats.correctTime = getElapsedMs(stage.phaseStart);
+
+    publishSnapshot();
+
+    if (stage.bboxesPost != nullptr) {
+        if (isFixedCapacity()) {
+            // view of the buffer, an empty rowRange would lose the column count
+            *stage.bboxesPost = cv::Mat(numOutput, 9, CV_32F, postBuffer.ptr<float>());
+        } else if (numOutput == 0) {
+            *stage.bboxesPost = cv::Mat(0, 9, CV_32F);
+        } else {
+            *stage.bboxesPost = postBuffer.rowRange(0, numOutput).clone();
+        }
+    }
+    stats.numTracks = (int) trackers.size();
+    stats.numOutputTracks = numOutput;
+    if (recorder != nullptr) {
+        // recorded once associated, with the strategies the replay has to force
+        recorder->record(stats.frameCount, stage.timestamp, stage.bboxesInput, stage.embeddingsInput,
+                         stageStrategies);
+    }
+    forcedStrategies.clear();
+    applyMemoryPolicy(std::max(stage.bboxesDet.rows, stage.numPred));
+    stats.totalTime = getElapsedMs(stage.start);
+    events = nullptr;
+    // the input is not referenced after the update
+    stage.bboxesInput.release();
+    stage.embeddingsInput.release();
+    stage.bboxesDet.release();
+    stage.embeddings.release();
+    stage.bboxesPost = nullptr;
+}
+
+template<class MotionModel>
+void ObjectTrackerT<MotionModel>::publishSnapshot() {
+    int64_t prevTimestamp = lastTimestamp > 0 ? lastTimestamp : stage.timestamp;
+    if (lastTimestamp > 0) {
+        auto interval = double(stage.timestamp - lastTimestamp);
+        framePeriod = framePeriod > 0 ? 0.9 * framePeriod + 0.1 * interval : interval;
+    }
+    lastTimestamp = stage.timestamp;
+
+    TrackSnapshot *snapshot = snapshots.beginWrite();
+    if (snapshot != nullptr) {
+        snapshot->frame = stats.frameCount;
+        snapshot->timestamp = stage.timestamp;
+        snapshot->prevTimestamp = prevTimestamp;
+        snapshot->framePeriod = framePeriod;
+        snapshot->areaRatio = MotionModel::areaRatio;
+        snapshot->tracks.clear();
+    } else {
+        stats.skippedSnapshots++;
+    }
+    for (auto const &tracker: trackers) {
+        cv::Vec4f bbox = tracker->getBBox();
+        TrackReport &report = reports[tracker->getFilterId()];
+        // the box of the previous update, kept even when a publication is skipped
+        cv::Vec4f prevBox = report.lastBoxFrame == stats.frameCount - 1 ? report.lastBox : bbox;
+        report.lastBox = bbox;
+        report.lastBoxFrame = stats.frameCount;
+        if (snapshot == nullptr) {
+            continue;
+        }
+        cv::Vec2f velocity = tracker->getVelocity();
+        cv::Vec4f dz, ddz;
+        MotionModel::motion(tracker->getState(), dz, ddz);
+        snapshot->tracks.push_back({tracker->getFilterId(), bbox[0], bbox[1], bbox[2], bbox[3], velocity[0],
+                                    velocity[1], report.score, report.classId, tracker->getHitStreak(),
+                                    tracker->getTimeSinceUpdate(), report.visible, prevBox[0], prevBox[1],
+                                    prevBox[2], prevBox[3], {dz[0], dz[1], dz[2], dz[3]},
+                                    {ddz[0], ddz[1], ddz[2], ddz[3]}});
+    }
+    if (snapshot != nullptr) {
+        snapshots.publish();
+    }
 }
 
-void ObjectTracker::draw(cv::Mat &img, cv::Mat const &bboxes, bool withScore) {
+template<class MotionModel>
+typename ObjectTrackerT<MotionModel>::Tracker::Ptr ObjectTrackerT<MotionModel>::createTracker(cv::Mat const &bbox,
+                                                                                             int trackerId) {
+    typename Tracker::Ptr tracker;
+    if (isFixedCapacity()) {
+        assert(!pool.empty());
+        tracker = std::move(pool.back());
+        pool.pop_back();
+    } else if (trackerId < 0) {
+        return make_shared<Tracker>(bbox);
+    } else {
+        tracker = make_shared<Tracker>(-1, typename Tracker::StateVec(), typename Tracker::StateMat(),
+                                       typename Tracker::StateVec(), 0, 0);
+    }
+    if (trackerId < 0) {
+        tracker->reset(bbox);
+    } else {
+        // a revived track is output on its next match
+        tracker->reset(bbox, trackerId, std::max(minHits - 1, 0));
+    }
+    return tracker;
+}
+
+template<class MotionModel>
+void ObjectTrackerT<MotionModel>::recordTrajectory(Tracker &tracker, float const *bbox, int64_t timestamp) {
+    TrajectoryBuffer &trajectory = tracker.getTrajectory();
+    if (trajectory.getCapacity() != historyLength) {
+        trajectory.reset(historyLength);
+    }
+    trajectory.push({stats.frameCount, timestamp, bbox[0], bbox[1], bbox[2], bbox[3]});
+}
+
+template<class MotionModel>
+void ObjectTrackerT<MotionModel>::refillPool() {
+    auto size = (size_t) capacity.maxTracks - std::min(trackers.size(), (size_t) capacity.maxTracks);
+    while (pool.size() < size) {
+        // placeholder trackers, they get an id when reset
+        pool.push_back(make_shared<Tracker>(-1, typename Tracker::StateVec(), typename Tracker::StateMat(),
+                                            typename Tracker::StateVec(), 0, 0));
+        pool.back()->getTrajectory().reset(historyLength);
+    }
+    pool.resize(size);
+}
+
+template<class MotionModel>
+void ObjectTrackerT<MotionModel>::setRecorder(SessionRecorder::Ptr sessionRecorder) {
+    if (sessionRecorder != nullptr) {
+        SessionConfig config;
+        config.motionModel = MotionModel::name;
+        config.maxAge = maxAge;
+        config.minHits = minHits;
+        config.iouThresh = iouThresh;
+        config.firstTrackerId = KalmanBoxTrackerBase::getFilterCount();
+        config.appearance = appearanceParams;
+        config.dormant = dormant.getParams();
+        config.cascadeScoreThresh = cascadeParams.scoreThresh;
+        config.cascadeLowIouThresh = cascadeParams.lowIouThresh;
+        config.assignment = planner.getParams();
+        planner.getCalibration(config.assignmentCalibration);
+        config.maxTracks = capacity.maxTracks;
+        config.maxDetections = capacity.maxDetections;
+        if (preFilter != nullptr) {
+            config.hasPreFilter = true;
+            config.scoreThresh = preFilter->getScoreThresh();
+            config.nmsIouThresh = preFilter->getNmsIouThresh();
+            config.classAware = preFilter->isClassAware();
+        }
+        sessionRecorder->begin(config);
+    }
+    recorder = std::move(sessionRecorder);
+}
+
+template<class MotionModel>
+void ObjectTrackerT<MotionModel>::saveState(std::vector<uint8_t> &blob) const {
+    blob.clear();
+    blob::Writer writer(blob);
+    char modelName[MODEL_NAME_BYTES] = {};
+    std::strncpy(modelName, MotionModel::name, MODEL_NAME_BYTES - 1);
+    writer.putBytes(STATE_MAGIC, sizeof(STATE_MAGIC));
+    writer.put(STATE_VERSION);
+    writer.putBytes(modelName, MODEL_NAME_BYTES);
+    writer.put((int32_t) MotionModel::dimX);
+
+    // configuration
+    writer.put((int32_t) maxAge);
+    writer.put((int32_t) minHits);
+    writer.put(iouThresh);
+    writer.put((int32_t) appearanceParams.galleryCapacity);
+    writer.put(appearanceParams.iouWeight);
+    writer.put(appearanceParams.maxCosineDistance);
+    writer.put((uint8_t) appearanceParams.quantized);
+    writer.put(eventParams.minMove);
+    writer.put(eventParams.minSizeChange);
+
+    // counters
+    writer.put((int32_t) stats.frameCount);
+    writer.put((int32_t) KalmanBoxTrackerBase::getFilterCount());
+
+    writer.put((int32_t) trackers.size());
+    for (auto const &tracker: trackers) {
+        writer.put((int32_t) tracker->getFilterId());
+        writer.put((int32_t) tracker->getTimeSinceUpdate());
+        writer.put((int32_t) tracker->getHitStreak());
+        writer.putBytes(tracker->getCurrentState().val, sizeof(tracker->getCurrentState().val));
+        writer.putBytes(tracker->getErrorCov().val, sizeof(tracker->getErrorCov().val));
+        writer.putBytes(tracker->getState().val, sizeof(tracker->getState().val));
+
+        TrackReport const &report = reports.at(tracker->getFilterId());
+        writer.put((uint8_t) report.visible);
+        writer.put((uint8_t) report.confirmed);
+        writer.putBytes(report.box.val, sizeof(report.box.val));
+        writer.put(report.score);
+        writer.put(report.classId);
+
+        tracker->getGallery().save(writer);
+    }
+}
+
+template<class MotionModel>
+void ObjectTrackerT<MotionModel>::restoreState(std::vector<uint8_t> const &blob) {
+    blob::Reader reader(blob.data(), blob.size());
+    char magic[sizeof(STATE_MAGIC)];
+    uint32_t version = 0;
+    char modelName[MODEL_NAME_BYTES];
+    int32_t dimX = 0;
+    if (!reader.getBytes(magic, sizeof(magic)) || std::memcmp(magic, STATE_MAGIC, sizeof(magic)) != 0 ||
+        !reader.get(version) || version != STATE_VERSION || !reader.getBytes(modelName, MODEL_NAME_BYTES)) {
+        throw std::runtime_error("not a tracker state");
+    }
+    modelName[MODEL_NAME_BYTES - 1] = '\0';
+    if (std::strcmp(modelName, MotionModel::name) != 0 || !reader.get(dimX) || dimX != MotionModel::dimX) {
+        throw std::runtime_error(std::string("tracker state of motion model ") + modelName + ", expected " +
+                                 MotionModel::name);
+    }
+
+    // parse everything before changing the tracker
+    int32_t newMaxAge, newMinHits, galleryCapacity, frameCount, filterCount, numTrackers;
+    float newIouThresh;
+    uint8_t quantized;
+    AppearanceParams newAppearanceParams;
+    TrackEventParams newEventParams;
+    bool valid = reader.get(newMaxAge) && reader.get(newMinHits) && reader.get(newIouThresh) &&
+                 reader.get(galleryCapacity) && reader.get(newAppearanceParams.iouWeight) &&
+                 reader.get(newAppearanceParams.maxCosineDistance) && reader.get(quantized) &&
+                 reader.get(newEventParams.minMove) && reader.get(newEventParams.minSizeChange) &&
+                 reader.get(frameCount) && reader.get(filterCount) && reader.get(numTrackers) && numTrackers >= 0 &&
+                 newIouThresh > 0 && newIouThresh <= 1;
+    newAppearanceParams.galleryCapacity = galleryCapacity;
+    newAppearanceParams.quantized = quantized != 0;
+
+    vector<typename Tracker::Ptr> newTrackers;
+    vector<TrackReport> newReports;
+    for (int i = 0; valid && i < numTrackers; ++i) {
+        int32_t id, timeSinceUpdate, hitStreak;
+        typename Tracker::StateVec x, xPost;
+        typename Tracker::StateMat P;
+        uint8_t visible, confirmed;
+        TrackReport report;
+        valid = reader.get(id) && reader.get(timeSinceUpdate) && reader.get(hitStreak) &&
+                reader.getBytes(x.val, sizeof(x.val)) && reader.getBytes(P.val, sizeof(P.val)) &&
+                reader.getBytes(xPost.val, sizeof(xPost.val)) && reader.get(visible) && reader.get(confirmed) &&
+                reader.getBytes(report.box.val, sizeof(report.box.val)) && reader.get(report.score) &&
+                reader.get(report.classId);
+        if (valid) {
+            report.visible = visible != 0;
+            report.confirmed = confirmed != 0;
+            newTrackers.push_back(make_shared<Tracker>(id, x, P, xPost, timeSinceUpdate, hitStreak));
+            newReports.push_back(report);
+            valid = newTrackers.back()->getGallery().load(reader);
+        }
+    }
+    if (!valid || !reader.atEnd()) {
+        throw std::runtime_error("truncated or invalid tracker state");
+    }
+    if (isFixedCapacity() && numTrackers > capacity.maxTracks) {
+        throw std::runtime_error("tracker state with " + std::to_string(numTrackers) + " trackers, capacity is " +
+                                 std::to_string(capacity.maxTracks));
+    }
+
+    maxAge = newMaxAge;
+    minHits = newMinHits;
+    iouThresh = newIouThresh;
+    appearanceParams = newAppearanceParams;
+    eventParams = newEventParams;
+    stats.frameCount = frameCount;
+    lastTimestamp = 0;      // the restored tracks start a new timeline for the snapshots
+    framePeriod = 0;
+    if (KalmanBoxTrackerBase::getFilterCount() < filterCount) {
+        KalmanBoxTrackerBase::setFilterCount(filterCount);
+    }
+
+    trackers.swap(newTrackers);
+    if (isFixedCapacity()) {
+        // the replaced trackers go back to the pool
+        pool.insert(pool.end(), newTrackers.begin(), newTrackers.end());
+        refillPool();
+    }
+    trackIndex.clear();
+    trackerIndexById.clear();
+    reports.clear();
+    dormant.clear();
+    stats.numDormantTracks = 0;
+    for (int i = 0; i < (int) trackers.size(); ++i) {
+        int trackerId = trackers[i]->getFilterId();
+        indexTrack(trackerId, trackers[i]->getBBox().val);
+        trackerIndexById[trackerId] = i;
+        reports[trackerId] = newReports[i];
+        trackers[i]->getTrajectory().reset(historyLength);    // the history is not saved, it starts empty
+    }
+    stats.numTracks = (int) trackers.size();
+}
+
+template<class MotionModel>
+vector<typename ObjectTrackerT<MotionModel>::Tracker::Ptr> const &ObjectTrackerT<MotionModel>::getTrackers() const {
+    return trackers;
+}
+
+template<class MotionModel>
+MemoryUsage ObjectTrackerT<MotionModel>::getMemoryUsage() const {
+    // make_shared allocates the tracker with the control block of its shared_ptr (two counters and a vtable)
+    size_t const controlBlockBytes = 2 * sizeof(int) + sizeof(void *);
+    MemoryUsage usage;
+    size_t trackerBytes = 0;
+    for (auto const &tracker: trackers) {
+        trackerBytes += tracker->getMemoryBytes() + controlBlockBytes;
+    }
+    usage.tracks = trackerBytes + memory_usage::capacityBytes(trackers);
+    for (auto const &tracker: pool) {
+        usage.pooledTracks += tracker->getMemoryBytes() + controlBlockBytes;
+    }
+    usage.pooledTracks += memory_usage::capacityBytes(pool);
+    addBaseMemoryUsage(usage);
+    usage.total = usage.tracks + usage.pooledTracks + usage.solver + usage.outputs + usage.dormant;
+    usage.numTracks = (int) trackers.size();
+    usage.bytesPerTrack = trackers.empty() ? 0 : trackerBytes / trackers.size();
+    return usage;
+}
+
+template<class MotionModel>
+void ObjectTrackerT<MotionModel>::shrinkToFit() {
+    if (isFixedCapacity()) {
+        return;
+    }
+    releaseSolverMemory();
+    windowUpdates = 0;
+    windowSide = 0;
+    peakSide = 0;
+    // grown again by the next update, the output of update is always a copy in the default mode
+    predBuffer.release();
+    postBuffer.release();
+    memory_usage::release(dormantMatches);
+    memory_usage::release(dormantCandidates);
+    memory_usage::release(dormantUsed);
+    memory_usage::release(revivalIds);
+    memory_usage::release(revivedIds);
+    trackers.shrink_to_fit();
+    reports.shrink();
+    trackerIndexById.shrink();
+    trackIndex.shrink();
+}
+
+template<class MotionModel>
+void ObjectTrackerT<MotionModel>::setHistoryLength(int length) {
+    assert(length >= 0);
+    historyLength = length;
+    for (auto const &tracker: trackers) {
+        tracker->getTrajectory().reset(length);
+    }
+    for (auto const &tracker: pool) {
+        tracker->getTrajectory().reset(length);
+    }
+}
+
+template<class MotionModel>
+TrajectorySpan ObjectTrackerT<MotionModel>::getTrajectory(int trackerId) const {
+    int const *index = trackerIndexById.find(trackerId);
+    if (index == nullptr) {
+        return {};
+    }
+    return trackers[*index]->getTrajectory().getPoints();
+}
+
+template<class MotionModel>
+void ObjectTrackerT<MotionModel>::queryRegion(cv::Rect2f const &region, vector<int> &trackerIds) {
+    if (isFixedCapacity()) {
+        // no spatial index, the track count is bounded
+        for (auto const &tracker: trackers) {
+            cv::Rect rect = getBBoxRect(tracker->getBBox().val);
+            if (tracker->getHitStreak() >= minHits && rect.width > 0 && rect.height > 0 &&
+                (float) rect.x < region.x + region.width && region.x < (float) (rect.x + rect.width) &&
+                (float) rect.y < region.y + region.height && region.y < (float) (rect.y + rect.height)) {
+                trackerIds.push_back(tracker->getFilterId());
+            }
+        }
+        return;
+    }
+    size_t first = trackerIds.size();
+    trackIndex.query(region, trackerIds);
+    trackerIds.erase(std::remove_if(trackerIds.begin() + (long) first, trackerIds.end(), [&](int trackerId) {
+        return trackers[trackerIndexById.at(trackerId)]->getHitStreak() < minHits;
+    }), trackerIds.end());
+}
+
+cv::Scalar const &ObjectTrackerBase::getColor(int trackerId) {
+    std::call_once(ObjectTrackerBase::colorsInitialized, ObjectTrackerBase::initializeColors);
+    return ObjectTrackerBase::colors[trackerId % ObjectTrackerBase::maxColors];
+}
+
+void ObjectTrackerBase::draw(cv::Mat &img, cv::Mat const &bboxes, bool withScore) {
     float xc, yc, w, h, score, dx, dy;
     int trackerId;
     std::string sScore;
@@ -90,89 +903,370 @@ void ObjectTracker::draw(cv::Mat &img, cv::Mat const &bboxes, bool withScore) {
         trackerId = int(bboxes.at<float>(i, 8));
 
         cv::rectangle(img, cv::Rect(int(xc - w / 2), int(yc - h / 2), int(w), int(h)),
-                      ObjectTracker::colors[trackerId % ObjectTracker::maxColors], 2);
+                      ObjectTrackerBase::colors[trackerId % ObjectTrackerBase::maxColors], 2);
         sScore = std::to_string(trackerId);
         if (withScore) {
             sScore += ": " + std::to_string(score);
         }
         cv::putText(img, sScore, cv::Point(int(xc - w / 2), int(yc - h / 2 - 4)),
-                    cv::FONT_HERSHEY_PLAIN, 1.5, ObjectTracker::colors[trackerId % ObjectTracker::maxColors], 2);
+                    cv::FONT_HERSHEY_PLAIN, 1.5, ObjectTrackerBase::colors[trackerId % ObjectTrackerBase::maxColors], 2);
         cv::arrowedLine(img, cv::Point(int(xc), int(yc)), cv::Point(int(xc + 5 * dx), int(yc + 5 * dy)),
-                        ObjectTracker::colors[trackerId % ObjectTracker::maxColors], 4);
+                        ObjectTrackerBase::colors[trackerId % ObjectTrackerBase::maxColors], 4);
     }
 }
 
-TypeAssociate ObjectTracker::dataAssociate(cv::Mat const &bboxesDet, cv::Mat const &bboxesPred) {
-    TypeMatchedPairs matchedDetPred;
-    TypeLostDets lostDets;
-    TypeLostPreds lostPreds;
+void ObjectTrackerBase::dataAssociate(cv::Mat const &bboxesDet, cv::Mat const &bboxesPred, cv::Mat const *cosineDist) {
+    int numDet = bboxesDet.rows, numPred = bboxesPred.rows;
+    float scoreThresh = cascadeParams.scoreThresh;
+    bool cascaded = scoreThresh > 0;
+    auto isHighScore = [&](int detInd) { return !cascaded || bboxesDet.at<float>(detInd, 4) >= scoreThresh; };
+    matchedDetPred.clear();
+    lostDets.clear();
+    lostPreds.clear();
+    detMatched.assign(numDet, 0);
+    predMatched.assign(numPred, 0);
+    stats.numLowScoreDetections = 0;
+    stats.assignmentStrategy = AssignmentStrategy::Dense;
+    stats.numAssignmentComponents = 0;
+    stageStrategies.clear();
 
-    // initialize
-    for (int i = 0; i < bboxesDet.rows; ++i) {
-        lostDets.push_back(i);  // size M
-    }
-    for (int j = 0; j < bboxesPred.rows; ++j) {
-        lostPreds.push_back(j); // size N
+    // nothing detected or predicted leaves everything lost
+    if (numDet > 0 && numPred > 0) {
+        // compute IoU matrix, Mat(M, N), the stages build their cost matrices from it
+        costBuffer.resize((size_t) numDet * numPred);
+        computeIouMatrix(bboxesDet, bboxesPred, costBuffer.data());
+
+        // high-score detections with all the predictions, all the detections without the cascade
+        stageDets.clear();
+        stagePreds.clear();
+        for (int i = 0; i < numDet; ++i) {
+            if (isHighScore(i)) {
+                stageDets.push_back(i);
+            }
+        }
+        for (int j = 0; j < numPred; ++j) {
+            stagePreds.push_back(j);
+        }
+        associateStage(cosineDist, iouThresh);
+        if (!stageDets.empty()) {
+            stats.assignmentStrategy = planner.getLastStrategy();
+            stats.numAssignmentComponents = planner.getLastComponents();
+        }
+
+        // low-score detections with the predictions left, by IoU only
+        if (cascaded) {
+            stageDets.clear();
+            stagePreds.clear();
+            for (int i = 0; i < numDet; ++i) {
+                if (!isHighScore(i)) {
+                    stageDets.push_back(i);
+                }
+            }
+            for (int j = 0; j < numPred; ++j) {
+                if (!predMatched[j]) {
+                    stagePreds.push_back(j);
+                }
+            }
+            stats.numLowScoreDetections = (int) stageDets.size();
+            associateStage(nullptr, cascadeParams.lowIouThresh);
+        }
+    } else if (cascaded) {
+        for (int i = 0; i < numDet; ++i) {
+            stats.numLowScoreDetections += isHighScore(i) ? 0 : 1;
+        }
     }
 
-    // nothing detected or predicted
-    if (bboxesDet.rows == 0 || bboxesPred.rows == 0) {
-        return make_tuple(matchedDetPred, lostDets, lostPreds);
+    // lost detect and predict, in increasing order; unmatched low-score detections are dropped
+    for (int i = 0; i < numDet; ++i) {
+        if (!detMatched[i] && isHighScore(i)) {
+            lostDets.push_back(i);
+        }
+    }
+    for (int j = 0; j < numPred; ++j) {
+        if (!predMatched[j]) {
+            lostPreds.push_back(j);
+        }
     }
+}
 
-    // compute IoU matrix
-    cv::Mat iouMat = getIouMatrix(bboxesDet, bboxesPred);   // Mat(M, N)
+void ObjectTrackerBase::associateStage(cv::Mat const *cosineDist, float minIou) {
+    int numRows = (int) stageDets.size(), numCols = (int) stagePreds.size(), numPred = (int) predMatched.size();
+    if (numRows == 0 || numCols == 0) {
+        return;
+    }
 
-    // Kuhn Munkres assignment algorithm
-    Vec2f costMatrix(iouMat.rows, Vec1f(iouMat.cols, 0.0f));
-    for (int i = 0; i < iouMat.rows; ++i) {
-        for (int j = 0; j < iouMat.cols; ++j) {
-            costMatrix[i][j] = 1.0f - iouMat.at<float>(i, j);
+    // cost matrix of the stage, 1 - IoU or fused with the appearance
+    stageCost.resize((size_t) numRows * numCols);
+    for (int r = 0; r < numRows; ++r) {
+        float const *iouRow = costBuffer.data() + (size_t) stageDets[r] * numPred;
+        float *costRow = stageCost.data() + (size_t) r * numCols;
+        if (cosineDist != nullptr) {
+            // fused cost, lambda * (1 - IoU) + (1 - lambda) * cosine distance
+            assert(cosineDist->rows == (int) detMatched.size() && cosineDist->cols == numPred);
+            float lambda = appearanceParams.iouWeight;
+            float const *distRow = cosineDist->ptr<float>(stageDets[r]);
+            for (int c = 0; c < numCols; ++c) {
+                int j = stagePreds[c];
+                costRow[c] = lambda * (1.0f - iouRow[j]) + (1.0f - lambda) * distRow[j];
+            }
+        } else {
+            for (int c = 0; c < numCols; ++c) {
+                costRow[c] = 1.0f - iouRow[stagePreds[c]];
+            }
         }
     }
-    auto indices = km->compute(costMatrix);
 
-    // find matched pairs and lost detect and predict
-    for (auto [detInd, predInd]: indices) {
+    // Kuhn Munkres or the strategy chosen by the planner, or forced by a replay; without appearance the pairs that
+    // do not overlap all cost 1 and the matrix splits into independent blocks
+    float background = cosineDist != nullptr ? -1.0f : 1.0f;
+    size_t solve = stageStrategies.size();
+    if (solve < forcedStrategies.size() && background >= 0) {
+        planner.computeWith(forcedStrategies[solve], stageCost.data(), numRows, numCols, background, assignment);
+    } else {
+        planner.compute(stageCost.data(), numRows, numCols, background, assignment);
+    }
+    stageStrategies.push_back(planner.getLastStrategy());
+
+    for (auto [row, col]: assignment) {
+        int detInd = stageDets[row], predInd = stagePreds[col];
+        // minIou > 0 also rejects the pairs at the background cost (no overlap), which the strategies pair
+        // arbitrarily: the matches do not depend on the strategy chosen
+        if (costBuffer[(size_t) detInd * numPred + predInd] < minIou) {
+            continue;
+        }
+        // appearance gate, the pair stays unmatched; tracks without embeddings yet are not gated
+        if (cosineDist != nullptr && galleries[predInd]->size() > 0 &&
+            cosineDist->at<float>(detInd, predInd) > appearanceParams.maxCosineDistance) {
+            continue;
+        }
         matchedDetPred.emplace_back(detInd, predInd);
-        lostDets.erase(remove(lostDets.begin(), lostDets.end(), detInd), lostDets.end());
-        lostPreds.erase(remove(lostPreds.begin(), lostPreds.end(), predInd), lostPreds.end());
+        detMatched[detInd] = 1;
+        predMatched[predInd] = 1;
+    }
+}
+
+void ObjectTrackerBase::computeIouMatrix(cv::Mat const &bboxesDet, cv::Mat const &bboxesPred, float *iouMat) {
+    assert(bboxesDet.cols >= 4 && bboxesPred.cols >= 4);
+    int numDet = bboxesDet.rows, numPred = bboxesPred.rows;
+    detBoxes.assign(bboxesDet);
+    predBoxes.assign(bboxesPred);
+
+    if (isFixedCapacity()) {
+        for (int i = 0; i < numDet; ++i) {
+            box_kernels::iouOneToMany(detBoxes, i, predBoxes, 0, numPred, iouMat + (size_t) i * numPred);
+        }
+        return;
     }
 
-    return make_tuple(matchedDetPred, lostDets, lostPreds);
+    std::fill(iouMat, iouMat + (size_t) numDet * numPred, 0.0f);
+    for (int i = 0; i < numDet; ++i) {
+        candidateIds.clear();
+        trackIndex.query(cv::Rect2f(detBoxes.x1[i], detBoxes.y1[i], detBoxes.x2[i] - detBoxes.x1[i],
+                                    detBoxes.y2[i] - detBoxes.y1[i]), candidateIds);
+        for (int trackerId: candidateIds) {
+            int j = trackerIndexById.at(trackerId);
+            iouMat[(size_t) i * numPred + j] = box_kernels::iou(detBoxes, i, predBoxes, j);
+        }
+    }
 }
 
-cv::Mat ObjectTracker::getIouMatrix(cv::Mat const &bboxesA, cv::Mat const &bboxesB) {
+cv::Mat ObjectTrackerBase::getIouMatrix(cv::Mat const &bboxesA, cv::Mat const &bboxesB) {
     assert(bboxesA.cols >= 4 && bboxesB.cols >= 4);
     int numA = bboxesA.rows;
     int numB = bboxesB.rows;
     cv::Mat iouMat(numA, numB, CV_32F, cv::Scalar(0.0));
 
-    cv::Rect re1, re2;
+    box_kernels::BoxSet boxesA, boxesB;
+    boxesA.assign(bboxesA);
+    boxesB.assign(bboxesB);
     for (int i = 0; i < numA; ++i) {
-        for (int j = 0; j < numB; ++j) {
-            re1.x = int(bboxesA.at<float>(i, 0) - bboxesA.at<float>(i, 2) / 2.0);
-            re1.y = int(bboxesA.at<float>(i, 1) - bboxesA.at<float>(i, 3) / 2.0);
-            re1.width = int(bboxesA.at<float>(i, 2));
-            re1.height = int(bboxesA.at<float>(i, 3));
-            re2.x = int(bboxesB.at<float>(j, 0) - bboxesB.at<float>(j, 2) / 2.0);
-            re2.y = int(bboxesB.at<float>(j, 1) - bboxesB.at<float>(j, 3) / 2.0);
-            re2.width = int(bboxesB.at<float>(j, 2));
-            re2.height = int(bboxesB.at<float>(j, 3));
+        box_kernels::iouOneToMany(boxesA, i, boxesB, 0, numB, iouMat.ptr<float>(i));
+    }
+
+    return iouMat;
+}
 
-            iouMat.at<float>(i, j) = float((re1 & re2).area()) / (float((re1 | re2).area()) + FLT_EPSILON);
+cv::Rect ObjectTrackerBase::getBBoxRect(float const *bbox) {
+    return {int(bbox[0] - bbox[2] / 2.0), int(bbox[1] - bbox[3] / 2.0), int(bbox[2]), int(bbox[3])};
+}
+
+void ObjectTrackerBase::reportCreated(int trackerId, float const *bbox, bool revived) {
+    TrackReport &report = reports[trackerId];
+    report.score = bbox[4];
+    report.classId = bbox[5];
+    if (events != nullptr) {
+        TrackEventType type = revived ? TrackEventType::Revived : TrackEventType::Created;
+        events->push_back({type, trackerId, stats.frameCount, bbox[0], bbox[1], bbox[2], bbox[3], bbox[4], bbox[5],
+                           0, 0});
+    }
+}
+
+void ObjectTrackerBase::reportMatched(int trackerId, cv::Vec4f const &bbox, float score, float classId,
+                                      cv::Vec2f const &velocity, bool isOutput) {
+    TrackReport &report = reports[trackerId];
+    report.score = score;
+    report.classId = classId;
+    if (!isOutput) {
+        report.visible = false;
+        return;
+    }
+
+    TrackEventType type = TrackEventType::Updated;
+    bool emit = true;
+    if (!report.confirmed) {
+        type = TrackEventType::Confirmed;
+    } else if (report.visible) {
+        // significant change since the last reported box
+        cv::Vec4f const &last = report.box;
+        float dx = bbox[0] - last[0], dy = bbox[1] - last[1];
+        emit = dx * dx + dy * dy > eventParams.minMove * eventParams.minMove ||
+               std::abs(bbox[2] - last[2]) > eventParams.minSizeChange * last[2] ||
+               std::abs(bbox[3] - last[3]) > eventParams.minSizeChange * last[3];
+    }
+    report.visible = true;
+    report.confirmed = true;
+    if (emit) {
+        report.box = bbox;
+        if (events != nullptr) {
+            events->push_back({type, trackerId, stats.frameCount, bbox[0], bbox[1], bbox[2], bbox[3], score, classId,
+                               velocity[0], velocity[1]});
         }
     }
+}
 
-    return iouMat;
+void ObjectTrackerBase::reportLost(int trackerId, float const *bbox, cv::Vec2f const &velocity) {
+    TrackReport &report = reports[trackerId];
+    if (report.visible && events != nullptr) {
+        events->push_back({TrackEventType::Coasting, trackerId, stats.frameCount, bbox[0], bbox[1], bbox[2], bbox[3],
+                           report.score, report.classId, velocity[0], velocity[1]});
+    }
+    report.visible = false;
+}
+
+void ObjectTrackerBase::reportDeleted(int trackerId, float const *bbox) {
+    TrackReport const *report = reports.find(trackerId);
+    if (events != nullptr) {
+        float score = report != nullptr ? report->score : 0, classId = report != nullptr ? report->classId : 0;
+        events->push_back({TrackEventType::Deleted, trackerId, stats.frameCount, bbox[0], bbox[1], bbox[2], bbox[3],
+                           score, classId, 0, 0});
+    }
+    reports.erase(trackerId);
+}
+
+void ObjectTrackerBase::addDormant(int trackerId, int lastFrame, cv::Vec4f const &bbox, cv::Vec2f const &velocity) {
+    TrackReport const *report = reports.find(trackerId);
+    if (dormant.getParams().maxDormantAge > 0 && report != nullptr && report->confirmed) {
+        dormant.add(trackerId, lastFrame, bbox, velocity, report->classId);
+    }
+}
+
+void ObjectTrackerBase::reviveDormant(cv::Mat const &bboxesDet) {
+    int frame = stats.frameCount;
+    dormant.expire(frame);
+    revivalIds.assign(lostDets.size(), -1);
+    if (dormant.size() > 0 && !lostDets.empty()) {
+        dormantMatches.clear();
+        for (int k = 0; k < (int) lostDets.size(); ++k) {
+            float const *bbox = bboxesDet.ptr<float>(lostDets[k]);
+            dormant.findCandidates(bbox, dormantCandidates);
+            for (int index: dormantCandidates) {
+                float iou = dormant.getIou(index, bbox, frame);
+                if (iou >= dormant.getParams().iouThresh) {
+                    dormantMatches.push_back({iou, k, index});
+                }
+            }
+        }
+        std::sort(dormantMatches.begin(), dormantMatches.end(), [](DormantMatch const &a, DormantMatch const &b) {
+            return a.iou > b.iou || (a.iou == b.iou && (a.lostPos < b.lostPos ||
+                                                        (a.lostPos == b.lostPos && a.dormantIndex < b.dormantIndex)));
+        });
+        dormantUsed.assign(dormant.size(), 0);
+        revivedIds.clear();
+        for (DormantMatch const &match: dormantMatches) {
+            if (revivalIds[match.lostPos] < 0 && !dormantUsed[match.dormantIndex]) {
+                dormantUsed[match.dormantIndex] = 1;
+                revivalIds[match.lostPos] = dormant.get(match.dormantIndex).trackerId;
+                revivedIds.push_back(revivalIds[match.lostPos]);
+            }
+        }
+        dormant.remove(revivedIds);
+        stats.revivedTracks = (int) revivedIds.size();
+    }
+    stats.numDormantTracks = dormant.size();
+}
+
+void ObjectTrackerBase::addBaseMemoryUsage(MemoryUsage &usage) const {
+    using namespace memory_usage;
+    usage.tracks += reports.getMemoryBytes() + trackerIndexById.getMemoryBytes() + trackIndex.getMemoryBytes();
+    usage.solver += getSolverMemoryBytes();
+    usage.outputs += matBytes(predBuffer) + matBytes(postBuffer) + matBytes(bboxesFiltered) +
+                     matBytes(embeddingsFiltered) + capacityBytes(keptIndices) + capacityBytes(filterIndices) +
+                     snapshots.getMemoryBytes();
+    usage.dormant += dormant.getMemoryBytes() + capacityBytes(dormantMatches) + capacityBytes(dormantCandidates) +
+                     capacityBytes(dormantUsed) + capacityBytes(revivalIds) + capacityBytes(revivedIds);
 }
 
-void ObjectTracker::initializeColors() {
+void ObjectTrackerBase::releaseSolverMemory() {
+    using namespace memory_usage;
+    planner.shrink();
+    release(costBuffer);
+    release(stageDets);
+    release(stagePreds);
+    release(stageCost);
+    release(assignment);
+    release(detMatched);
+    release(predMatched);
+    release(matchedDetPred);
+    release(lostDets);
+    release(lostPreds);
+    for (box_kernels::BoxSet *boxes: {&detBoxes, &predBoxes}) {
+        release(boxes->x1);
+        release(boxes->y1);
+        release(boxes->x2);
+        release(boxes->y2);
+    }
+    release(candidateIds);
+    appearanceMatcher.shrink();
+    release(galleries);
+    appearanceDist.release();
+}
+
+void ObjectTrackerBase::applyMemoryPolicy(int side) {
+    if (memoryParams.maxSolverBytes == 0 || isFixedCapacity()) {
+        return;
+    }
+    windowSide = std::max(windowSide, side);
+    peakSide = std::max(peakSide, side);
+    if (++windowUpdates < memoryParams.window) {
+        return;
+    }
+    // the workspace is sized by peakSide; release it once the recent associations need less
+    if (windowSide < peakSide && getSolverMemoryBytes() > memoryParams.maxSolverBytes) {
+        releaseSolverMemory();
+        stats.workspaceReleases++;
+        peakSide = windowSide;
+    }
+    windowUpdates = 0;
+    windowSide = 0;
+}
+
+double ObjectTrackerBase::getElapsedMs(std::chrono::steady_clock::time_point const &start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ObjectTrackerBase::initializeColors() {
     // generate colors
-    cv::RNG rng(ObjectTracker::maxColors);
-    for (size_t i = 0; i < ObjectTracker::maxColors; ++i) {
+    cv::RNG rng(ObjectTrackerBase::maxColors);
+    for (size_t i = 0; i < ObjectTrackerBase::maxColors; ++i) {
         cv::Scalar color(rng.uniform(0, 255), rng.uniform(0, 255), rng.uniform(0, 255));
-        ObjectTracker::colors.emplace_back(color);
+        ObjectTrackerBase::colors.emplace_back(color);
     }
-    ObjectTracker::colorsInitialized = true;
-}
\ No newline at end of file
+}
+
+namespace ObjectTracking {
+    template class ObjectTrackerT<ConstantVelocityModel>;
+
+    template class ObjectTrackerT<ConstantAccelerationModel>;
+
+    template class ObjectTrackerT<XywhVelocityModel>;
+}
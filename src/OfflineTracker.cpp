@@ -0,0 +1,124 @@
+#include "ObjectTracking/OfflineTracker.h"
+#include <algorithm>
+#include <cassert>
+#include <ObjectTracking/FlatIdMap.h>
+#include <ObjectTracking/ObjectTracker.h>
+
+using namespace ObjectTracking;
+
+int TrackTable::size() const {
+    return (int) frame.size();
+}
+
+int TrackTable::getNumTracks() const {
+    return (int) trackOffsets.size() - 1;
+}
+
+void TrackTable::resize(int rows) {
+    auto n = (size_t) rows;
+    trackerId.resize(n);
+    frame.resize(n);
+    for (auto *column: {&xc, &yc, &w, &h, &dx, &dy, &score, &classId}) {
+        column->resize(n);
+    }
+    observed.resize(n);
+}
+
+template<class MotionModel>
+OfflineTrackerT<MotionModel>::OfflineTrackerT(int maxAge, int minHits, float iouThresh)
+        : maxAge(maxAge), minHits(minHits), iouThresh(iouThresh) {}
+
+template<class MotionModel>
+OfflineTrackerT<MotionModel>::~OfflineTrackerT() = default;
+
+template<class MotionModel>
+TrackTable OfflineTrackerT<MotionModel>::process(std::vector<cv::Mat> const &frames) const {
+    // forward pass, the state of every live tracker is recorded after each update
+    ObjectTrackerT<MotionModel> tracker(maxAge, minHits, iouThresh);
+    std::vector<TrackHistory> histories;
+    FlatIdMap<int> historyById;     // tracker id -> index in histories
+    for (int f = 0; f < (int) frames.size(); ++f) {
+        tracker.update(frames[f]);
+        auto const &trackers = tracker.getTrackers();
+        SnapshotBuffer::Handle snapshot = tracker.getSnapshot();    // never skipped, nobody else reads it
+        assert(snapshot && snapshot->tracks.size() == trackers.size());
+        for (int i = 0; i < (int) trackers.size(); ++i) {
+            Tracker const &kbt = *trackers[i];
+            TrackState const &state = snapshot->tracks[i];
+            int const *index = historyById.find(kbt.getFilterId());
+            if (index == nullptr) {
+                historyById[kbt.getFilterId()] = (int) histories.size();
+                histories.emplace_back();
+                histories.back().trackerId = kbt.getFilterId();
+                histories.back().firstFrame = f + 1;
+            }
+            TrackHistory &history = index != nullptr ? histories[*index] : histories.back();
+            bool observed = kbt.getTimeSinceUpdate() == 0;
+            history.x.push_back(kbt.getCurrentState());
+            history.P.push_back(kbt.getErrorCov());
+            history.score.push_back(state.score);
+            history.classId.push_back(state.classId);
+            history.observed.push_back((uint8_t) observed);
+            history.length = observed ? (int) history.x.size() : history.length;
+            history.confirmed |= state.confirmed;
+        }
+    }
+
+    histories.erase(std::remove_if(histories.begin(), histories.end(), [](TrackHistory const &history) {
+        return !history.confirmed;
+    }), histories.end());
+    TrackTable table;
+    for (auto const &history: histories) {
+        table.trackOffsets.push_back(table.trackOffsets.back() + history.length);
+    }
+    table.resize(table.trackOffsets.back());
+
+    // backward pass, every track writes its own rows
+    cv::parallel_for_(cv::Range(0, (int) histories.size()), [&](cv::Range const &range) {
+        for (int t = range.start; t < range.end; ++t) {
+            writeTrack(histories[t], table, table.trackOffsets[t]);
+        }
+    });
+    return table;
+}
+
+template<class MotionModel>
+std::vector<TrackTable> OfflineTrackerT<MotionModel>::process(
+        std::vector<std::vector<cv::Mat>> const &sequences) const {
+    std::vector<TrackTable> tables(sequences.size());
+    // the smoothing inside a sequence runs sequentially here, nested parallel_for_ calls are not parallelized
+    cv::parallel_for_(cv::Range(0, (int) sequences.size()), [&](cv::Range const &range) {
+        for (int i = range.start; i < range.end; ++i) {
+            tables[i] = process(sequences[i]);
+        }
+    });
+    return tables;
+}
+
+template<class MotionModel>
+void OfflineTrackerT<MotionModel>::writeTrack(TrackHistory &history, TrackTable &table, int row) {
+    Tracker::smooth(history.x.data(), history.P.data(), history.length);
+    for (int k = 0; k < history.length; ++k, ++row) {
+        cv::Vec4f bbox = MotionModel::xToBBox(history.x[k]);
+        cv::Vec2f velocity = MotionModel::velocity(history.x[k]);
+        table.trackerId[row] = history.trackerId;
+        table.frame[row] = history.firstFrame + k;
+        table.xc[row] = bbox[0];
+        table.yc[row] = bbox[1];
+        table.w[row] = bbox[2];
+        table.h[row] = bbox[3];
+        table.dx[row] = velocity[0];
+        table.dy[row] = velocity[1];
+        table.score[row] = history.score[k];
+        table.classId[row] = history.classId[k];
+        table.observed[row] = history.observed[k];
+    }
+}
+
+namespace ObjectTracking {
+    template class OfflineTrackerT<ConstantVelocityModel>;
+
+    template class OfflineTrackerT<ConstantAccelerationModel>;
+
+    template class OfflineTrackerT<XywhVelocityModel>;
+}
@@ -0,0 +1,256 @@
+#include "ObjectTracking/SessionLog.h"
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+using namespace ObjectTracking;
+
+namespace {
+    char const SESSION_MAGIC[4] = {'O', 'T', 'R', 'S'};
+    uint32_t const SESSION_VERSION = 1;
+    size_t const MODEL_NAME_BYTES = 32;
+    size_t const WAKE_UP_BYTES = 64u << 10u;    // the writer is woken up early once this much is buffered
+    int32_t const MAX_ESTIMATES = 1024;             // bound of the cost model size read from a log
+    int32_t const MAX_STRATEGIES = 64;              // bound of the assignment solves of a frame read from a log
+
+    template<typename T>
+    bool readValue(std::FILE *file, T &value) {
+        return std::fread(&value, sizeof(T), 1, file) == 1;
+    }
+}
+
+SessionRecorder::SessionRecorder(std::string const &path, size_t maxBufferedBytes)
+        : maxBufferedBytes(maxBufferedBytes) {
+    file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        throw std::runtime_error("can not open session log " + path + ": " + std::strerror(errno));
+    }
+    active.reserve(WAKE_UP_BYTES * 2);
+    writing.reserve(WAKE_UP_BYTES * 2);
+    writer = std::thread(&SessionRecorder::run, this);
+}
+
+SessionRecorder::~SessionRecorder() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_one();
+    writer.join();
+    std::fclose(file);
+}
+
+void SessionRecorder::begin(SessionConfig const &config) {
+    std::lock_guard<std::mutex> lock(mutex);
+    assert(!started);
+    started = true;
+    char modelName[MODEL_NAME_BYTES] = {};
+    std::strncpy(modelName, config.motionModel.c_str(), MODEL_NAME_BYTES - 1);
+    int32_t maxAge = config.maxAge, minHits = config.minHits, firstTrackerId = config.firstTrackerId;
+    int32_t hasPreFilter = config.hasPreFilter, classAware = config.classAware;
+    append(SESSION_MAGIC, sizeof(SESSION_MAGIC));
+    append(&SESSION_VERSION, sizeof(SESSION_VERSION));
+    append(modelName, MODEL_NAME_BYTES);
+    append(&maxAge, sizeof(maxAge));
+    append(&minHits, sizeof(minHits));
+    append(&config.iouThresh, sizeof(config.iouThresh));
+    append(&firstTrackerId, sizeof(firstTrackerId));
+    append(&hasPreFilter, sizeof(hasPreFilter));
+    append(&config.scoreThresh, sizeof(config.scoreThresh));
+    append(&config.nmsIouThresh, sizeof(config.nmsIouThresh));
+    append(&classAware, sizeof(classAware));
+    int32_t galleryCapacity = config.appearance.galleryCapacity, quantized = config.appearance.quantized;
+    append(&galleryCapacity, sizeof(galleryCapacity));
+    append(&config.appearance.iouWeight, sizeof(config.appearance.iouWeight));
+    append(&config.appearance.maxCosineDistance, sizeof(config.appearance.maxCosineDistance));
+    append(&quantized, sizeof(quantized));
+    int32_t maxDormantAge = config.dormant.maxDormantAge, dormantClassAware = config.dormant.classAware;
+    append(&maxDormantAge, sizeof(maxDormantAge));
+    append(&config.dormant.iouThresh, sizeof(config.dormant.iouThresh));
+    append(&dormantClassAware, sizeof(dormantClassAware));
+    append(&config.cascadeScoreThresh, sizeof(config.cascadeScoreThresh));
+    append(&config.cascadeLowIouThresh, sizeof(config.cascadeLowIouThresh));
+    int32_t policy = (int32_t) config.assignment.policy, exploreInterval = config.assignment.exploreInterval;
+    auto numEstimates = (int32_t) config.assignmentCalibration.size();
+    append(&policy, sizeof(policy));
+    append(&exploreInterval, sizeof(exploreInterval));
+    append(&numEstimates, sizeof(numEstimates));
+    append(config.assignmentCalibration.data(), numEstimates * sizeof(double));
+    int32_t maxTracks = config.maxTracks, maxDetections = config.maxDetections;
+    append(&maxTracks, sizeof(maxTracks));
+    append(&maxDetections, sizeof(maxDetections));
+}
+
+void SessionRecorder::record(int frame, int64_t timestamp, cv::Mat const &bboxesDet, cv::Mat const &embeddings,
+                             std::vector<AssignmentStrategy> const &strategies) {
+    assert(bboxesDet.rows == 0 || bboxesDet.type() == CV_32F);
+    assert(embeddings.empty() || embeddings.type() == CV_32F);
+    auto rows = (int32_t) bboxesDet.rows, cols = (int32_t) bboxesDet.cols;
+    auto embeddingRows = (int32_t) embeddings.rows, embeddingCols = (int32_t) embeddings.cols;
+    size_t rowBytes = (size_t) cols * sizeof(float), embeddingRowBytes = (size_t) embeddingCols * sizeof(float);
+    auto numStrategies = (int32_t) strategies.size();
+    size_t bytes = sizeof(int32_t) * (6 + numStrategies) + sizeof(int64_t) + rows * rowBytes +
+                   embeddingRows * embeddingRowBytes;
+
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        assert(started);
+        if (active.size() + writing.size() + bytes > maxBufferedBytes) {
+            numDropped++;
+            return;
+        }
+        auto frame32 = (int32_t) frame;
+        append(&frame32, sizeof(frame32));
+        append(&timestamp, sizeof(timestamp));
+        append(&rows, sizeof(rows));
+        append(&cols, sizeof(cols));
+        for (int i = 0; i < rows; ++i) {
+            append(bboxesDet.ptr<float>(i), rowBytes);
+        }
+        append(&embeddingRows, sizeof(embeddingRows));
+        append(&embeddingCols, sizeof(embeddingCols));
+        for (int i = 0; i < embeddingRows; ++i) {
+            append(embeddings.ptr<float>(i), embeddingRowBytes);
+        }
+        append(&numStrategies, sizeof(numStrategies));
+        for (AssignmentStrategy strategy: strategies) {
+            auto strategy32 = (int32_t) strategy;
+            append(&strategy32, sizeof(strategy32));
+        }
+        wake = active.size() >= WAKE_UP_BYTES;
+    }
+    numRecorded++;
+    if (wake) {
+        wakeUp.notify_one();
+    }
+}
+
+void SessionRecorder::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    wakeUp.notify_one();
+    written.wait(lock, [this] { return active.empty() && writing.empty(); });
+}
+
+uint64_t SessionRecorder::getRecordedCount() const {
+    return numRecorded.load();
+}
+
+uint64_t SessionRecorder::getDroppedCount() const {
+    return numDropped.load();
+}
+
+void SessionRecorder::append(void const *data, size_t bytes) {
+    auto const *begin = static_cast<char const *>(data);
+    active.insert(active.end(), begin, begin + bytes);
+}
+
+void SessionRecorder::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeUp.wait_for(lock, std::chrono::milliseconds(100), [this] {
+            return stopping || active.size() >= WAKE_UP_BYTES;
+        });
+        if (!active.empty()) {
+            // the tracking thread keeps appending to the other buffer while this one is written
+            active.swap(writing);
+            lock.unlock();
+            std::fwrite(writing.data(), 1, writing.size(), file);
+            std::fflush(file);
+            lock.lock();
+            writing.clear();
+        }
+        written.notify_all();
+        if (stopping && active.empty()) {
+            break;
+        }
+    }
+}
+
+SessionReader::SessionReader(std::string const &path) {
+    file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        throw std::runtime_error("can not open session log " + path + ": " + std::strerror(errno));
+    }
+    char magic[4];
+    char modelName[MODEL_NAME_BYTES];
+    uint32_t version;
+    int32_t maxAge, minHits, firstTrackerId, hasPreFilter, classAware, galleryCapacity, quantized, maxDormantAge;
+    int32_t dormantClassAware, policy, exploreInterval, numEstimates, maxTracks, maxDetections;
+    bool valid = std::fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                 std::memcmp(magic, SESSION_MAGIC, sizeof(magic)) == 0 &&
+                 readValue(file, version) && version == SESSION_VERSION &&
+                 std::fread(modelName, 1, MODEL_NAME_BYTES, file) == MODEL_NAME_BYTES &&
+                 readValue(file, maxAge) && readValue(file, minHits) && readValue(file, config.iouThresh) &&
+                 readValue(file, firstTrackerId) && readValue(file, hasPreFilter) &&
+                 readValue(file, config.scoreThresh) && readValue(file, config.nmsIouThresh) &&
+                 readValue(file, classAware) && readValue(file, galleryCapacity) &&
+                 readValue(file, config.appearance.iouWeight) && readValue(file, config.appearance.maxCosineDistance) &&
+                 readValue(file, quantized) && readValue(file, maxDormantAge) &&
+                 readValue(file, config.dormant.iouThresh) && readValue(file, dormantClassAware) &&
+                 readValue(file, config.cascadeScoreThresh) && readValue(file, config.cascadeLowIouThresh) &&
+                 readValue(file, policy) && readValue(file, exploreInterval) && readValue(file, numEstimates) &&
+                 numEstimates >= 0 && numEstimates <= MAX_ESTIMATES;
+    config.assignmentCalibration.resize(valid ? numEstimates : 0);
+    valid = valid && std::fread(config.assignmentCalibration.data(), sizeof(double), numEstimates, file) ==
+                     (size_t) numEstimates &&
+            readValue(file, maxTracks) && readValue(file, maxDetections) && maxTracks >= 0 && maxDetections >= 0;
+    if (!valid) {
+        std::fclose(file);
+        throw std::runtime_error("not a session log: " + path);
+    }
+    modelName[MODEL_NAME_BYTES - 1] = '\0';
+    config.motionModel = modelName;
+    config.maxAge = maxAge;
+    config.minHits = minHits;
+    config.firstTrackerId = firstTrackerId;
+    config.hasPreFilter = hasPreFilter != 0;
+    config.classAware = classAware != 0;
+    config.appearance.galleryCapacity = galleryCapacity;
+    config.appearance.quantized = quantized != 0;
+    config.dormant.maxDormantAge = maxDormantAge;
+    config.dormant.classAware = dormantClassAware != 0;
+    config.assignment.policy = (AssignmentPolicy) policy;
+    config.assignment.exploreInterval = exploreInterval;
+    config.maxTracks = maxTracks;
+    config.maxDetections = maxDetections;
+}
+
+SessionReader::~SessionReader() {
+    std::fclose(file);
+}
+
+SessionConfig const &SessionReader::getConfig() const {
+    return config;
+}
+
+bool SessionReader::next(Frame &frame) {
+    int32_t frame32, rows, cols;
+    if (!readValue(file, frame32) || !readValue(file, frame.timestamp) || !readValue(file, rows) ||
+        !readValue(file, cols) || rows < 0 || cols < 0) {
+        return false;
+    }
+    frame.frame = frame32;
+    int32_t numStrategies;
+    if (!readMatrix(rows, cols, frame.bboxesDet) || !readValue(file, rows) || !readValue(file, cols) || rows < 0 ||
+        cols < 0 || !readMatrix(rows, cols, frame.embeddings) || !readValue(file, numStrategies) ||
+        numStrategies < 0 || numStrategies > MAX_STRATEGIES) {
+        return false;
+    }
+    frame.strategies.clear();
+    for (int k = 0; k < numStrategies; ++k) {
+        int32_t strategy;
+        if (!readValue(file, strategy) || strategy < 0 || strategy >= AssignmentPlanner::numStrategies) {
+            return false;
+        }
+        frame.strategies.push_back((AssignmentStrategy) strategy);
+    }
+    return true;
+}
+
+bool SessionReader::readMatrix(int rows, int cols, cv::Mat &matrix) {
+    matrix.create(rows, cols, CV_32F);
+    size_t count = (size_t) rows * cols;
+    return count == 0 || std::fread(matrix.ptr<float>(0), sizeof(float), count, file) == count;
+}
@@ -0,0 +1,209 @@
+#include "ObjectTracking/SharedMemoryTransport.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace ObjectTracking;
+
+namespace {
+    size_t getSlotBytes(int maxTracks) {
+        return sizeof(ShmSlotHeader) + (size_t) maxTracks * sizeof(ShmTrack);
+    }
+
+    std::runtime_error getSystemError(std::string const &what, std::string const &name) {
+        return std::runtime_error(what + " " + name + ": " + std::strerror(errno));
+    }
+}
+
+ShmTrackPublisher::ShmTrackPublisher(std::string name, int numSlots, int maxTracks) : name(std::move(name)) {
+    assert(numSlots >= 2 && maxTracks > 0);
+    size_t slotBytes = getSlotBytes(maxTracks);
+    mappingBytes = sizeof(ShmHeader) + (size_t) numSlots * slotBytes;
+
+    int fd = shm_open(this->name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw getSystemError("shm_open", this->name);
+    }
+    if (ftruncate(fd, (off_t) mappingBytes) != 0) {
+        close(fd);
+        shm_unlink(this->name.c_str());
+        throw getSystemError("ftruncate", this->name);
+    }
+    mapping = mmap(nullptr, mappingBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        shm_unlink(this->name.c_str());
+        throw getSystemError("mmap", this->name);
+    }
+
+    // the segment is zero-filled: all slot sequences are 0, nothing published
+    header = static_cast<ShmHeader *>(mapping);
+    header->numSlots = (uint32_t) numSlots;
+    header->maxTracks = (uint32_t) maxTracks;
+    header->slotBytes = slotBytes;
+    header->version = SHM_VERSION;
+    header->published.store(0, std::memory_order_relaxed);
+    // the magic number is written last, readers reject the segment until it is set
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = SHM_MAGIC;
+}
+
+ShmTrackPublisher::~ShmTrackPublisher() {
+    if (mapping != nullptr) {
+        munmap(mapping, mappingBytes);
+        shm_unlink(name.c_str());
+    }
+}
+
+void ShmTrackPublisher::publish(cv::Mat const &bboxesPost, int frame) {
+    assert(bboxesPost.rows == 0 || (bboxesPost.cols == 9 && bboxesPost.type() == CV_32F));
+    ShmSlotHeader *slot = beginFrame(frame);
+    ShmTrack *tracks = getTracks(slot);
+    auto numTracks = (uint32_t) std::min(bboxesPost.rows, (int) header->maxTracks);
+    for (uint32_t i = 0; i < numTracks; ++i) {
+        float const *row = bboxesPost.ptr<float>((int) i);
+        tracks[i] = {(int32_t) row[8], row[0], row[1], row[2], row[3], row[4], row[5], row[6], row[7],
+                     ShmTrack::CONFIRMED};
+    }
+    endFrame(slot, numTracks, (uint32_t) bboxesPost.rows - numTracks);
+}
+
+void ShmTrackPublisher::publish(TrackSnapshot const &snapshot) {
+    ShmSlotHeader *slot = beginFrame(snapshot.frame);
+    ShmTrack *tracks = getTracks(slot);
+    auto numTracks = (uint32_t) std::min(snapshot.tracks.size(), (size_t) header->maxTracks);
+    for (uint32_t i = 0; i < numTracks; ++i) {
+        TrackState const &state = snapshot.tracks[i];
+        tracks[i] = {state.trackerId, state.xc, state.yc, state.w, state.h, state.score, state.classId, state.dx,
+                     state.dy, state.confirmed ? ShmTrack::CONFIRMED : 0u};
+    }
+    endFrame(slot, numTracks, (uint32_t) snapshot.tracks.size() - numTracks);
+}
+
+uint64_t ShmTrackPublisher::getPublishedCount() const {
+    return next;
+}
+
+ShmSlotHeader *ShmTrackPublisher::beginFrame(int frame) {
+    auto *slot = reinterpret_cast<ShmSlotHeader *>(static_cast<char *>(mapping) + sizeof(ShmHeader) +
+                                                   (next % header->numSlots) * header->slotBytes);
+    // odd sequence: readers of the previous frame in this slot see it is being overwritten
+    slot->sequence.store(2 * next + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->frame = frame;
+    slot->timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    return slot;
+}
+
+void ShmTrackPublisher::endFrame(ShmSlotHeader *slot, uint32_t numTracks, uint32_t numDropped) {
+    slot->numTracks = numTracks;
+    slot->numDropped = numDropped;
+    slot->sequence.store(2 * (next + 1), std::memory_order_release);
+    next++;
+    header->published.store(next, std::memory_order_release);
+}
+
+ShmTrack *ShmTrackPublisher::getTracks(ShmSlotHeader *slot) const {
+    return reinterpret_cast<ShmTrack *>(reinterpret_cast<char *>(slot) + sizeof(ShmSlotHeader));
+}
+
+ShmTrackReader::ShmTrackReader(std::string const &name) {
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        throw getSystemError("shm_open", name);
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(ShmHeader)) {
+        close(fd);
+        throw std::runtime_error("invalid shared memory segment " + name);
+    }
+    mappingBytes = (size_t) st.st_size;
+    void *ptr = mmap(nullptr, mappingBytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        throw getSystemError("mmap", name);
+    }
+    mapping = ptr;
+    header = static_cast<ShmHeader const *>(mapping);
+
+    bool valid = header->magic == SHM_MAGIC;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    valid = valid && header->version == SHM_VERSION && header->numSlots >= 2 &&
+            header->slotBytes == getSlotBytes((int) header->maxTracks) &&
+            sizeof(ShmHeader) + header->numSlots * header->slotBytes <= mappingBytes;
+    if (!valid) {
+        munmap(ptr, mappingBytes);
+        throw std::runtime_error("incompatible shared memory segment " + name);
+    }
+}
+
+ShmTrackReader::~ShmTrackReader() {
+    munmap(const_cast<void *>(mapping), mappingBytes);
+}
+
+uint64_t ShmTrackReader::getPublishedCount() const {
+    return header->published.load(std::memory_order_acquire);
+}
+
+bool ShmTrackReader::view(uint64_t sequence, FrameView &frameView) const {
+    ShmSlotHeader const *slot = getSlot(sequence);
+    uint64_t expected = 2 * (sequence + 1);
+    if (slot->sequence.load(std::memory_order_acquire) != expected) {
+        return false;
+    }
+    frameView.sequence = sequence;
+    frameView.frame = slot->frame;
+    frameView.timestamp = slot->timestamp;
+    frameView.numTracks = std::min(slot->numTracks, header->maxTracks);
+    frameView.numDropped = slot->numDropped;
+    frameView.tracks = reinterpret_cast<ShmTrack const *>(reinterpret_cast<char const *>(slot) +
+                                                          sizeof(ShmSlotHeader));
+    frameView.slot = slot;
+    return isValid(frameView);
+}
+
+bool ShmTrackReader::viewLatest(FrameView &frameView) const {
+    uint64_t published = getPublishedCount();
+    return published > 0 && view(published - 1, frameView);
+}
+
+bool ShmTrackReader::isValid(FrameView const &frameView) const {
+    if (frameView.slot == nullptr) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return frameView.slot->sequence.load(std::memory_order_relaxed) == 2 * (frameView.sequence + 1);
+}
+
+bool ShmTrackReader::copy(uint64_t sequence, FrameView &frameView, std::vector<ShmTrack> &tracks) const {
+    if (!view(sequence, frameView)) {
+        return false;
+    }
+    tracks.assign(frameView.tracks, frameView.tracks + frameView.numTracks);
+    if (!isValid(frameView)) {
+        tracks.clear();
+        return false;
+    }
+    return true;
+}
+
+int ShmTrackReader::getNumSlots() const {
+    return (int) header->numSlots;
+}
+
+int ShmTrackReader::getMaxTracks() const {
+    return (int) header->maxTracks;
+}
+
+ShmSlotHeader const *ShmTrackReader::getSlot(uint64_t sequence) const {
+    return reinterpret_cast<ShmSlotHeader const *>(static_cast<char const *>(mapping) + sizeof(ShmHeader) +
+                                                   (sequence % header->numSlots) * header->slotBytes);
+}
@@ -0,0 +1,166 @@
+#include "ObjectTracking/SpatialGrid.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <ObjectTracking/MemoryUsage.h>
+
+using namespace ObjectTracking;
+
+int64_t const SpatialGrid::maxCellsPerItem = 256;
+
+SpatialGrid::SpatialGrid(float cellSize) : cellSize(cellSize) {
+    assert(cellSize > 0);
+}
+
+SpatialGrid::~SpatialGrid() = default;
+
+void SpatialGrid::set(int key, cv::Rect2f const &rect) {
+    CellRange range = getCellRange(rect);
+    auto it = items.find(key);
+    if (it == items.end()) {
+        items.emplace(key, Item{rect, range, queryStamp});
+        addToCells(key, range);
+        return;
+    }
+
+    it->second.rect = rect;
+    if (!(it->second.cells == range)) {
+        removeFromCells(key, it->second.cells);
+        addToCells(key, range);
+        it->second.cells = range;
+    }
+}
+
+void SpatialGrid::remove(int key) {
+    auto it = items.find(key);
+    if (it == items.end()) {
+        return;
+    }
+    removeFromCells(key, it->second.cells);
+    items.erase(it);
+}
+
+void SpatialGrid::clear() {
+    cells.clear();
+    oversized.clear();
+    items.clear();
+}
+
+void SpatialGrid::shrink() {
+    for (auto it = cells.begin(); it != cells.end();) {
+        if (it->second.empty()) {
+            it = cells.erase(it);
+        } else {
+            it->second.shrink_to_fit();
+            ++it;
+        }
+    }
+    cells.rehash(0);
+    items.rehash(0);
+    oversized.shrink_to_fit();
+}
+
+void SpatialGrid::query(cv::Rect2f const &region, std::vector<int> &keys) {
+    queryStamp++;
+    auto visit = [&](int key) {
+        Item &item = items.at(key);
+        if (item.queryStamp != queryStamp) {
+            item.queryStamp = queryStamp;
+            if (overlaps(item.rect, region)) {
+                keys.push_back(key);
+            }
+        }
+    };
+
+    CellRange range = getCellRange(region);
+    if (range.oversized) {
+        // cheaper to check every item than to walk the cells
+        for (auto const &item: items) {
+            visit(item.first);
+        }
+        return;
+    }
+    for (int y = range.y0; y <= range.y1; ++y) {
+        for (int x = range.x0; x <= range.x1; ++x) {
+            auto cell = cells.find(getCellKey(x, y));
+            if (cell == cells.end()) {
+                continue;
+            }
+            for (int key: cell->second) {
+                visit(key);
+            }
+        }
+    }
+    for (int key: oversized) {
+        visit(key);
+    }
+}
+
+size_t SpatialGrid::size() const {
+    return items.size();
+}
+
+float SpatialGrid::getCellSize() const {
+    return cellSize;
+}
+
+size_t SpatialGrid::getMemoryBytes() const {
+    // a hash node holds the value and the pointer to the next node
+    size_t bytes = cells.bucket_count() * sizeof(void *) + items.bucket_count() * sizeof(void *) +
+                   cells.size() * (sizeof(std::pair<int64_t const, std::vector<int>>) + sizeof(void *)) +
+                   items.size() * (sizeof(std::pair<int const, Item>) + sizeof(void *)) +
+                   memory_usage::capacityBytes(oversized);
+    for (auto const &cell: cells) {
+        bytes += memory_usage::capacityBytes(cell.second);
+    }
+    return bytes;
+}
+
+SpatialGrid::CellRange SpatialGrid::getCellRange(cv::Rect2f const &rect) const {
+    double x0 = std::floor(rect.x / cellSize), y0 = std::floor(rect.y / cellSize);
+    double x1 = std::floor((rect.x + std::max(rect.width, 0.0f)) / cellSize);
+    double y1 = std::floor((rect.y + std::max(rect.height, 0.0f)) / cellSize);
+    if (!((x1 - x0 + 1) * (y1 - y0 + 1) <= double(maxCellsPerItem))) {
+        return {0, 0, -1, -1, true};
+    }
+    return {(int) x0, (int) y0, (int) x1, (int) y1, false};
+}
+
+void SpatialGrid::addToCells(int key, CellRange const &range) {
+    if (range.oversized) {
+        oversized.push_back(key);
+        return;
+    }
+    for (int y = range.y0; y <= range.y1; ++y) {
+        for (int x = range.x0; x <= range.x1; ++x) {
+            cells[getCellKey(x, y)].push_back(key);
+        }
+    }
+}
+
+void SpatialGrid::removeFromCells(int key, CellRange const &range) {
+    if (range.oversized) {
+        oversized.erase(std::find(oversized.begin(), oversized.end(), key));
+        return;
+    }
+    for (int y = range.y0; y <= range.y1; ++y) {
+        for (int x = range.x0; x <= range.x1; ++x) {
+            auto &cell = cells[getCellKey(x, y)];
+            auto it = std::find(cell.begin(), cell.end(), key);
+            if (it != cell.end()) {
+                *it = cell.back();
+                cell.pop_back();
+            }
+        }
+    }
+}
+
+int64_t SpatialGrid::getCellKey(int x, int y) {
+    // shifted as unsigned, a left shift of a negative value is undefined
+    return int64_t((uint64_t(uint32_t(x)) << 32) | uint64_t(uint32_t(y)));
+}
+
+bool SpatialGrid::overlaps(cv::Rect2f const &a, cv::Rect2f const &b) {
+    return std::min(a.x + a.width, b.x + b.width) > std::max(a.x, b.x) &&
+           std::min(a.y + a.height, b.y + b.height) > std::max(a.y, b.y);
+}
@@ -0,0 +1,147 @@
+#include "ObjectTracking/TiledObjectTracker.h"
+#include <algorithm>
+#include <set>
+
+using namespace ObjectTracking;
+
+TiledObjectTracker::TiledObjectTracker(cv::Size const &frameSize, cv::Size const &tileGrid, float overlap,
+                                       int maxAge, int minHits, float iouThresh, float handoffIouThresh)
+        : frameSize(frameSize), tileGrid(tileGrid), overlap(overlap), handoffIouThresh(handoffIouThresh),
+          maxUnreportedFrames(maxAge + minHits) {
+    assert(frameSize.width > 0 && frameSize.height > 0 && tileGrid.width > 0 && tileGrid.height > 0);
+    assert(overlap >= 0);
+    tiles.resize(tileGrid.area());
+    for (auto &tile: tiles) {
+        tile.tracker = make_shared<ObjectTracker>(maxAge, minHits, iouThresh);
+    }
+}
+
+TiledObjectTracker::~TiledObjectTracker() = default;
+
+cv::Mat TiledObjectTracker::update(cv::Mat const &bboxesDet) {
+    assert(bboxesDet.rows >= 0 && bboxesDet.cols == 6); // detections, [xc, yc, w, h, score, class_id]
+    frameCount++;
+
+    // distribute detections to every tile whose extended region contains their center,
+    // border tiles extend to infinity so that no detection is lost
+    for (auto &tile: tiles) {
+        tile.bboxesDet = cv::Mat(0, 6, CV_32F);
+    }
+    float tileW = (float) frameSize.width / (float) tileGrid.width;
+    float tileH = (float) frameSize.height / (float) tileGrid.height;
+    for (int i = 0; i < bboxesDet.rows; ++i) {
+        float xc = bboxesDet.at<float>(i, 0);
+        float yc = bboxesDet.at<float>(i, 1);
+        int c0 = std::clamp((int) std::floor((xc - overlap) / tileW), 0, tileGrid.width - 1);
+        int c1 = std::clamp((int) std::floor((xc + overlap) / tileW), 0, tileGrid.width - 1);
+        int r0 = std::clamp((int) std::floor((yc - overlap) / tileH), 0, tileGrid.height - 1);
+        int r1 = std::clamp((int) std::floor((yc + overlap) / tileH), 0, tileGrid.height - 1);
+        for (int r = r0; r <= r1; ++r) {
+            for (int c = c0; c <= c1; ++c) {
+                tiles[r * tileGrid.width + c].bboxesDet.push_back(bboxesDet.row(i));
+            }
+        }
+    }
+
+    // tiles are independent SORT instances
+    cv::parallel_for_(cv::Range(0, (int) tiles.size()), [this](cv::Range const &range) {
+        for (int t = range.start; t < range.end; ++t) {
+            tiles[t].bboxesPost = tiles[t].tracker->update(tiles[t].bboxesDet);
+        }
+    });
+
+    // merge the tracks owned by each tile, in tile order to keep the result deterministic
+    cv::Mat bboxesPost(0, 9, CV_32F, cv::Scalar(0));
+    vector<pair<int, int>> owned;
+    for (int t = 0; t < (int) tiles.size(); ++t) {
+        cv::Mat const &tilePost = tiles[t].bboxesPost;
+        for (int i = 0; i < tilePost.rows; ++i) {
+            if (getOwnerTile(tilePost.at<float>(i, 0), tilePost.at<float>(i, 1)) == t) {
+                owned.emplace_back(t, i);
+                bboxesPost.push_back(tilePost.row(i));
+            }
+        }
+    }
+    assignGlobalIds(owned, bboxesPost);
+
+    // forget local tracks that are not alive anymore
+    for (auto it = localToGlobal.begin(); it != localToGlobal.end();) {
+        if (frameCount - it->second.lastFrame > maxUnreportedFrames) {
+            it = localToGlobal.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    previousBboxesPost = bboxesPost.clone();
+    return bboxesPost;
+}
+
+int TiledObjectTracker::getTileCount() const {
+    return (int) tiles.size();
+}
+
+int TiledObjectTracker::getOwnerTile(float x, float y) const {
+    int c = std::clamp((int) std::floor(x * (float) tileGrid.width / (float) frameSize.width), 0, tileGrid.width - 1);
+    int r = std::clamp((int) std::floor(y * (float) tileGrid.height / (float) frameSize.height), 0, tileGrid.height - 1);
+    return r * tileGrid.width + c;
+}
+
+void TiledObjectTracker::assignGlobalIds(vector<pair<int, int>> const &owned, cv::Mat &bboxesPost) {
+    vector<int> globalIds(owned.size(), -1);
+    std::set<int> claimed;
+
+    // tracks already known to their owner tile keep their global id
+    for (int k = 0; k < (int) owned.size(); ++k) {
+        auto [t, i] = owned[k];
+        auto it = localToGlobal.find({t, int(tiles[t].bboxesPost.at<float>(i, 8))});
+        if (it != localToGlobal.end() && claimed.insert(it->second.globalId).second) {
+            globalIds[k] = it->second.globalId;
+            it->second.lastFrame = frameCount;
+        }
+    }
+
+    // tracks new to their owner tile take over the best overlapping unclaimed track of the previous frame
+    for (int k = 0; k < (int) owned.size(); ++k) {
+        if (globalIds[k] >= 0) {
+            continue;
+        }
+        int globalId = -1;
+        float bestIou = handoffIouThresh;
+        for (int p = 0; p < previousBboxesPost.rows; ++p) {
+            int previousId = int(previousBboxesPost.at<float>(p, 8));
+            if (claimed.count(previousId) > 0) {
+                continue;
+            }
+            float iou = getIou(bboxesPost.ptr<float>(k), previousBboxesPost.ptr<float>(p));
+            if (iou >= bestIou) {
+                if (iou > bestIou || globalId < 0) {
+                    globalId = previousId;
+                }
+                bestIou = iou;
+            }
+        }
+        if (globalId < 0) {
+            globalId = nextGlobalId++;
+        }
+        claimed.insert(globalId);
+        globalIds[k] = globalId;
+
+        auto [t, i] = owned[k];
+        localToGlobal[{t, int(tiles[t].bboxesPost.at<float>(i, 8))}] = {globalId, frameCount};
+    }
+
+    for (int k = 0; k < (int) owned.size(); ++k) {
+        bboxesPost.at<float>(k, 8) = (float) globalIds[k];
+    }
+}
+
+float TiledObjectTracker::getIou(float const *a, float const *b) {
+    float w = std::min(a[0] + a[2] / 2, b[0] + b[2] / 2) - std::max(a[0] - a[2] / 2, b[0] - b[2] / 2);
+    float h = std::min(a[1] + a[3] / 2, b[1] + b[3] / 2) - std::max(a[1] - a[3] / 2, b[1] - b[3] / 2);
+    if (w <= 0 || h <= 0) {
+        return 0;
+    }
+    float intersection = w * h;
+    return intersection / (a[2] * a[3] + b[2] * b[3] - intersection + FLT_EPSILON);
+}
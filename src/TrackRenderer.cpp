@@ -0,0 +1,206 @@
+#include "ObjectTracking/TrackRenderer.h"
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <opencv2/imgproc.hpp>
+#include <ObjectTracking/ObjectTracker.h>
+
+using namespace ObjectTracking;
+
+namespace {
+    int const LABEL_FONT = cv::FONT_HERSHEY_PLAIN;
+    double const LABEL_SCALE = 1.5;
+    int const LABEL_THICKNESS = 2;
+    int const LABEL_PAD = 2;    // the strokes of thick text exceed the text size
+}
+
+TrackRenderer::TrackRenderer(RenderParams const &params, int numBuffers, Sink sink)
+        : params(params), sink(std::move(sink)), buffers(numBuffers) {
+    assert(numBuffers >= 2 && params.decimation >= 1 && params.maxLabels > 0);
+    freeBuffers.reserve(numBuffers);
+    pending.reserve(numBuffers);
+    for (int i = numBuffers - 1; i >= 0; --i) {
+        freeBuffers.push_back(i);
+    }
+    labels.reserve(params.maxLabels);
+    worker = std::thread(&TrackRenderer::run, this);
+}
+
+TrackRenderer::~TrackRenderer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    jobAvailable.notify_one();
+    worker.join();
+}
+
+bool TrackRenderer::submit(cv::Mat const &frame, TrackSnapshot const &snapshot) {
+    int index;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stats.submitted++ % params.decimation != 0) {
+            stats.skipped++;
+            return false;
+        }
+        if (freeBuffers.empty()) {
+            stats.dropped++;
+            return false;
+        }
+        index = freeBuffers.back();
+        freeBuffers.pop_back();
+    }
+
+    // the buffer belongs to this thread until it is queued
+    Buffer &buffer = buffers[index];
+    frame.copyTo(buffer.image);
+    buffer.frame = snapshot.frame;
+    buffer.tracks.clear();
+    for (TrackState const &track: snapshot.tracks) {
+        if (track.confirmed) {
+            buffer.tracks.push_back(track);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(index);
+    }
+    jobAvailable.notify_one();
+    return true;
+}
+
+bool TrackRenderer::takeLatest(cv::Mat &image, int *frame) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (latest < 0) {
+        return false;
+    }
+    std::swap(image, buffers[latest].image);
+    if (frame != nullptr) {
+        *frame = buffers[latest].frame;
+    }
+    freeBuffers.push_back(latest);
+    latest = -1;
+    return true;
+}
+
+void TrackRenderer::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return pending.empty() && !rendering; });
+}
+
+RenderStats TrackRenderer::getStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+RenderParams const &TrackRenderer::getParams() const {
+    return params;
+}
+
+void TrackRenderer::run() {
+    for (;;) {
+        int index;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobAvailable.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (pending.empty()) {
+                return;     // stopping, the submitted frames are all rendered
+            }
+            index = pending.front();
+            pending.erase(pending.begin());
+            rendering = true;
+        }
+
+        Buffer &buffer = buffers[index];
+        auto start = std::chrono::steady_clock::now();
+        draw(buffer.image, buffer.tracks);
+        double renderTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (sink) {
+            sink(buffer.image, buffer.frame);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (latest >= 0) {
+                freeBuffers.push_back(latest);
+            }
+            latest = index;
+            rendering = false;
+            stats.rendered++;
+            stats.renderTime = renderTime;
+        }
+        idle.notify_all();
+    }
+}
+
+void TrackRenderer::draw(cv::Mat &image, std::vector<TrackState> const &tracks) {
+    bool cachedLabels = image.type() == CV_8UC3;
+    char text[32];
+    for (TrackState const &track: tracks) {
+        cv::Scalar const &color = ObjectTrackerBase::getColor(track.trackerId);
+        cv::Point topLeft(int(track.xc - track.w / 2), int(track.yc - track.h / 2));
+        cv::rectangle(image, cv::Rect(topLeft.x, topLeft.y, int(track.w), int(track.h)), color, 2);
+        if (params.boxesOnly) {
+            continue;
+        }
+
+        cv::Point origin(topLeft.x, topLeft.y - 4);
+        if (cachedLabels) {
+            Label const &label = getLabel(track.trackerId);
+            blendLabel(image, label, origin);
+            if (params.withScore) {
+                // the score changes every frame, it is drawn right of the cached id
+                std::snprintf(text, sizeof(text), ": %.2f", track.score);
+                cv::putText(image, text, cv::Point(origin.x + label.image.cols - 2 * LABEL_PAD, origin.y), LABEL_FONT,
+                            LABEL_SCALE, color, LABEL_THICKNESS);
+            }
+        } else {
+            if (params.withScore) {
+                std::snprintf(text, sizeof(text), "%d: %.2f", track.trackerId, track.score);
+            } else {
+                std::snprintf(text, sizeof(text), "%d", track.trackerId);
+            }
+            cv::putText(image, text, origin, LABEL_FONT, LABEL_SCALE, color, LABEL_THICKNESS);
+        }
+        cv::arrowedLine(image, cv::Point(int(track.xc), int(track.yc)),
+                        cv::Point(int(track.xc + 5 * track.dx), int(track.yc + 5 * track.dy)), color, 4);
+    }
+}
+
+TrackRenderer::Label const &TrackRenderer::getLabel(int trackerId) {
+    if (Label const *label = labels.find(trackerId)) {
+        return *label;
+    }
+    if ((int) labels.size() >= params.maxLabels) {
+        labels.clear();
+    }
+
+    std::string text = std::to_string(trackerId);
+    int baseline = 0;
+    cv::Size size = cv::getTextSize(text, LABEL_FONT, LABEL_SCALE, LABEL_THICKNESS, &baseline);
+    Label &label = labels[trackerId];
+    int rows = size.height + baseline + 2 * LABEL_PAD, cols = size.width + 2 * LABEL_PAD;
+    cv::Point textOrigin(LABEL_PAD, size.height + LABEL_PAD);
+    label.image.create(rows, cols, CV_8UC3);
+    label.image.setTo(cv::Scalar::all(0));
+    label.mask.create(rows, cols, CV_8U);
+    label.mask.setTo(cv::Scalar::all(0));
+    cv::putText(label.image, text, textOrigin, LABEL_FONT, LABEL_SCALE, ObjectTrackerBase::getColor(trackerId),
+                LABEL_THICKNESS);
+    cv::putText(label.mask, text, textOrigin, LABEL_FONT, LABEL_SCALE, cv::Scalar::all(255), LABEL_THICKNESS);
+    label.offset = -textOrigin;
+    return label;
+}
+
+void TrackRenderer::blendLabel(cv::Mat &image, Label const &label, cv::Point origin) {
+    cv::Point topLeft = origin + label.offset;
+    cv::Rect target = cv::Rect(topLeft.x, topLeft.y, label.image.cols, label.image.rows) &
+                      cv::Rect(0, 0, image.cols, image.rows);
+    if (target.width <= 0 || target.height <= 0) {
+        return;
+    }
+    cv::Rect source(target.x - topLeft.x, target.y - topLeft.y, target.width, target.height);
+    cv::Mat roi = image(target);
+    label.image(source).copyTo(roi, label.mask(source));
+}
@@ -0,0 +1,149 @@
+#include "ObjectTracking/TrackSnapshot.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace ObjectTracking;
+
+void TrackSnapshot::sample(int64_t time, float maxExtrapolation, std::vector<TrackSample> &samples) const {
+    samples.clear();
+    if (time < timestamp) {
+        // between the two last updates, or before them (clamped to the previous box)
+        float alpha = 0;
+        if (timestamp > prevTimestamp) {
+            alpha = std::max(0.0f, float(double(time - prevTimestamp) / double(timestamp - prevTimestamp)));
+        }
+        for (TrackState const &track: tracks) {
+            if (track.confirmed) {
+                samples.push_back({track.trackerId, track.prevXc + alpha * (track.xc - track.prevXc),
+                                   track.prevYc + alpha * (track.yc - track.prevYc),
+                                   track.prevW + alpha * (track.w - track.prevW),
+                                   track.prevH + alpha * (track.h - track.prevH), track.score, track.classId});
+            }
+        }
+        return;
+    }
+
+    float k = framePeriod > 0 ? std::min(maxExtrapolation, float(double(time - timestamp) / framePeriod)) : 0;
+    float k2 = 0.5f * k * k;
+    for (TrackState const &track: tracks) {
+        if (!track.confirmed) {
+            continue;
+        }
+        float xc = track.xc + track.dz[0] * k + track.ddz[0] * k2;
+        float yc = track.yc + track.dz[1] * k + track.ddz[1] * k2;
+        float w = track.w, h = track.h;
+        if (areaRatio) {
+            float area = w * h + track.dz[2] * k + track.ddz[2] * k2;
+            float ratio = w / h + track.dz[3] * k + track.ddz[3] * k2;
+            // a vanishing box keeps its current size
+            if (area > 0 && ratio > 0) {
+                w = std::sqrt(area * ratio);
+                h = area / w;
+            }
+        } else {
+            float sw = w + track.dz[2] * k + track.ddz[2] * k2, sh = h + track.dz[3] * k + track.ddz[3] * k2;
+            if (sw > 0 && sh > 0) {
+                w = sw;
+                h = sh;
+            }
+        }
+        samples.push_back({track.trackerId, xc, yc, w, h, track.score, track.classId});
+    }
+}
+
+SnapshotBuffer::Handle::Handle(Slot *slot) : slot(slot) {}
+
+SnapshotBuffer::Handle::Handle(Handle &&other) noexcept: slot(other.slot) {
+    other.slot = nullptr;
+}
+
+SnapshotBuffer::Handle &SnapshotBuffer::Handle::operator=(Handle &&other) noexcept {
+    if (this != &other) {
+        release();
+        slot = other.slot;
+        other.slot = nullptr;
+    }
+    return *this;
+}
+
+SnapshotBuffer::Handle::~Handle() {
+    release();
+}
+
+SnapshotBuffer::Handle::operator bool() const {
+    return slot != nullptr;
+}
+
+TrackSnapshot const &SnapshotBuffer::Handle::operator*() const {
+    assert(slot != nullptr);
+    return slot->snapshot;
+}
+
+TrackSnapshot const *SnapshotBuffer::Handle::operator->() const {
+    assert(slot != nullptr);
+    return &slot->snapshot;
+}
+
+void SnapshotBuffer::Handle::release() {
+    if (slot != nullptr) {
+        slot->readers.fetch_sub(1, std::memory_order_release);
+        slot = nullptr;
+    }
+}
+
+SnapshotBuffer::SnapshotBuffer(int numSlots) : numSlots(numSlots), slots(new Slot[numSlots]) {
+    assert(numSlots >= 2);
+}
+
+SnapshotBuffer::~SnapshotBuffer() = default;
+
+SnapshotBuffer::Handle SnapshotBuffer::acquire() const {
+    while (true) {
+        int index = current.load(std::memory_order_seq_cst);
+        if (index < 0) {
+            return Handle();
+        }
+        Slot &slot = slots[index];
+        slot.readers.fetch_add(1, std::memory_order_seq_cst);
+        // the slot may have been recycled between the load and the pin: only keep it if it is still current,
+        // the writer never touches the current slot nor a pinned one
+        if (current.load(std::memory_order_seq_cst) == index) {
+            return Handle(&slot);
+        }
+        slot.readers.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+TrackSnapshot *SnapshotBuffer::beginWrite() {
+    int published = current.load(std::memory_order_relaxed);
+    for (int k = 1; k <= numSlots; ++k) {
+        int index = (published + k + numSlots) % numSlots;
+        if (index != published && slots[index].readers.load(std::memory_order_seq_cst) == 0) {
+            writing = index;
+            return &slots[index].snapshot;
+        }
+    }
+    writing = -1;
+    return nullptr;
+}
+
+void SnapshotBuffer::publish() {
+    assert(writing >= 0);
+    current.store(writing, std::memory_order_seq_cst);
+    writing = -1;
+}
+
+void SnapshotBuffer::reserve(size_t maxTracks) {
+    for (int i = 0; i < numSlots; ++i) {
+        slots[i].snapshot.tracks.reserve(maxTracks);
+    }
+}
+
+size_t SnapshotBuffer::getMemoryBytes() const {
+    size_t bytes = 0;
+    for (int i = 0; i < numSlots; ++i) {
+        bytes += slots[i].snapshot.tracks.capacity() * sizeof(TrackState);
+    }
+    return bytes;
+}
@@ -0,0 +1,59 @@
+#include "ObjectTracking/Trajectory.h"
+#include <algorithm>
+#include <cassert>
+#include <ObjectTracking/MemoryUsage.h>
+
+using namespace ObjectTracking;
+
+TrajectoryBuffer::TrajectoryBuffer() = default;
+
+TrajectoryBuffer::~TrajectoryBuffer() = default;
+
+void TrajectoryBuffer::reset(int capacity) {
+    assert(capacity >= 0);
+    cap = capacity;
+    count = 0;
+    head = 0;
+    points.resize((size_t) 2 * cap);
+    if (cap == 0) {
+        points.shrink_to_fit();
+    }
+}
+
+void TrajectoryBuffer::clear() {
+    count = 0;
+    head = 0;
+}
+
+void TrajectoryBuffer::push(TrajectoryPoint const &point) {
+    assert(cap > 0);
+    points[head] = point;
+    points[head + cap] = point;
+    head = (head + 1) % cap;
+    count = std::min(count + 1, cap);
+}
+
+int TrajectoryBuffer::size() const {
+    return count;
+}
+
+int TrajectoryBuffer::getCapacity() const {
+    return cap;
+}
+
+size_t TrajectoryBuffer::getMemoryBytes() const {
+    return memory_usage::capacityBytes(points);
+}
+
+TrajectorySpan TrajectoryBuffer::getPoints() const {
+    return getLatest(count);
+}
+
+TrajectorySpan TrajectoryBuffer::getLatest(int n) const {
+    n = std::clamp(n, 0, count);
+    if (n == 0) {
+        return {};
+    }
+    // the newest point is at head - 1, the n latest end there in the mirrored copy
+    return {points.data() + head + cap - n, (size_t) n};
+}
@@ -0,0 +1,118 @@
+/**
+ * @desc:   checks the heap guarantee of the fixed-capacity mode: once a tracker is constructed and configured, update,
+ *          updateEvents, queryRegion and getSnapshot never allocate. operator new is replaced by a counting one, and
+ *          MOT detection files are tracked with the trajectory history, the dormant tier and the cascade enabled,
+ *          with room for every detection and track, then with fewer detection slots and fewer track slots than the
+ *          busiest frames need (the degraded paths). fails on the first update that allocates.
+ *              fixedCapacityAllocations <det.txt> [det.txt...]
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <ObjectTracking/ObjectTracker.h>
+#include "../tools/MotFiles.h"
+
+using namespace ObjectTracking;
+
+namespace {
+    std::atomic<long> numAllocations{0};
+
+    struct Scenario {
+        char const *name;
+        TrackerCapacity capacity;
+        bool detectionOverflow;     // the scenario must drop detections
+        bool trackOverflow;         // the scenario must drop tracks
+    };
+}
+
+void *operator new(std::size_t size) {
+    numAllocations++;
+    void *ptr = std::malloc(size > 0 ? size : 1);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+/**
+ * @return whether the scenario ran without allocating and overflowed as expected
+ */
+bool runScenario(std::vector<cv::Mat> const &frames, Scenario const &scenario, std::string const &sequence) {
+    ObjectTracker tracker(scenario.capacity, 2, 3, 0.3f);
+    tracker.setHistoryLength(8);
+    tracker.setDormantParams({30, 0.3f, false});
+    tracker.setCascadeParams({40.0f, 0.5f});
+    std::vector<TrackEvent> events;
+    events.reserve(4 * (size_t) scenario.capacity.maxTracks);
+    std::vector<int> trackerIds;
+    trackerIds.reserve(scenario.capacity.maxTracks);
+
+    long droppedDetections = 0, droppedTracks = 0;
+    for (int f = 0; f < (int) frames.size(); ++f) {
+        long before = numAllocations.load();
+        if (f % 2 == 0) {
+            cv::Mat bboxesPost = tracker.update(frames[f]);
+        } else {
+            tracker.updateEvents(frames[f], events);
+        }
+        trackerIds.clear();
+        tracker.queryRegion(cv::Rect2f(0, 0, 4096, 4096), trackerIds);
+        {
+            SnapshotBuffer::Handle snapshot = tracker.getSnapshot();
+        }
+        long allocations = numAllocations.load() - before;
+        if (allocations > 0) {
+            std::fprintf(stderr, "%s, %s: %ld heap allocations in frame %d\n", sequence.c_str(), scenario.name,
+                         allocations, f + 1);
+            return false;
+        }
+        droppedDetections += tracker.getStats().droppedDetections;
+        droppedTracks += tracker.getStats().droppedTracks;
+    }
+    if ((scenario.detectionOverflow && droppedDetections == 0) || (scenario.trackOverflow && droppedTracks == 0)) {
+        std::fprintf(stderr, "%s, %s: the capacity was not exceeded (%ld detections, %ld tracks dropped)\n",
+                     sequence.c_str(), scenario.name, droppedDetections, droppedTracks);
+        return false;
+    }
+    std::printf("%s, %s: %zu frames without allocation, %ld detections and %ld tracks dropped\n", sequence.c_str(),
+                scenario.name, frames.size(), droppedDetections, droppedTracks);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <det.txt> [det.txt...]\n", argv[0]);
+        return 1;
+    }
+    // the busiest TUD frames hold 16 detections and about as many tracks
+    Scenario const scenarios[] = {
+            {"room for all",          {64, 64}, false, false},
+            {"detection overflow",    {64, 4},  true,  false},
+            {"track overflow",        {4,  64}, false, true},
+    };
+    bool passed = true;
+    for (int i = 1; i < argc; ++i) {
+        std::vector<cv::Mat> frames = mot_files::readFrames(argv[i]);
+        if (frames.empty()) {
+            std::fprintf(stderr, "can not read detections %s\n", argv[i]);
+            return 1;
+        }
+        for (Scenario const &scenario: scenarios) {
+            passed = runScenario(frames, scenario, argv[i]) && passed;
+        }
+    }
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,514 @@
+/**
+ * @desc:   differential test and scaling benchmark of the assignment solvers (kuhn_munkres::KuhnMunkres and the
+ *          strategies of AssignmentPlanner).
+ *          every solver is compared against a double precision shortest augmenting path (Jonker-Volgenant style)
+ *          reference, itself checked by brute force on small matrices: the assignment must be valid (one pair per
+ *          row and column, min(rows, cols) pairs) and have the optimal total cost. the matrices are random, degenerate
+ *          (ties, all zeros, constant, huge and negative values, very rectangular) and IoU costs of jittered boxes as
+ *          in the tracker; matrices with NaN / inf must be rejected with NonFiniteCostException.
+ *              assignmentBench --check [--seed n]
+ *                  differential test, exit code 1 on any failure, e.g. as a test step
+ *              assignmentBench [--max-size n] [--budget seconds] [--csv timings.csv]
+ *                  timing curve of every solver from 1 x 1 up to max-size (default 2000) for square and IoU matrices;
+ *                  a solver is not run on larger sizes once a single solve took longer than budget (default 2 s)
+ *              assignmentBench --calibrate assignment.calib [--max-size n] [--budget seconds]
+ *                  times the AssignmentPlanner strategies on IoU matrices of every size bucket up to max-size and
+ *                  writes the cost model, to be loaded with ObjectTrackerBase::loadAssignmentCalibration; the buckets
+ *                  above max-size, or where a strategy went over budget, keep the default estimates
+ *          a new solver is added to the solvers list in main; the reference is timed as a baseline.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <ObjectTracking/AssignmentPlanner.h>
+#include <ObjectTracking/BoxKernels.h>
+#include <ObjectTracking/KuhnMunkres.h>
+
+using namespace ObjectTracking;
+using kuhn_munkres::KuhnMunkres;
+
+using Assignment = std::vector<std::pair<int, int>>;
+using SolveFunc = std::function<void(std::vector<float> const &, int, int, Assignment &)>;
+
+struct Solver {
+    std::string name;
+    SolveFunc solve;
+};
+
+struct CostMatrix {
+    std::string kind;
+    int rows, cols;
+    std::vector<float> costs;   // row-major
+};
+
+/**
+ * @brief minimal assignment cost, shortest augmenting paths with potentials in double precision, O(rows^2 cols)
+ * @param assignment optional output, the optimal pairs
+ */
+double referenceCost(CostMatrix const &matrix, Assignment *assignment = nullptr) {
+    bool transposed = matrix.rows > matrix.cols;
+    int n = transposed ? matrix.cols : matrix.rows, m = transposed ? matrix.rows : matrix.cols;
+    auto cost = [&](int i, int j) {
+        return (double) (transposed ? matrix.costs[(size_t) j * matrix.cols + i] : matrix.costs[(size_t) i * m + j]);
+    };
+    double const inf = std::numeric_limits<double>::infinity();
+    // 1-based, column 0 is the virtual start
+    std::vector<double> u(n + 1, 0), v(m + 1, 0), minv(m + 1);
+    std::vector<int> p(m + 1, 0), way(m + 1, 0);
+    std::vector<char> used(m + 1);
+    for (int i = 1; i <= n; ++i) {
+        p[0] = i;
+        int j0 = 0;
+        std::fill(minv.begin(), minv.end(), inf);
+        std::fill(used.begin(), used.end(), 0);
+        do {
+            used[j0] = 1;
+            int i0 = p[j0], j1 = 0;
+            double delta = inf;
+            for (int j = 1; j <= m; ++j) {
+                if (!used[j]) {
+                    double reduced = cost(i0 - 1, j - 1) - u[i0] - v[j];
+                    if (reduced < minv[j]) {
+                        minv[j] = reduced;
+                        way[j] = j0;
+                    }
+                    if (minv[j] < delta) {
+                        delta = minv[j];
+                        j1 = j;
+                    }
+                }
+            }
+            for (int j = 0; j <= m; ++j) {
+                if (used[j]) {
+                    u[p[j]] += delta;
+                    v[j] -= delta;
+                } else {
+                    minv[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (p[j0] != 0);
+        do {
+            int j1 = way[j0];
+            p[j0] = p[j1];
+            j0 = j1;
+        } while (j0 != 0);
+    }
+
+    double total = 0;
+    if (assignment != nullptr) {
+        assignment->clear();
+    }
+    for (int j = 1; j <= m; ++j) {
+        if (p[j] != 0) {
+            total += cost(p[j] - 1, j - 1);
+            if (assignment != nullptr) {
+                assignment->emplace_back(transposed ? j - 1 : p[j] - 1, transposed ? p[j] - 1 : j - 1);
+            }
+        }
+    }
+    return total;
+}
+
+/**
+ * @brief minimal assignment cost by enumerating the permutations, small matrices only
+ */
+double bruteForceCost(CostMatrix const &matrix) {
+    bool transposed = matrix.rows > matrix.cols;
+    int n = transposed ? matrix.cols : matrix.rows, m = transposed ? matrix.rows : matrix.cols;
+    std::vector<int> columns(m);
+    std::iota(columns.begin(), columns.end(), 0);
+    double best = std::numeric_limits<double>::infinity();
+    do {
+        double total = 0;
+        for (int i = 0; i < n; ++i) {
+            total += transposed ? matrix.costs[(size_t) columns[i] * matrix.cols + i]
+                                : matrix.costs[(size_t) i * m + columns[i]];
+        }
+        best = std::min(best, total);
+    } while (std::next_permutation(columns.begin(), columns.end()));
+    return best;
+}
+
+/**
+ * @return empty if the assignment is a valid complete assignment of the matrix, otherwise the reason
+ */
+std::string validate(CostMatrix const &matrix, Assignment const &assignment) {
+    std::vector<char> rowUsed(matrix.rows), colUsed(matrix.cols);
+    for (auto [i, j]: assignment) {
+        if (i < 0 || i >= matrix.rows || j < 0 || j >= matrix.cols) {
+            return "pair (" + std::to_string(i) + ", " + std::to_string(j) + ") out of range";
+        }
+        if (rowUsed[i]++ || colUsed[j]++) {
+            return "row " + std::to_string(i) + " or column " + std::to_string(j) + " assigned twice";
+        }
+    }
+    if ((int) assignment.size() != std::min(matrix.rows, matrix.cols)) {
+        return std::to_string(assignment.size()) + " pairs instead of " +
+               std::to_string(std::min(matrix.rows, matrix.cols));
+    }
+    return "";
+}
+
+double totalCost(CostMatrix const &matrix, Assignment const &assignment) {
+    double total = 0;
+    for (auto [i, j]: assignment) {
+        total += matrix.costs[(size_t) i * matrix.cols + j];
+    }
+    return total;
+}
+
+CostMatrix uniformMatrix(std::mt19937 &rng, int rows, int cols, float low = 0, float high = 1) {
+    CostMatrix matrix{"uniform", rows, cols, std::vector<float>((size_t) rows * cols)};
+    std::uniform_real_distribution<float> value(low, high);
+    for (float &cost: matrix.costs) {
+        cost = value(rng);
+    }
+    return matrix;
+}
+
+/**
+ * @brief integer costs in [0, levels), many ties
+ */
+CostMatrix tiesMatrix(std::mt19937 &rng, int rows, int cols, int levels) {
+    CostMatrix matrix{"ties", rows, cols, std::vector<float>((size_t) rows * cols)};
+    std::uniform_int_distribution<int> value(0, levels - 1);
+    for (float &cost: matrix.costs) {
+        cost = (float) value(rng);
+    }
+    return matrix;
+}
+
+/**
+ * @brief 1 - IoU costs between boxes and jittered copies of them, as in the tracker association: tracks spread
+ *        over a 1920 x 1080 frame, most of them detected, some detections are clutter
+ */
+CostMatrix iouMatrix(std::mt19937 &rng, int rows, int cols) {
+    std::uniform_real_distribution<float> x(0, 1920), y(0, 1080), size(20, 200), jitter(-8, 8), unit(0, 1);
+    std::vector<float> tracks, detections;
+    for (int j = 0; j < cols; ++j) {
+        tracks.insert(tracks.end(), {x(rng), y(rng), size(rng), size(rng)});
+    }
+    for (int i = 0; i < rows; ++i) {
+        if (i < cols && unit(rng) < 0.9f) {
+            float const *track = &tracks[(size_t) 4 * i];
+            detections.insert(detections.end(), {track[0] + jitter(rng), track[1] + jitter(rng),
+                                                 track[2] + jitter(rng), track[3] + jitter(rng)});
+        } else {
+            detections.insert(detections.end(), {x(rng), y(rng), size(rng), size(rng)});
+        }
+    }
+    box_kernels::BoxSet detBoxes, trackBoxes;
+    for (int i = 0; i < rows; ++i) {
+        detBoxes.push_back(&detections[(size_t) 4 * i]);
+    }
+    for (int j = 0; j < cols; ++j) {
+        trackBoxes.push_back(&tracks[(size_t) 4 * j]);
+    }
+    CostMatrix matrix{"iou", rows, cols, std::vector<float>((size_t) rows * cols)};
+    for (int i = 0; i < rows; ++i) {
+        box_kernels::iouOneToMany(detBoxes, i, trackBoxes, 0, cols, &matrix.costs[(size_t) i * cols]);
+        for (int j = 0; j < cols; ++j) {
+            matrix.costs[(size_t) i * cols + j] = 1.0f - matrix.costs[(size_t) i * cols + j];
+        }
+    }
+    return matrix;
+}
+
+CostMatrix constantMatrix(std::string const &kind, int rows, int cols, float value) {
+    return {kind, rows, cols, std::vector<float>((size_t) rows * cols, value)};
+}
+
+std::vector<CostMatrix> checkMatrices(std::mt19937 &rng) {
+    std::vector<CostMatrix> matrices;
+    std::uniform_int_distribution<int> smallSize(1, 7);
+    for (int k = 0; k < 200; ++k) {
+        int rows = smallSize(rng), cols = smallSize(rng);
+        matrices.push_back(uniformMatrix(rng, rows, cols));
+        matrices.push_back(tiesMatrix(rng, rows, cols, 3));
+        matrices.push_back(iouMatrix(rng, rows, cols));
+    }
+    for (auto [rows, cols]: std::vector<std::pair<int, int>>{{1, 1}, {1, 50}, {50, 1}, {3, 200}, {200, 3}, {20, 20},
+                                                             {64, 64}, {100, 40}, {40, 100}, {150, 150}}) {
+        matrices.push_back(uniformMatrix(rng, rows, cols));
+        matrices.push_back(tiesMatrix(rng, rows, cols, 2));
+        matrices.push_back(tiesMatrix(rng, rows, cols, 5));
+        matrices.push_back(iouMatrix(rng, rows, cols));
+        matrices.push_back(constantMatrix("zeros", rows, cols, 0));
+        matrices.push_back(constantMatrix("constant", rows, cols, 0.7f));
+        CostMatrix huge = uniformMatrix(rng, rows, cols, 1e5f, 1e6f);
+        huge.kind = "huge";
+        matrices.push_back(huge);
+        CostMatrix negative = uniformMatrix(rng, rows, cols, -1, 0);
+        negative.kind = "negative";
+        matrices.push_back(negative);
+    }
+    return matrices;
+}
+
+/**
+ * @return background cost of a matrix for the decomposed planner strategies, its largest finite cost
+ */
+float getBackground(std::vector<float> const &costs) {
+    float background = 0;
+    for (float cost: costs) {
+        if (std::isfinite(cost)) {
+            background = std::max(background, cost);
+        }
+    }
+    return background;
+}
+
+/**
+ * @return sizes of the timing curves, powers of two then maxSize
+ */
+std::vector<int> getSizes(int maxSize) {
+    std::vector<int> sizes;
+    for (int size = 1; size < maxSize; size *= 2) {
+        sizes.push_back(size);
+    }
+    sizes.push_back(maxSize);
+    return sizes;
+}
+
+/**
+ * @return number of failures
+ */
+int check(std::vector<Solver> const &solvers, unsigned seed) {
+    std::mt19937 rng(seed);
+    int failures = 0, numChecks = 0;
+    auto fail = [&failures](std::string const &solver, CostMatrix const &matrix, std::string const &reason) {
+        std::printf("FAIL %s on %s %d x %d: %s\n", solver.c_str(), matrix.kind.c_str(), matrix.rows, matrix.cols,
+                    reason.c_str());
+        failures++;
+    };
+
+    Assignment assignment;
+    for (CostMatrix const &matrix: checkMatrices(rng)) {
+        double reference = referenceCost(matrix, &assignment);
+        std::string reason = validate(matrix, assignment);
+        if (!reason.empty()) {
+            fail("reference", matrix, reason);
+        }
+        if (std::max(matrix.rows, matrix.cols) <= 7) {
+            double bruteForce = bruteForceCost(matrix);
+            if (std::abs(bruteForce - reference) > 1e-6 * std::max(1.0, std::abs(bruteForce))) {
+                fail("reference", matrix, "cost " + std::to_string(reference) + ", brute force " +
+                                          std::to_string(bruteForce));
+            }
+        }
+        // float solvers: tolerance relative to the magnitude of the summed costs
+        double magnitude = 0;
+        for (float cost: matrix.costs) {
+            magnitude = std::max(magnitude, (double) std::abs(cost));
+        }
+        double tolerance = 1e-5 * std::max(1.0, magnitude) * std::min(matrix.rows, matrix.cols);
+        for (Solver const &solver: solvers) {
+            numChecks++;
+            try {
+                solver.solve(matrix.costs, matrix.rows, matrix.cols, assignment);
+            } catch (std::exception const &e) {
+                fail(solver.name, matrix, std::string("exception: ") + e.what());
+                continue;
+            }
+            reason = validate(matrix, assignment);
+            double total = totalCost(matrix, assignment);
+            if (!reason.empty()) {
+                fail(solver.name, matrix, reason);
+            } else if (std::abs(total - reference) > tolerance) {
+                fail(solver.name, matrix, "cost " + std::to_string(total) + ", optimal " + std::to_string(reference));
+            }
+        }
+    }
+
+    // non-finite costs are rejected, not looped on
+    for (float bad: {std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::infinity(),
+                     -std::numeric_limits<float>::infinity()}) {
+        CostMatrix matrix = uniformMatrix(rng, 6, 9);
+        matrix.kind = std::isnan(bad) ? "nan" : (bad > 0 ? "inf" : "-inf");
+        matrix.costs[13] = bad;
+        for (Solver const &solver: solvers) {
+            numChecks++;
+            try {
+                solver.solve(matrix.costs, matrix.rows, matrix.cols, assignment);
+                fail(solver.name, matrix, "accepted");
+            } catch (kuhn_munkres::NonFiniteCostException const &) {
+            } catch (std::exception const &e) {
+                fail(solver.name, matrix, std::string("unexpected exception: ") + e.what());
+            }
+        }
+    }
+
+    std::printf("%d checks, %d failures\n", numChecks, failures);
+    return failures;
+}
+
+void benchmark(std::vector<Solver> const &solvers, int maxSize, double budget, std::string const &csvPath) {
+    std::vector<int> sizes = getSizes(maxSize);
+    std::FILE *csv = csvPath.empty() ? nullptr : std::fopen(csvPath.c_str(), "w");
+    if (!csvPath.empty() && csv == nullptr) {
+        std::fprintf(stderr, "can not write %s\n", csvPath.c_str());
+    }
+    if (csv != nullptr) {
+        std::fprintf(csv, "solver,kind,rows,cols,repeats,mean_ms,min_ms\n");
+    }
+    std::printf("%-16s %-8s %6s %6s %8s %12s %12s\n", "solver", "kind", "rows", "cols", "repeats", "mean ms", "min ms");
+
+    std::mt19937 rng(1);
+    Assignment assignment;
+    for (std::string kind: {"uniform", "iou"}) {
+        std::vector<bool> overBudget(solvers.size(), false);
+        for (int size: sizes) {
+            CostMatrix matrix = kind == "iou" ? iouMatrix(rng, size, size) : uniformMatrix(rng, size, size);
+            for (size_t s = 0; s < solvers.size(); ++s) {
+                if (overBudget[s]) {
+                    continue;
+                }
+                // repeat small sizes for a stable time, at most ~budget / 4 in total
+                double total = 0, best = std::numeric_limits<double>::infinity();
+                int repeats = 0;
+                while (repeats < 1000 && (repeats == 0 || total < 250 * budget)) {
+                    auto start = std::chrono::steady_clock::now();
+                    solvers[s].solve(matrix.costs, matrix.rows, matrix.cols, assignment);
+                    double ms = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - start).count();
+                    total += ms;
+                    best = std::min(best, ms);
+                    repeats++;
+                    if (ms > 1000 * budget) {
+                        break;
+                    }
+                }
+                overBudget[s] = best > 1000 * budget;
+                std::printf("%-16s %-8s %6d %6d %8d %12.4f %12.4f%s\n", solvers[s].name.c_str(), kind.c_str(), size,
+                            size, repeats, total / repeats, best, overBudget[s] ? "  (over budget, stopped)" : "");
+                if (csv != nullptr) {
+                    std::fprintf(csv, "%s,%s,%d,%d,%d,%.6f,%.6f\n", solvers[s].name.c_str(), kind.c_str(), size, size,
+                                 repeats, total / repeats, best);
+                }
+                std::fflush(stdout);
+            }
+        }
+    }
+    if (csv != nullptr) {
+        std::fclose(csv);
+    }
+}
+
+int calibrate(int maxSize, double budget, std::string const &path) {
+    AssignmentPlanner planner;
+    std::mt19937 rng(1);
+    Assignment assignment;
+    int const numMatrices = 4, numSolves = 64;
+    std::vector<bool> overBudget(AssignmentPlanner::numStrategies, false);
+    std::printf("%-12s %6s %8s %12s\n", "strategy", "size", "solves", "mean ms");
+    for (int size: getSizes(maxSize)) {
+        // square and rectangular matrices, as many detections as tracks give the largest Kuhn Munkres blocks
+        std::vector<CostMatrix> matrices;
+        for (int k = 0; k < numMatrices; ++k) {
+            matrices.push_back(iouMatrix(rng, k % 2 == 0 ? size : std::max(1, 3 * size / 4), size));
+        }
+        for (int s = 0; s < AssignmentPlanner::numStrategies; ++s) {
+            if (overBudget[s]) {
+                continue;
+            }
+            auto strategy = (AssignmentStrategy) s;
+            double total = 0;
+            int solves = 0;
+            while (solves < numSolves && total < 250 * budget) {
+                CostMatrix const &matrix = matrices[solves % numMatrices];
+                auto start = std::chrono::steady_clock::now();
+                planner.computeWith(strategy, matrix.costs.data(), matrix.rows, matrix.cols, 1.0f, assignment);
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                total += ms;
+                solves++;
+                overBudget[s] = overBudget[s] || ms > 1000 * budget;
+            }
+            std::printf("%-12s %6d %8d %12.4f%s\n", AssignmentPlanner::getStrategyName(strategy), size, solves,
+                        total / solves, overBudget[s] ? "  (over budget, stopped)" : "");
+            std::fflush(stdout);
+        }
+    }
+    try {
+        planner.saveCalibration(path);
+    } catch (std::exception const &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    std::printf("calibration written to %s\n", path.c_str());
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    bool isCheck = false;
+    unsigned seed = 42;
+    int maxSize = 2000;
+    double budget = 2.0;
+    std::string csvPath, calibrationPath;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--check") == 0) {
+            isCheck = true;
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (unsigned) std::stoul(argv[++i]);
+        } else if (std::strcmp(argv[i], "--max-size") == 0 && i + 1 < argc) {
+            maxSize = std::max(1, std::stoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--budget") == 0 && i + 1 < argc) {
+            budget = std::stod(argv[++i]);
+        } else if (std::strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--calibrate") == 0 && i + 1 < argc) {
+            calibrationPath = argv[++i];
+        } else {
+            std::fprintf(stderr, "usage: %s --check [--seed n] | [--max-size n] [--budget seconds] [--csv path] | "
+                                 "--calibrate path [--max-size n] [--budget seconds]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (!calibrationPath.empty()) {
+        return calibrate(maxSize, budget, calibrationPath);
+    }
+
+    KuhnMunkres km;
+    AssignmentPlanner planner;
+    std::vector<Solver> solvers{
+            {"km-flat", [&km](std::vector<float> const &costs, int rows, int cols, Assignment &result) {
+                km.compute(costs.data(), rows, cols, result);
+            }},
+            {"km-vector", [&km](std::vector<float> const &costs, int rows, int cols, Assignment &result) {
+                kuhn_munkres::Vec2f matrix(rows);
+                for (int i = 0; i < rows; ++i) {
+                    matrix[i].assign(costs.begin() + (long) i * cols, costs.begin() + (long) (i + 1) * cols);
+                }
+                result = km.compute(matrix);
+            }},
+            {"components", [&planner](std::vector<float> const &costs, int rows, int cols, Assignment &result) {
+                planner.computeWith(AssignmentStrategy::Components, costs.data(), rows, cols, getBackground(costs),
+                                    result);
+            }},
+    };
+
+    if (isCheck) {
+        return check(solvers, seed) == 0 ? 0 : 1;
+    }
+    // greedy is not optimal, it is only timed; the reference as a baseline of the timing curves
+    solvers.push_back({"greedy", [&planner](std::vector<float> const &costs, int rows, int cols, Assignment &result) {
+        planner.computeWith(AssignmentStrategy::Greedy, costs.data(), rows, cols, getBackground(costs), result);
+    }});
+    solvers.push_back({"reference", [](std::vector<float> const &costs, int rows, int cols, Assignment &result) {
+        referenceCost({"", rows, cols, costs}, &result);
+    }});
+    benchmark(solvers, maxSize, budget, csvPath);
+    return 0;
+}
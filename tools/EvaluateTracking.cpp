@@ -0,0 +1,301 @@
+/**
+ * @desc:   headless evaluation of the tracker speed and accuracy together, for parameter tuning and for comparing
+ *          builds. every (sequence, parameter) combination runs as one job on a thread pool; each job tracks the
+ *          sequence det/det.txt and scores it against gt/gt.txt (MotMetrics.h), and times every update.
+ *              evaluateTracking [options] <sequence dir>...
+ *          --max-age, --min-hits, --iou    comma separated parameter values, all combinations are run
+ *                                          (default 1 / 3 / 0.3)
+ *          --cascade   comma separated score thresholds of the cascaded association (CascadeParams), also
+ *                      combined with the others (default 0, no cascade)
+ *          --model     ConstantVelocity (default), ConstantAcceleration or XywhVelocity
+ *          --jobs      number of worker threads (default: hardware threads)
+ *          --report    JSON report path (default evaluation.json)
+ *          latencies are measured with all the workers running; use --jobs 1 for isolated timings.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ObjectTracking/ObjectTracker.h>
+#include "MotFiles.h"
+#include "MotMetrics.h"
+
+using namespace ObjectTracking;
+
+struct Sequence {
+    std::string name;
+    std::vector<cv::Mat> detections;        // frame f at index f - 1
+    std::vector<cv::Mat> gt;
+    std::vector<std::vector<int>> gtIds;
+};
+
+struct Job {
+    int sequence;
+    int maxAge;
+    int minHits;
+    float iouThresh;
+    float cascadeScore;
+};
+
+struct JobResult {
+    mot_metrics::MotSummary metrics;
+    int frames = 0;
+    double trackingTime = 0;    // sum of the update times, ms
+    double mean = 0, p50 = 0, p90 = 0, p99 = 0, max = 0;    // update latency, ms
+};
+
+template<class MotionModel>
+JobResult runJob(Sequence const &sequence, Job const &job) {
+    ObjectTrackerT<MotionModel> tracker(job.maxAge, job.minHits, job.iouThresh);
+    CascadeParams cascade;
+    cascade.scoreThresh = job.cascadeScore;
+    tracker.setCascadeParams(cascade);
+    mot_metrics::MotAccumulator accumulator;
+    JobResult result;
+    std::vector<double> latencies;
+    cv::Mat noDetections(0, 6, CV_32F), noGt(0, 6, CV_32F);
+    std::vector<int> noIds;
+    int numFrames = (int) std::max(sequence.detections.size(), sequence.gt.size());
+    for (int f = 0; f < numFrames; ++f) {
+        cv::Mat const &detections = f < (int) sequence.detections.size() ? sequence.detections[f] : noDetections;
+        auto start = std::chrono::steady_clock::now();
+        cv::Mat bboxesPost = tracker.update(detections);
+        latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        bool hasGt = f < (int) sequence.gt.size();
+        accumulator.addFrame(hasGt ? sequence.gt[f] : noGt, hasGt ? sequence.gtIds[f] : noIds, bboxesPost);
+    }
+
+    result.metrics = accumulator.summarize();
+    result.frames = numFrames;
+    if (!latencies.empty()) {
+        for (double latency: latencies) {
+            result.trackingTime += latency;
+        }
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&latencies](double p) { return latencies[(size_t) (p * (double) (latencies.size() - 1))]; };
+        result.mean = result.trackingTime / (double) latencies.size();
+        result.p50 = percentile(0.5);
+        result.p90 = percentile(0.9);
+        result.p99 = percentile(0.99);
+        result.max = latencies.back();
+    }
+    return result;
+}
+
+JobResult runJob(std::string const &model, Sequence const &sequence, Job const &job) {
+    if (model == ConstantAccelerationModel::name) {
+        return runJob<ConstantAccelerationModel>(sequence, job);
+    } else if (model == XywhVelocityModel::name) {
+        return runJob<XywhVelocityModel>(sequence, job);
+    }
+    return runJob<ConstantVelocityModel>(sequence, job);
+}
+
+/**
+ * @brief ground truth rows to score against: MOT16+ marks the rows to ignore with a zero in the confidence column
+ */
+void removeIgnoredGt(Sequence &sequence) {
+    for (size_t f = 0; f < sequence.gt.size(); ++f) {
+        cv::Mat kept(0, 6, CV_32F);
+        std::vector<int> keptIds;
+        for (int i = 0; i < sequence.gt[f].rows; ++i) {
+            if (sequence.gt[f].at<float>(i, 4) != 0) {
+                cv::vconcat(kept, sequence.gt[f].rowRange(i, i + 1), kept);
+                keptIds.push_back(sequence.gtIds[f][i]);
+            }
+        }
+        sequence.gt[f] = kept;
+        sequence.gtIds[f] = keptIds;
+    }
+}
+
+template<typename T>
+std::vector<T> parseList(char const *text, T (*parse)(std::string const &, size_t *)) {
+    std::vector<T> values;
+    std::string item;
+    for (char const *c = text;; ++c) {
+        if (*c == ',' || *c == '\0') {
+            if (!item.empty()) {
+                values.push_back(parse(item, nullptr));
+            }
+            item.clear();
+            if (*c == '\0') {
+                break;
+            }
+        } else {
+            item += *c;
+        }
+    }
+    return values;
+}
+
+int parseInt(std::string const &text, size_t *pos) {
+    return std::stoi(text, pos);
+}
+
+float parseFloat(std::string const &text, size_t *pos) {
+    return std::stof(text, pos);
+}
+
+int main(int argc, char **argv) {
+    std::vector<int> maxAges{1}, minHits{3};
+    std::vector<float> iouThreshs{0.3f}, cascadeScores{0.0f};
+    std::string model = ConstantVelocityModel::name, reportPath = "evaluation.json";
+    int numWorkers = std::max(1, (int) std::thread::hardware_concurrency());
+    std::vector<std::string> sequencePaths;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--max-age") == 0 && hasValue) {
+            maxAges = parseList(argv[++i], parseInt);
+        } else if (std::strcmp(argv[i], "--min-hits") == 0 && hasValue) {
+            minHits = parseList(argv[++i], parseInt);
+        } else if (std::strcmp(argv[i], "--iou") == 0 && hasValue) {
+            iouThreshs = parseList(argv[++i], parseFloat);
+        } else if (std::strcmp(argv[i], "--cascade") == 0 && hasValue) {
+            cascadeScores = parseList(argv[++i], parseFloat);
+        } else if (std::strcmp(argv[i], "--model") == 0 && hasValue) {
+            model = argv[++i];
+        } else if (std::strcmp(argv[i], "--jobs") == 0 && hasValue) {
+            numWorkers = std::max(1, std::stoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--report") == 0 && hasValue) {
+            reportPath = argv[++i];
+        } else {
+            sequencePaths.emplace_back(argv[i]);
+        }
+    }
+    if (sequencePaths.empty()) {
+        std::fprintf(stderr, "usage: %s [--max-age 1,3] [--min-hits 3] [--iou 0.3] [--cascade 0,30] [--model name] "
+                             "[--jobs n] [--report evaluation.json] <sequence dir>...\n", argv[0]);
+        return 1;
+    }
+    if (std::any_of(iouThreshs.begin(), iouThreshs.end(), [](float iou) { return iou <= 0 || iou > 1; })) {
+        std::fprintf(stderr, "--iou values must be in (0, 1]\n");
+        return 1;
+    }
+    if (model != ConstantVelocityModel::name && model != ConstantAccelerationModel::name &&
+        model != XywhVelocityModel::name) {
+        std::fprintf(stderr, "unknown motion model %s\n", model.c_str());
+        return 1;
+    }
+
+    std::vector<Sequence> sequences;
+    for (auto path: sequencePaths) {
+        while (path.size() > 1 && path.back() == '/') {
+            path.pop_back();
+        }
+        Sequence sequence;
+        sequence.name = path.substr(path.find_last_of('/') + 1);
+        sequence.detections = mot_files::readFrames(path + "/det/det.txt");
+        sequence.gt = mot_files::readFrames(path + "/gt/gt.txt", &sequence.gtIds);
+        if (sequence.detections.empty() || sequence.gt.empty()) {
+            std::fprintf(stderr, "skipping %s: missing det/det.txt or gt/gt.txt\n", path.c_str());
+            continue;
+        }
+        removeIgnoredGt(sequence);
+        sequences.push_back(std::move(sequence));
+    }
+
+    std::vector<Job> jobs;
+    for (int s = 0; s < (int) sequences.size(); ++s) {
+        for (int maxAge: maxAges) {
+            for (int hits: minHits) {
+                for (float iouThresh: iouThreshs) {
+                    for (float cascadeScore: cascadeScores) {
+                        jobs.push_back({s, maxAge, hits, iouThresh, cascadeScore});
+                    }
+                }
+            }
+        }
+    }
+
+    // thread pool, the workers take the next job until none is left
+    std::vector<JobResult> results(jobs.size());
+    std::atomic<size_t> nextJob{0};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int w = 0; w < std::min(numWorkers, (int) jobs.size()); ++w) {
+        workers.emplace_back([&] {
+            for (size_t j = nextJob++; j < jobs.size(); j = nextJob++) {
+                results[j] = runJob(model, sequences[jobs[j].sequence], jobs[j]);
+            }
+        });
+    }
+    for (auto &worker: workers) {
+        worker.join();
+    }
+    double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%-16s %7s %8s %5s %8s %8s %8s %6s %6s %6s %10s %8s %8s\n", "sequence", "maxAge", "minHits", "iou",
+                "cascade", "MOTA", "IDF1", "IDSW", "FP", "FN", "frames/s", "p50 ms", "p99 ms");
+    for (size_t j = 0; j < jobs.size(); ++j) {
+        Job const &job = jobs[j];
+        JobResult const &r = results[j];
+        std::printf("%-16s %7d %8d %5.2f %8.2f %8.4f %8.4f %6ld %6ld %6ld %10.1f %8.4f %8.4f\n",
+                    sequences[job.sequence].name.c_str(), job.maxAge, job.minHits, job.iouThresh, job.cascadeScore,
+                    r.metrics.mota,
+                    r.metrics.idf1, r.metrics.idSwitches, r.metrics.falsePositives, r.metrics.falseNegatives,
+                    r.trackingTime > 0 ? 1000.0 * r.frames / r.trackingTime : 0.0, r.p50, r.p99);
+    }
+    std::printf("%zu jobs on %d workers in %.3f s\n", jobs.size(), std::min(numWorkers, (int) jobs.size()),
+                wallTime);
+
+    std::FILE *report = std::fopen(reportPath.c_str(), "w");
+    if (report == nullptr) {
+        std::fprintf(stderr, "can not write %s\n", reportPath.c_str());
+        return 1;
+    }
+    std::fprintf(report, "{\n  \"model\": \"%s\",\n  \"workers\": %d,\n  \"wallTimeSeconds\": %.4f,\n  \"results\": [",
+                 model.c_str(), std::min(numWorkers, (int) jobs.size()), wallTime);
+    for (size_t j = 0; j < jobs.size(); ++j) {
+        Job const &job = jobs[j];
+        JobResult const &r = results[j];
+        mot_metrics::MotSummary const &m = r.metrics;
+        std::fprintf(report, "%s\n    {\"sequence\": \"%s\", \"maxAge\": %d, \"minHits\": %d, \"iouThresh\": %.4f, "
+                             "\"cascadeScore\": %.4f, \"frames\": %d, \"mota\": %.6f, \"idf1\": %.6f, "
+                             "\"idSwitches\": %ld, \"falsePositives\": %ld, \"falseNegatives\": %ld, "
+                             "\"truePositives\": %ld, \"gt\": %ld, \"predictions\": %ld, \"framesPerSecond\": %.2f, "
+                             "\"latencyMs\": {\"mean\": %.6f, \"p50\": %.6f, \"p90\": %.6f, \"p99\": %.6f, "
+                             "\"max\": %.6f}}", j > 0 ? "," : "", sequences[job.sequence].name.c_str(), job.maxAge,
+                     job.minHits, job.iouThresh, job.cascadeScore, r.frames, m.mota, m.idf1, m.idSwitches,
+                     m.falsePositives, m.falseNegatives, m.truePositives, m.numGt, m.numPredictions,
+                     r.trackingTime > 0 ? 1000.0 * r.frames / r.trackingTime : 0.0, r.mean, r.p50, r.p90, r.p99,
+                     r.max);
+    }
+    // every parameter combination over all the sequences, the metrics from the summed counts
+    std::fprintf(report, "\n  ],\n  \"summary\": [");
+    size_t numCombinations = sequences.empty() ? 0 : jobs.size() / sequences.size();
+    for (size_t c = 0; c < numCombinations; ++c) {
+        mot_metrics::MotSummary m;
+        long frames = 0;
+        double trackingTime = 0;
+        for (size_t j = c; j < jobs.size(); j += numCombinations) {
+            mot_metrics::MotSummary const &r = results[j].metrics;
+            m.numGt += r.numGt;
+            m.numPredictions += r.numPredictions;
+            m.falsePositives += r.falsePositives;
+            m.falseNegatives += r.falseNegatives;
+            m.idSwitches += r.idSwitches;
+            m.idTruePositives += r.idTruePositives;
+            frames += results[j].frames;
+            trackingTime += results[j].trackingTime;
+        }
+        m.mota = m.numGt > 0 ? 1.0 - double(m.falseNegatives + m.falsePositives + m.idSwitches) / (double) m.numGt : 0;
+        m.idf1 = m.numGt + m.numPredictions > 0 ? 2.0 * (double) m.idTruePositives / double(m.numGt + m.numPredictions)
+                                                : 0;
+        std::fprintf(report, "%s\n    {\"maxAge\": %d, \"minHits\": %d, \"iouThresh\": %.4f, \"cascadeScore\": %.4f, "
+                             "\"frames\": %ld, \"mota\": %.6f, \"idf1\": %.6f, \"idSwitches\": %ld, "
+                             "\"framesPerSecond\": %.2f}", c > 0 ? "," : "", jobs[c].maxAge, jobs[c].minHits,
+                     jobs[c].iouThresh, jobs[c].cascadeScore, frames, m.mota, m.idf1, m.idSwitches,
+                     trackingTime > 0 ? 1000.0 * (double) frames / trackingTime : 0.0);
+    }
+    std::fprintf(report, "\n  ]\n}\n");
+    std::fclose(report);
+    std::printf("report written to %s\n", reportPath.c_str());
+    return 0;
+}
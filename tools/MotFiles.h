@@ -0,0 +1,82 @@
+/**
+ * @desc:   MOTChallenge text files used by the tools: det.txt / gt.txt rows
+ *          <frame>,<id>,<left>,<top>,<width>,<height>,<score>,...
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+namespace ObjectTracking::mot_files {
+    /**
+     * @brief parse the comma separated numbers of a row
+     * @return false if a field is not a finite number (surrounding spaces allowed)
+     */
+    inline bool parseRow(std::string const &line, std::vector<float> &values) {
+        std::istringstream iss(line);
+        std::string item;
+        values.clear();
+        while (std::getline(iss, item, ',')) {
+            char *end = nullptr;
+            float value = std::strtof(item.c_str(), &end);
+            if (end == item.c_str() || !std::isfinite(value)) {
+                return false;
+            }
+            while (*end == ' ' || *end == '\t' || *end == '\r') {
+                ++end;
+            }
+            if (*end != '\0') {
+                return false;
+            }
+            values.push_back(value);
+        }
+        return true;
+    }
+
+    /**
+     * @brief read a MOT detection or ground-truth file. blank lines are skipped; malformed rows (non-numeric
+     *        fields, fewer than 7 fields, frame < 1) are skipped and reported on stderr with the file and line number
+     * @param path file path
+     * @param ids optional output, ids column of every row, same layout as the returned frames
+     * @return detections per frame, index f - 1 for frame f, Mat(M, 6) [xc, yc, w, h, score, 0]; empty if the file
+     *         can not be read
+     */
+    inline std::vector<cv::Mat> readFrames(std::string const &path, std::vector<std::vector<int>> *ids = nullptr) {
+        std::vector<cv::Mat> frames;
+        std::ifstream ifs(path);
+        std::string line;
+        std::vector<float> values;
+        int lineNumber = 0;
+        while (std::getline(ifs, line)) {
+            ++lineNumber;
+            if (line.find_first_not_of(" \t\r") == std::string::npos) {
+                continue;
+            }
+            if (!parseRow(line, values) || values.size() < 7 || values[0] < 1) {
+                std::fprintf(stderr, "%s:%d: malformed MOT row skipped\n", path.c_str(), lineNumber);
+                continue;
+            }
+            auto frame = (size_t) values[0];
+            if (frames.size() < frame) {
+                frames.resize(frame, cv::Mat(0, 6, CV_32F));
+                if (ids != nullptr) {
+                    ids->resize(frame);
+                }
+            }
+            cv::Mat row = (cv::Mat_<float>(1, 6) << values[2] + values[4] / 2, values[3] + values[5] / 2,
+                    values[4], values[5], values[6], 0);
+            cv::vconcat(frames[frame - 1], row, frames[frame - 1]);
+            if (ids != nullptr) {
+                (*ids)[frame - 1].push_back((int) values[1]);
+            }
+        }
+        return frames;
+    }
+}
@@ -0,0 +1,182 @@
+/**
+ * @desc:   MOT accuracy metrics of a tracker output against a ground truth, accumulated frame by frame:
+ *          CLEAR MOT (MOTA, false positives / negatives, ID switches) and the identity metric IDF1.
+ *          a track and a ground-truth box correspond when their IoU is at least the threshold (0.5).
+ *              MOTA = 1 - (FN + FP + IDSW) / GT
+ *              IDF1 = 2 IDTP / (GT + predictions), IDTP from the best one-to-one ground-truth id <-> track id mapping
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <ObjectTracking/KuhnMunkres.h>
+
+namespace ObjectTracking::mot_metrics {
+    struct MotSummary {
+        long numGt = 0, numPredictions = 0;
+        long truePositives = 0, falsePositives = 0, falseNegatives = 0;
+        long idSwitches = 0;
+        long idTruePositives = 0;
+        double mota = 0, idf1 = 0;
+    };
+
+    class MotAccumulator {
+        // variables
+    private:
+        float iouThresh;
+        MotSummary summary;
+        std::unordered_map<int, int> lastMatch;         // ground-truth id -> track id of its last match
+        std::map<std::pair<int, int>, int> coverage;    // (ground-truth id, track id) -> frames with IoU >= thresh
+        kuhn_munkres::KuhnMunkres km;
+        // scratch
+        std::vector<float> iou, cost;
+        std::vector<int> gtMatch, predMatch;
+        std::vector<std::pair<int, int>> assignment;
+        std::vector<int> freeGt, freePred;
+
+        // methods
+    public:
+        explicit MotAccumulator(float iouThresh = 0.5f) : iouThresh(iouThresh) {}
+
+        /**
+         * @brief add one frame
+         * @param gt ground truth, Mat(G, 4+) [xc, yc, w, h, ...]
+         * @param gtIds ground-truth id of every row of gt
+         * @param predictions tracker output, Mat(N, 9) [xc, yc, w, h, score, class_id, dx, dy, tracker_id]
+         */
+        void addFrame(cv::Mat const &gt, std::vector<int> const &gtIds, cv::Mat const &predictions) {
+            int numGt = gt.rows, numPred = predictions.rows;
+            summary.numGt += numGt;
+            summary.numPredictions += numPred;
+            iou.assign((size_t) numGt * numPred, 0.0f);
+            for (int i = 0; i < numGt; ++i) {
+                for (int j = 0; j < numPred; ++j) {
+                    float value = getIou(gt.ptr<float>(i), predictions.ptr<float>(j));
+                    iou[(size_t) i * numPred + j] = value;
+                    if (value >= iouThresh) {
+                        coverage[{gtIds[i], getTrackId(predictions, j)}]++;
+                    }
+                }
+            }
+
+            // keep the correspondences of the previous frames if still valid
+            gtMatch.assign(numGt, -1);
+            predMatch.assign(numPred, -1);
+            for (int i = 0; i < numGt; ++i) {
+                auto last = lastMatch.find(gtIds[i]);
+                if (last == lastMatch.end()) {
+                    continue;
+                }
+                for (int j = 0; j < numPred; ++j) {
+                    if (predMatch[j] < 0 && getTrackId(predictions, j) == last->second &&
+                        iou[(size_t) i * numPred + j] >= iouThresh) {
+                        gtMatch[i] = j;
+                        predMatch[j] = i;
+                        break;
+                    }
+                }
+            }
+
+            // assign the others by IoU
+            freeGt.clear();
+            freePred.clear();
+            for (int i = 0; i < numGt; ++i) {
+                if (gtMatch[i] < 0) {
+                    freeGt.push_back(i);
+                }
+            }
+            for (int j = 0; j < numPred; ++j) {
+                if (predMatch[j] < 0) {
+                    freePred.push_back(j);
+                }
+            }
+            if (!freeGt.empty() && !freePred.empty()) {
+                int rows = (int) freeGt.size(), cols = (int) freePred.size();
+                cost.resize((size_t) rows * cols);
+                for (int a = 0; a < rows; ++a) {
+                    for (int b = 0; b < cols; ++b) {
+                        float value = iou[(size_t) freeGt[a] * numPred + freePred[b]];
+                        cost[(size_t) a * cols + b] = value >= iouThresh ? 1.0f - value : 1.0f;
+                    }
+                }
+                km.compute(cost.data(), rows, cols, assignment);
+                for (auto [a, b]: assignment) {
+                    int i = freeGt[a], j = freePred[b];
+                    if (iou[(size_t) i * numPred + j] >= iouThresh) {
+                        gtMatch[i] = j;
+                        predMatch[j] = i;
+                    }
+                }
+            }
+
+            int matches = 0;
+            for (int i = 0; i < numGt; ++i) {
+                if (gtMatch[i] < 0) {
+                    continue;
+                }
+                matches++;
+                int trackId = getTrackId(predictions, gtMatch[i]);
+                auto last = lastMatch.find(gtIds[i]);
+                if (last != lastMatch.end() && last->second != trackId) {
+                    summary.idSwitches++;
+                }
+                lastMatch[gtIds[i]] = trackId;
+            }
+            summary.truePositives += matches;
+            summary.falseNegatives += numGt - matches;
+            summary.falsePositives += numPred - matches;
+        }
+
+        /**
+         * @return metrics of all the frames added so far
+         */
+        MotSummary summarize() {
+            // IDTP: best one-to-one mapping between ground-truth ids and track ids
+            std::map<int, int> gtIndex, trackIndex;
+            int maxCoverage = 0;
+            for (auto const &[pair, count]: coverage) {
+                gtIndex.emplace(pair.first, (int) gtIndex.size());
+                trackIndex.emplace(pair.second, (int) trackIndex.size());
+                maxCoverage = std::max(maxCoverage, count);
+            }
+            summary.idTruePositives = 0;
+            if (!coverage.empty()) {
+                int rows = (int) gtIndex.size(), cols = (int) trackIndex.size();
+                cost.assign((size_t) rows * cols, (float) maxCoverage);
+                for (auto const &[pair, count]: coverage) {
+                    cost[(size_t) gtIndex[pair.first] * cols + trackIndex[pair.second]] = (float) (maxCoverage - count);
+                }
+                km.compute(cost.data(), rows, cols, assignment);
+                for (auto [i, j]: assignment) {
+                    summary.idTruePositives += maxCoverage - (long) cost[(size_t) i * cols + j];
+                }
+            }
+
+            summary.mota = summary.numGt > 0 ? 1.0 - double(summary.falseNegatives + summary.falsePositives +
+                                                            summary.idSwitches) / (double) summary.numGt : 0.0;
+            long total = summary.numGt + summary.numPredictions;
+            summary.idf1 = total > 0 ? 2.0 * (double) summary.idTruePositives / (double) total : 0.0;
+            return summary;
+        }
+
+    private:
+        static int getTrackId(cv::Mat const &predictions, int row) {
+            return (int) predictions.at<float>(row, 8);
+        }
+
+        static float getIou(float const *a, float const *b) {
+            float ix = std::min(a[0] + a[2] / 2, b[0] + b[2] / 2) - std::max(a[0] - a[2] / 2, b[0] - b[2] / 2);
+            float iy = std::min(a[1] + a[3] / 2, b[1] + b[3] / 2) - std::max(a[1] - a[3] / 2, b[1] - b[3] / 2);
+            if (ix <= 0 || iy <= 0) {
+                return 0;
+            }
+            float inter = ix * iy;
+            return inter / (a[2] * a[3] + b[2] * b[3] - inter);
+        }
+    };
+}
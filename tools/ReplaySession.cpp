@@ -0,0 +1,190 @@
+/**
+ * @desc:   deterministic replay of a session log written by SessionRecorder (see ObjectTrackerT::setRecorder).
+ *          the tracker is rebuilt from the recorded configuration, the tracker ids start where the recording
+ *          started, and every frame is timed so slow frames can be profiled in isolation.
+ *          frames dropped by the recorder leave gaps in the frame numbers; the tracks diverge from the session
+ *          from the first gap on, so the replay stops there unless --on-gap warn.
+ *          the assignment strategies recorded with every frame are forced instead of being chosen again by the cost
+ *          model, whose timings differ on this machine, so AssignmentPolicy::Approximate replays the same tracks too.
+ *              replaySession <session.log> [--timings timings.csv] [--output tracks.txt] [--top k] [--frame f]
+ *                            [--on-gap fail|warn]
+ *          --timings   per-frame timings, csv
+ *          --output    tracker output, one row per track: frame,tracker_id,xc,yc,w,h,score
+ *          --top       number of slowest frames reported (default 10)
+ *          --frame     stop right before frame f, e.g. to attach a profiler around it
+ *          --on-gap    fail (default): stop with an error at the first dropped frame; warn: report every gap and
+ *                      continue, the timings stay meaningful
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <ObjectTracking/ObjectTracker.h>
+#include <ObjectTracking/SessionLog.h>
+
+using namespace ObjectTracking;
+
+struct ReplayOptions {
+    std::string timingsPath, outputPath;
+    int top = 10;
+    int stopFrame = -1;
+    bool failOnGap = true;
+};
+
+struct FrameTiming {
+    int frame;
+    int numDetections;
+    int numTracks;
+    double totalTime, preFilterTime, predictTime, associateTime, correctTime;
+};
+
+template<class MotionModel>
+int replay(SessionReader &reader, ReplayOptions const &options) {
+    SessionConfig const &config = reader.getConfig();
+    KalmanBoxTrackerBase::setFilterCount(config.firstTrackerId);
+    // the fixed-capacity mode selects and drops detections and tracks beyond its capacity, it is replayed as well
+    auto trackerPtr = config.maxTracks > 0 ?
+                      std::make_shared<ObjectTrackerT<MotionModel>>(
+                              TrackerCapacity{config.maxTracks, config.maxDetections}, config.maxAge, config.minHits,
+                              config.iouThresh) :
+                      std::make_shared<ObjectTrackerT<MotionModel>>(config.maxAge, config.minHits, config.iouThresh);
+    ObjectTrackerT<MotionModel> &tracker = *trackerPtr;
+    if (config.hasPreFilter) {
+        tracker.setPreFilter(std::make_shared<DetectionPreFilter>(config.scoreThresh, config.nmsIouThresh,
+                                                                  config.classAware));
+    }
+    tracker.setAppearanceParams(config.appearance);
+    tracker.setDormantParams(config.dormant);
+    tracker.setCascadeParams({config.cascadeScoreThresh, config.cascadeLowIouThresh});
+    tracker.setAssignmentParams(config.assignment);
+    if (!config.assignmentCalibration.empty()) {
+        tracker.setAssignmentCalibration(config.assignmentCalibration);
+    }
+
+    std::FILE *output = options.outputPath.empty() ? nullptr : std::fopen(options.outputPath.c_str(), "w");
+    std::vector<FrameTiming> timings;
+    SessionReader::Frame frame;
+    int lastFrame = -1, numGaps = 0, firstGap = -1, status = 0;
+    while (reader.next(frame)) {
+        if (frame.frame == options.stopFrame) {
+            std::printf("stopped before frame %d\n", frame.frame);
+            break;
+        }
+        if (lastFrame >= 0 && frame.frame != lastFrame + 1) {
+            if (numGaps++ == 0) {
+                firstGap = lastFrame + 1;
+            }
+            std::fprintf(stderr, "%s: frames %d to %d were dropped by the recorder, the replay diverges from the "
+                                 "session from frame %d\n", options.failOnGap ? "error" : "warning", lastFrame + 1,
+                         frame.frame - 1, lastFrame + 1);
+            if (options.failOnGap) {
+                status = 1;
+                break;
+            }
+        }
+        lastFrame = frame.frame;
+        tracker.forceAssignmentStrategies(frame.strategies);
+        cv::Mat bboxesPost = tracker.update(frame.bboxesDet, frame.embeddings);
+        TrackerStats const &stats = tracker.getStats();
+        timings.push_back({frame.frame, stats.numInputDetections, stats.numTracks, stats.totalTime,
+                           stats.preFilterTime, stats.predictTime, stats.associateTime, stats.correctTime});
+        if (output != nullptr) {
+            for (int i = 0; i < bboxesPost.rows; ++i) {
+                float const *row = bboxesPost.ptr<float>(i);
+                std::fprintf(output, "%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f\n", frame.frame, (int) row[8], row[0], row[1],
+                             row[2], row[3], row[4]);
+            }
+        }
+    }
+    if (output != nullptr) {
+        std::fclose(output);
+    }
+    if (timings.empty()) {
+        std::printf("no frame replayed\n");
+        return status;
+    }
+
+    if (!options.timingsPath.empty()) {
+        std::FILE *csv = std::fopen(options.timingsPath.c_str(), "w");
+        if (csv != nullptr) {
+            std::fprintf(csv, "frame,detections,tracks,total_ms,prefilter_ms,predict_ms,associate_ms,correct_ms\n");
+            for (auto const &t: timings) {
+                std::fprintf(csv, "%d,%d,%d,%.4f,%.4f,%.4f,%.4f,%.4f\n", t.frame, t.numDetections, t.numTracks,
+                             t.totalTime, t.preFilterTime, t.predictTime, t.associateTime, t.correctTime);
+            }
+            std::fclose(csv);
+        }
+    }
+
+    std::vector<double> totals;
+    for (auto const &t: timings) {
+        totals.push_back(t.totalTime);
+    }
+    std::sort(totals.begin(), totals.end());
+    auto percentile = [&totals](double p) { return totals[(size_t) (p * (double) (totals.size() - 1))]; };
+    double sum = 0;
+    for (double t: totals) {
+        sum += t;
+    }
+    std::printf("model %s, %zu frames, first tracker id %d\n", config.motionModel.c_str(), timings.size(),
+                config.firstTrackerId);
+    if (numGaps > 0) {
+        std::printf("WARNING: %d gaps of dropped frames, the tracks differ from the session from frame %d\n",
+                    numGaps, firstGap);
+    }
+    std::printf("update ms: mean %.4f p50 %.4f p90 %.4f p99 %.4f max %.4f\n", sum / (double) totals.size(),
+                percentile(0.5), percentile(0.9), percentile(0.99), totals.back());
+
+    std::sort(timings.begin(), timings.end(), [](FrameTiming const &a, FrameTiming const &b) {
+        return a.totalTime > b.totalTime;
+    });
+    std::printf("slowest frames:\n");
+    for (int i = 0; i < std::min(options.top, (int) timings.size()); ++i) {
+        auto const &t = timings[i];
+        std::printf("  frame %d: %.4f ms (prefilter %.4f, predict %.4f, associate %.4f, correct %.4f), "
+                    "%d detections, %d tracks\n", t.frame, t.totalTime, t.preFilterTime, t.predictTime,
+                    t.associateTime, t.correctTime, t.numDetections, t.numTracks);
+    }
+    return status;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <session.log> [--timings timings.csv] [--output tracks.txt] [--top k] "
+                             "[--frame f] [--on-gap fail|warn]\n", argv[0]);
+        return 1;
+    }
+    ReplayOptions options;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--timings") == 0) {
+            options.timingsPath = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--output") == 0) {
+            options.outputPath = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--top") == 0) {
+            options.top = std::stoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--frame") == 0) {
+            options.stopFrame = std::stoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--on-gap") == 0) {
+            options.failOnGap = std::strcmp(argv[i + 1], "warn") != 0;
+        }
+    }
+
+    try {
+        SessionReader reader(argv[1]);
+        std::string const &model = reader.getConfig().motionModel;
+        if (model == ConstantVelocityModel::name) {
+            return replay<ConstantVelocityModel>(reader, options);
+        } else if (model == ConstantAccelerationModel::name) {
+            return replay<ConstantAccelerationModel>(reader, options);
+        } else if (model == XywhVelocityModel::name) {
+            return replay<XywhVelocityModel>(reader, options);
+        }
+        std::fprintf(stderr, "unknown motion model %s\n", model.c_str());
+    } catch (std::runtime_error const &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+    }
+    return 1;
+}
@@ -0,0 +1,105 @@
+/**
+ * @desc:   two-process check of the shared memory transport.
+ *          publisher: tracks a MOT det.txt and publishes every frame
+ *              shmTracks publish <det.txt> [name] [frame period ms]
+ *          reader: follows the published frames in place and reports missed or torn frames
+ *              shmTracks read [name] [number of frames]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include <ObjectTracking/ObjectTracker.h>
+#include <ObjectTracking/SharedMemoryTransport.h>
+#include "MotFiles.h"
+
+using namespace ObjectTracking;
+
+int publish(std::string const &detPath, std::string const &name, int periodMs) {
+    std::vector<cv::Mat> frames = mot_files::readFrames(detPath);
+    if (frames.empty()) {
+        std::fprintf(stderr, "can not read %s\n", detPath.c_str());
+        return 1;
+    }
+    ShmTrackPublisher publisher(name);
+    ObjectTracker tracker(1, 3, 0.3f);
+    for (int f = 0; f < (int) frames.size(); ++f) {
+        cv::Mat bboxesPost = tracker.update(frames[f]);
+        publisher.publish(bboxesPost, f + 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(periodMs));
+    }
+    std::printf("published %llu frames on %s\n", (unsigned long long) publisher.getPublishedCount(), name.c_str());
+    // keep the segment alive for late readers
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    return 0;
+}
+
+int read(std::string const &name, uint64_t numFrames) {
+    ShmTrackReader::Ptr reader;
+    for (int attempt = 0; reader == nullptr; ++attempt) {
+        try {
+            reader = std::make_shared<ShmTrackReader>(name);
+        } catch (std::runtime_error const &e) {
+            if (attempt == 100) {
+                std::fprintf(stderr, "%s\n", e.what());
+                return 1;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+
+    uint64_t next = 0, received = 0, missed = 0, torn = 0;
+    auto lastFrameTime = std::chrono::steady_clock::now();
+    ShmTrackReader::FrameView view;
+    while (received + missed < numFrames) {
+        uint64_t published = reader->getPublishedCount();
+        if (next >= published) {
+            if (std::chrono::steady_clock::now() - lastFrameTime > std::chrono::seconds(2)) {
+                break;  // publisher is gone
+            }
+            std::this_thread::yield();
+            continue;
+        }
+        lastFrameTime = std::chrono::steady_clock::now();
+        if (published - next > (uint64_t) reader->getNumSlots()) {
+            missed += published - (uint64_t) reader->getNumSlots() - next;
+            next = published - (uint64_t) reader->getNumSlots();
+        }
+        if (!reader->view(next, view)) {
+            missed++;
+            next++;
+            continue;
+        }
+        // consume in place, then validate
+        float area = 0;
+        for (uint32_t i = 0; i < view.numTracks; ++i) {
+            area += view.tracks[i].w * view.tracks[i].h;
+        }
+        if (!reader->isValid(view)) {
+            torn++;
+        } else {
+            received++;
+            std::printf("frame %d seq %llu tracks %u area %.1f\n", view.frame, (unsigned long long) view.sequence,
+                        view.numTracks, area);
+        }
+        next++;
+    }
+    std::printf("received %llu missed %llu torn %llu\n", (unsigned long long) received, (unsigned long long) missed,
+                (unsigned long long) torn);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 3 && std::strcmp(argv[1], "publish") == 0) {
+        return publish(argv[2], argc > 3 ? argv[3] : "/ObjectTracking", argc > 4 ? std::stoi(argv[4]) : 10);
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "read") == 0) {
+        return read(argc > 2 ? argv[2] : "/ObjectTracking", argc > 3 ? std::stoull(argv[3]) : UINT64_MAX);
+    }
+    std::fprintf(stderr, "usage: %s publish <det.txt> [name] [frame period ms] | read [name] [number of frames]\n",
+                 argv[0]);
+    return 1;
+}
@@ -0,0 +1,74 @@
+/**
+ * @desc:   offline tracking with Rauch-Tung-Striebel smoothing of whole archives (see OfflineTrackerT).
+ *          all the sequences are tracked in parallel; each smoothed result is written next to its detections.
+ *              smoothTracks [--max-age n] [--min-hits n] [--iou t] <det.txt>...
+ *          output <det.txt>.smoothed.txt, MOT rows <frame>,<id>,<left>,<top>,<width>,<height>,<score>,-1,-1,-1
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <ObjectTracking/OfflineTracker.h>
+#include "MotFiles.h"
+
+using namespace ObjectTracking;
+
+int main(int argc, char **argv) {
+    int maxAge = 1, minHits = 3;
+    float iouThresh = 0.3f;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--max-age") == 0 && i + 1 < argc) {
+            maxAge = std::stoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--min-hits") == 0 && i + 1 < argc) {
+            minHits = std::stoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--iou") == 0 && i + 1 < argc) {
+            iouThresh = std::stof(argv[++i]);
+        } else {
+            paths.emplace_back(argv[i]);
+        }
+    }
+    if (paths.empty()) {
+        std::fprintf(stderr, "usage: %s [--max-age n] [--min-hits n] [--iou t] <det.txt>...\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<std::vector<cv::Mat>> sequences;
+    for (auto const &path: paths) {
+        sequences.push_back(mot_files::readFrames(path));
+        if (sequences.back().empty()) {
+            std::fprintf(stderr, "no detections in %s\n", path.c_str());
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    OfflineTracker tracker(maxAge, minHits, iouThresh);
+    std::vector<TrackTable> tables = tracker.process(sequences);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t numFrames = 0;
+    for (size_t s = 0; s < paths.size(); ++s) {
+        numFrames += sequences[s].size();
+        TrackTable const &table = tables[s];
+        std::string outputPath = paths[s] + ".smoothed.txt";
+        std::FILE *output = std::fopen(outputPath.c_str(), "w");
+        if (output == nullptr) {
+            std::fprintf(stderr, "can not write %s\n", outputPath.c_str());
+            continue;
+        }
+        for (int i = 0; i < table.size(); ++i) {
+            std::fprintf(output, "%d,%d,%.2f,%.2f,%.2f,%.2f,%.3f,-1,-1,-1\n", table.frame[i], table.trackerId[i],
+                         table.xc[i] - table.w[i] / 2, table.yc[i] - table.h[i] / 2, table.w[i], table.h[i],
+                         table.score[i]);
+        }
+        std::fclose(output);
+        std::printf("%s: %d tracks, %d rows -> %s\n", paths[s].c_str(), table.getNumTracks(), table.size(),
+                    outputPath.c_str());
+    }
+    std::printf("%zu sequences, %zu frames in %.3f s (%.1f frames/s)\n", paths.size(), numFrames, seconds,
+                seconds > 0 ? (double) numFrames / seconds : 0.0);
+    return 0;
+}